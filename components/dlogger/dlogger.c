@@ -1,12 +1,26 @@
 #include "dlogger.h"
+#include "dlogger_port.h"
+#include "dlogger_cache.h"
+#include "dlogger_console.h"
+#include "dlogger_file.h"
+#include "dlogger_fmt.h"
+#include "dlogger_isr.h"
+#include "dlogger_metrics.h"
+#include "dlogger_ring.h"
+#include "dlogger_sink.h"
+#include "dlogger_storm.h"
+#include "dlogger_tag.h"
+#include "dlogger_tail.h"
+#include "storage_io.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
 #include <inttypes.h>
+#include <stdatomic.h>
 
+#include "esp_attr.h"
 #include "esp_log.h"
-#include "esp_heap_caps.h"
-#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -17,21 +31,103 @@
 // ============================================================================
 
 // Buffer configuration
-#define LOG_BUFFER_CAPACITY  512    // 512 entries per buffer
-#define FLUSH_INTERVAL_MS    500    // Flush every 500ms
-#define MAX_MESSAGE_LENGTH   188    // Must match struct definition
+#define LOG_RING_SIZE        (CONFIG_DLOGGER_RING_SIZE_KB * 1024)   // Bytes, power of two
+#define LOG_CORE_RINGS       DLOGGER_PORT_NUM_CORES                 // One ring per core
+#define LOG_CORE_RING_SIZE   (LOG_RING_SIZE / LOG_CORE_RINGS)
+#define MAX_MESSAGE_LENGTH   (DLOGGER_MESSAGE_MAX + 1)   // dlogger_entry_t::message
+
+// Segmented log store (Kconfig)
+#define LOG_DIR              DLOGGER_PORT_LOG_DIR
+#define LOG_LEGACY_PATH      LOG_DIR "/latest.dlog"  // Unbounded file of older builds
+#define LOG_SEGMENT_COUNT    CONFIG_DLOGGER_SEGMENT_COUNT
+#define LOG_SEGMENT_SIZE     (CONFIG_DLOGGER_SEGMENT_SIZE_KB * 1024)
+#define LOG_INDEX_ENTRIES    (LOG_SEGMENT_COUNT * ((LOG_SEGMENT_SIZE + DLOGGER_INDEX_STRIDE - 1) / \
+                                                   DLOGGER_INDEX_STRIDE))
+#ifdef CONFIG_DLOGGER_COMPRESSION
+#define LOG_COMPRESS         true    // LZ4 blocks
+#else
+#define LOG_COMPRESS         false
+#endif
+
+// Overflow handling (Kconfig)
+#define LOG_SPILL_SIZE       (CONFIG_DLOGGER_OVERFLOW_SPILL_KB * 1024)  // Shared overflow ring, 0 = none
+#define LOG_SPILL_RING       LOG_CORE_RINGS                             // Index of the overflow ring
+#define LOG_OVERFLOW_BLOCK_MS CONFIG_DLOGGER_OVERFLOW_BLOCK_MS
+#define LOG_LOW_LEVELS       (DLOGGER_LEVEL_BIT(LOG_LEVEL_INFO) | DLOGGER_LEVEL_BIT(LOG_LEVEL_DEBUG))
+#if CONFIG_DLOGGER_OVERFLOW_LEVEL_PRIORITY
+#define LOG_LOW_LEVEL_LIMIT  (LOG_CORE_RING_SIZE / 100 * CONFIG_DLOGGER_OVERFLOW_LOW_LEVEL_PCT)
+#endif
+
+// Priority lane (Kconfig): levels stored in their own ring and made durable at once
+#if CONFIG_DLOGGER_PRIORITY_LANE_WARN
+#define LOG_PRIORITY_LEVELS  (DLOGGER_LEVEL_BIT(LOG_LEVEL_ERROR) | DLOGGER_LEVEL_BIT(LOG_LEVEL_WARN))
+#elif CONFIG_DLOGGER_PRIORITY_LANE_ERROR
+#define LOG_PRIORITY_LEVELS  DLOGGER_LEVEL_BIT(LOG_LEVEL_ERROR)
+#else
+#define LOG_PRIORITY_LEVELS  0
+#endif
+#if LOG_PRIORITY_LEVELS
+#define LOG_PRIORITY_SIZE    (CONFIG_DLOGGER_PRIORITY_RING_KB * 1024)
+#define LOG_PRIORITY_WAIT_MS CONFIG_DLOGGER_PRIORITY_WAIT_MS
+#else
+#define LOG_PRIORITY_SIZE    0
+#define LOG_PRIORITY_WAIT_MS 0
+#endif
+#define LOG_PRIORITY_RING    (LOG_SPILL_RING + (LOG_SPILL_SIZE ? 1 : 0))  // Index of the lane's ring
+#define LOG_RING_COUNT       (LOG_PRIORITY_RING + (LOG_PRIORITY_SIZE ? 1 : 0))
+
+// RAM cache of flushed entries (Kconfig), in DLOGGER_CACHE_PAGE_SIZE pages
+#define LOG_CACHE_PAGES      (CONFIG_DLOGGER_CACHE_KB * 1024 / DLOGGER_CACHE_PAGE_SIZE)
+
+// Flush policy (Kconfig)
+#define FLUSH_HIGH_WATER     (LOG_RING_SIZE / 100 * CONFIG_DLOGGER_FLUSH_HIGH_WATER_PCT)
+#define RING_HIGH_WATER      (FLUSH_HIGH_WATER / LOG_CORE_RINGS)   // Per core ring
+#define FLUSH_IDLE_TIMEOUT_MS CONFIG_DLOGGER_FLUSH_IDLE_TIMEOUT_MS
+
+// Flush task notification bits
+#define FLUSH_NOTIFY_DATA        (1u << 0)  // First entry after the ring went empty
+#define FLUSH_NOTIFY_HIGH_WATER  (1u << 1)  // FLUSH_HIGH_WATER bytes pending
+#define FLUSH_NOTIFY_FORCE       (1u << 2)  // dlogger_force_flush()
+#define FLUSH_NOTIFY_STOP        (1u << 3)  // dlogger_deinit()
+#define FLUSH_NOTIFY_DURABLE     (1u << 4)  // Priority-level entry committed
+
+_Static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0,
+               "CONFIG_DLOGGER_RING_SIZE_KB must be a power of two");
+_Static_assert((LOG_CORE_RING_SIZE & (LOG_CORE_RING_SIZE - 1)) == 0,
+               "Per-core ring size must be a power of two");
+_Static_assert((LOG_SPILL_SIZE & (LOG_SPILL_SIZE - 1)) == 0,
+               "CONFIG_DLOGGER_OVERFLOW_SPILL_KB must be a power of two");
+_Static_assert((LOG_PRIORITY_SIZE & (LOG_PRIORITY_SIZE - 1)) == 0,
+               "CONFIG_DLOGGER_PRIORITY_RING_KB must be a power of two");
+_Static_assert(LOG_RING_COUNT <= sizeof(((dlogger_cursor_t *)0)->priv) / sizeof(uint32_t),
+               "dlogger_cursor_t needs one position per ring");
 
 // Internal buffer context
 typedef struct {
-    dlogger_entry_t *buffer_a;      ///< First buffer
-    dlogger_entry_t *buffer_b;      ///< Second buffer  
-    size_t capacity;                ///< Max entries per buffer
-    volatile uint8_t active;        ///< Active buffer (0=buffer_a, 1=buffer_b)
-    volatile size_t fill_idx;       ///< Entries in active buffer
-    volatile bool flush_pending;    ///< True when inactive buffer needs flushing
-    SemaphoreHandle_t mutex;        ///< Mutex for thread-safe operations
-    TaskHandle_t flush_task;        ///< Background task handle
+    dlogger_ring_t rings[LOG_RING_COUNT]; ///< One packed arena per core (no cross-core contention), then the overflow and priority rings
+    _Atomic bool high_water_signalled; ///< High-water notify sent, cleared by each drain
+    _Atomic uint32_t durable_target[LOG_RING_COUNT]; ///< Per ring: end of the last priority-level entry
+    _Atomic uint32_t durable_done[LOG_RING_COUNT];   ///< Per ring: records before this are written and synced
+    _Atomic uint32_t peak[LOG_RING_COUNT];           ///< Per ring: most bytes pending after a commit
+    _Atomic uint32_t next_seq;      ///< Sequence number of the next committed entry
+    TaskHandle_t flush_task;        ///< Background task handle (single consumer)
     volatile bool task_running;     ///< Controls background task
+    SemaphoreHandle_t span_mutex;   ///< Serializes zero-copy span readers
+    SemaphoreHandle_t store_mutex;  ///< Guards the segment store index against queries
+    
+    // Overflow counters (see dlogger_stats_t)
+    _Atomic uint32_t dropped;
+    _Atomic uint32_t evicted;
+    _Atomic uint32_t priority_dropped;
+    _Atomic uint32_t priority_evicted;
+    _Atomic uint32_t blocked;
+    _Atomic uint32_t block_timeouts;
+    _Atomic uint32_t spilled;
+    
+    // Priority lane counters (see dlogger_stats_t)
+    _Atomic uint32_t durable_syncs;
+    _Atomic uint32_t durable_failures;
+    _Atomic uint32_t durable_timeouts;
 } dlogger_buffer_ctx_t;
 
 // ============================================================================
@@ -39,19 +135,18 @@ typedef struct {
 // ============================================================================
 
 static const char *TAG = "DLOGGER";
-static char current_log_path[64] = "/storage/latest.log";
-static FILE *log_file_handle = NULL;
+static dlogger_store_t log_store;                ///< Owned by the flush task
+static dlogger_block_writer_t block_writer;     ///< Owned by the flush task
+static dlogger_cache_t log_cache;               ///< Appended by the flush task, read lock-free
+static char segment_paths[LOG_SEGMENT_COUNT][DLOGGER_SEGMENT_PATH_MAX];
 
 static dlogger_buffer_ctx_t dlogger_ctx = {
-    .buffer_a = NULL,
-    .buffer_b = NULL,
-    .capacity = LOG_BUFFER_CAPACITY,
-    .active = 0,
-    .fill_idx = 0,
-    .flush_pending = false,
-    .mutex = NULL,
+    .high_water_signalled = false,
+    .next_seq = 1,
     .flush_task = NULL,
-    .task_running = false
+    .task_running = false,
+    .span_mutex = NULL,
+    .store_mutex = NULL
 };
 
 // ============================================================================
@@ -59,7 +154,7 @@ static dlogger_buffer_ctx_t dlogger_ctx = {
 // ============================================================================
 
 /**
- * @brief Convert log source to string (for file output only)
+ * @brief Convert log source to string (for text export only)
  */
 static const char* source_to_string(uint8_t source) {
     switch(source) {
@@ -71,7 +166,7 @@ static const char* source_to_string(uint8_t source) {
 }
 
 /**
- * @brief Convert log level to character (for file output only)
+ * @brief Convert log level to character (for text export only)
  */
 static char level_to_char(uint8_t level) {
     switch(level) {
@@ -84,56 +179,160 @@ static char level_to_char(uint8_t level) {
 }
 
 /**
- * @brief Ensure log file is open (for internal file writing only)
+ * @brief Open the segment store if it is not open yet (flush task only)
+ *
+ * The first call preallocates missing segments, so it runs on the flush
+ * task rather than in dlogger_init().
  */
-static void ensure_log_file_open(void) {
-    if (log_file_handle == NULL) {
-        log_file_handle = fopen(current_log_path, "a");
-        if (log_file_handle) {
-            setvbuf(log_file_handle, NULL, _IOFBF, 4096);
-        }
+static bool ensure_log_store_open(void) {
+    if (log_store.file) return true;
+    
+    esp_err_t ret = dlogger_store_open(&log_store, LOG_DIR, LOG_SEGMENT_COUNT, LOG_SEGMENT_SIZE);
+    if (ret != ESP_OK) {
+        dlogger_store_close(&log_store);
+        return false;
     }
+    return true;
 }
 
 /**
- * @brief Close log file
+ * @brief Seal and write the pending block (internal use only)
  */
-static void close_log_file(void) {
-    if (log_file_handle) {
-        fclose(log_file_handle);
-        log_file_handle = NULL;
+static void write_block_to_file(void) {
+    if (block_writer.count == 0) return;
+    
+    xSemaphoreTake(dlogger_ctx.store_mutex, portMAX_DELAY);
+    uint32_t failures = dlogger_store_take_failures(&log_store);
+    if (failures) {
+        // A queued block did not make it: reopen after the last intact one
+        dlogger_store_close(&log_store);
+        for (uint32_t i = 0; i < failures; i++) {
+            dlogger_metrics_write_error();
+        }
     }
+    if (ensure_log_store_open()) {
+        if (dlogger_store_write(&log_store, &block_writer) != ESP_OK) {
+            dlogger_metrics_write_error();
+        }
+    } else {
+        // Block is dropped; the store is reopened on the next flush
+        dlogger_block_reset(&block_writer);
+        dlogger_metrics_write_error();
+    }
+    xSemaphoreGive(dlogger_ctx.store_mutex);
 }
 
 /**
- * @brief Write single entry to file (internal use only)
+ * @brief Queue single record for the file and the cache (flush task only)
+ *
+ * @param ring Index of the core ring the record is consumed from
+ * @param pos Ring position of the record
  */
-static void write_entry_to_file(const dlogger_entry_t *entry) {
-    ensure_log_file_open();
-    if (!log_file_handle || !entry) return;
+static void write_record_to_file(const dlogger_rec_t *rec, uint32_t ring, uint32_t pos) {
+    if (!block_writer.buf) return;
     
-    fprintf(log_file_handle, "%" PRIu32 " [%s][%c] %s\n",
-            entry->timestamp,
-            source_to_string(entry->source),
-            level_to_char(entry->level),
-            entry->message);
+    const char *message = dlogger_rec_message(rec);
+    size_t length = rec->length;
+    uint8_t level = rec->level & DLOGGER_REC_LEVEL_MASK;
     
-    fflush(log_file_handle);
+    // Deferred and tagged records become text here, off the logging task
+    char rendered[MAX_MESSAGE_LENGTH];
+    if (rec->level & DLOGGER_REC_FLAG_RENDER) {
+        length = dlogger_rec_render(rec, rendered, sizeof(rendered));
+        message = rendered;
+    }
+    
+    // Readers find the entry here once producers reclaim its ring space,
+    // whether or not its block has reached flash yet
+    dlogger_cache_append(&log_cache, ring, pos, dlogger_rec_seq(rec), rec->timestamp,
+                         rec->source, level, message, length);
+    
+    uint32_t seq = dlogger_rec_seq(rec);
+    if (!dlogger_block_append(&block_writer, rec->timestamp, seq, rec->source, level,
+                              message, length)) {
+        write_block_to_file();
+        dlogger_block_append(&block_writer, rec->timestamp, seq, rec->source, level,
+                             message, length);
+    }
 }
 
 /**
- * @brief Flush buffer to file (internal use only)
+ * @brief Crash tail recovery state
  */
-static void flush_buffer_to_file(dlogger_entry_t *buffer, size_t count) {
-    if (!buffer || count == 0) return;
+typedef struct {
+    uint32_t first;          ///< Sequence number of bit 0 of `written`
+    uint32_t count;          ///< Bits in `written`
+    uint8_t *written;        ///< Bit per sequence number that reached the log, NULL = none did
+    size_t recovered;
+} tail_recovery_t;
+
+/**
+ * @brief Queue one entry of the last run's crash tail (tail callback)
+ */
+static bool tail_recover_entry(const dlogger_entry_t *entry, uint32_t seq, void *user_ctx) {
+    tail_recovery_t *recovery = (tail_recovery_t *)user_ctx;
+    uint32_t bit = seq - recovery->first;
+    if (recovery->written && bit < recovery->count &&
+        (recovery->written[bit / 8] & (1u << (bit % 8)))) {
+        return true;
+    }
     
-    for (size_t i = 0; i < count; i++) {
-        if (buffer[i].timestamp != 0) {
-            write_entry_to_file(&buffer[i]);
+    // Recovered entries belong to no sequence of this run
+    size_t length = strlen(entry->message);
+    if (!dlogger_block_append(&block_writer, entry->timestamp, 0, entry->source, entry->level,
+                              entry->message, length)) {
+        write_block_to_file();
+        dlogger_block_append(&block_writer, entry->timestamp, 0, entry->source, entry->level,
+                             entry->message, length);
+    }
+    recovery->recovered++;
+    return true;
+}
+
+/**
+ * @brief Write what the last run left in the crash tail to the log and
+ *        start this run's tail (init only, before any entry is logged)
+ *
+ * The entries that run wrote to the store since it started are found by
+ * their sequence numbers and skipped, so whatever shares a millisecond
+ * with them, or sat in another ring, is still recovered.
+ *
+ * @return Number of entries recovered
+ */
+static size_t tail_recover_to_log(void) {
+    if (dlogger_tail_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Crash tail memory unavailable, entries are not mirrored");
+        return 0;
+    }
+    
+    tail_recovery_t recovery = { 0 };
+    uint32_t sequence, offset;
+    xSemaphoreTake(dlogger_ctx.store_mutex, portMAX_DELAY);
+    bool open = ensure_log_store_open();
+    if (open && dlogger_tail_origin(&sequence, &offset) &&
+        dlogger_tail_seq_range(&recovery.first, &recovery.count)) {
+        // Without the map every entry is written again: duplicates, not losses
+        recovery.written = (uint8_t*)calloc((recovery.count + 7) / 8, 1);
+        if (recovery.written) {
+            dlogger_store_mark_written(&log_store, sequence, offset, recovery.first,
+                                       recovery.count, recovery.written);
         }
     }
+    xSemaphoreGive(dlogger_ctx.store_mutex);
     
-    memset(buffer, 0, count * sizeof(dlogger_entry_t));
+    if (open) {
+        dlogger_tail_recover(tail_recover_entry, &recovery);
+        write_block_to_file();
+    }
+    free(recovery.written);
+    
+    xSemaphoreTake(dlogger_ctx.store_mutex, portMAX_DELAY);
+    if (recovery.recovered > 0) {
+        dlogger_store_sync(&log_store);
+    }
+    dlogger_tail_start(log_store.sequence, log_store.offset);
+    xSemaphoreGive(dlogger_ctx.store_mutex);
+    return recovery.recovered;
 }
 
 // ============================================================================
@@ -141,80 +340,669 @@ static void flush_buffer_to_file(dlogger_entry_t *buffer, size_t count) {
 // ============================================================================
 
 /**
- * @brief Background flush task function
+ * @brief Unflushed bytes across all core rings
  */
-static void flush_task_func(void *arg) {
-    while (dlogger_ctx.task_running) {
-        bool should_flush = false;
-        dlogger_entry_t *buffer_to_flush = NULL;
-        size_t entries_to_flush = 0;
-        
-        // Check if flush is needed
-        xSemaphoreTake(dlogger_ctx.mutex, portMAX_DELAY);
-        if (dlogger_ctx.flush_pending) {
-            uint8_t buffer_to_flush_idx = !dlogger_ctx.active;
-            buffer_to_flush = (buffer_to_flush_idx == 0) ? 
-                             dlogger_ctx.buffer_a : dlogger_ctx.buffer_b;
-            entries_to_flush = dlogger_ctx.capacity;
-            should_flush = true;
-            dlogger_ctx.flush_pending = false;
-        }
-        xSemaphoreGive(dlogger_ctx.mutex);
-        
-        // Perform flush if needed
-        if (should_flush) {
-            flush_buffer_to_file(buffer_to_flush, entries_to_flush);
+static uint32_t buffer_pending(void) {
+    uint32_t pending = 0;
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        pending += dlogger_ring_pending(&dlogger_ctx.rings[i]);
+    }
+    return pending;
+}
+
+/**
+ * @brief Drain every committed record to the log file (flush task only)
+ *
+ * The per-core rings (and the overflow ring) are merged on their oldest
+ * records by timestamp, so the file holds one time-ordered stream. Within
+ * a ring the drain stops at the first record that is not committed yet.
+ * Records are packed into binary blocks; a block is written when it fills
+ * and once more at the end of the drain.
+ *
+ * @return Number of entries written
+ */
+static size_t ring_drain_to_file(void) {
+    size_t drained = 0;
+    uint32_t cache_page = atomic_load_explicit(&log_cache.newest, memory_order_relaxed);
+
+    for (;;) {
+        int oldest = -1;
+        const dlogger_rec_t *rec = NULL;
+        for (int i = 0; i < LOG_RING_COUNT; i++) {
+            const dlogger_rec_t *r = dlogger_ring_peek(&dlogger_ctx.rings[i]);
+            if (r && (!rec || dlogger_entry_after(rec->timestamp, dlogger_rec_seq(rec),
+                                                  r->timestamp, dlogger_rec_seq(r)))) {
+                rec = r;
+                oldest = i;
+            }
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(FLUSH_INTERVAL_MS));
+        if (!rec) break;
+
+        // Write a full block before claiming the record: a producer cannot
+        // evict past a claimed record, so none is held during the write
+        size_t bound = (rec->level & DLOGGER_REC_FLAG_RENDER) ? MAX_MESSAGE_LENGTH : rec->length;
+        if (!dlogger_block_fits(&block_writer, bound)) {
+            write_block_to_file();
+            continue;   // Producers may have evicted or added records meanwhile
+        }
+
+        dlogger_ring_t *ring = &dlogger_ctx.rings[oldest];
+        if (!dlogger_ring_take(ring)) {
+            continue;   // Evicted by a producer since the peek
+        }
+        write_record_to_file(rec, (uint32_t)oldest, dlogger_ring_peek_pos(ring));
+        dlogger_ring_consume(ring);
+        drained++;
+
+        // Sinks read the cache: wake them per page, not only after a long drain
+        uint32_t page = atomic_load_explicit(&log_cache.newest, memory_order_relaxed);
+        if (page != cache_page) {
+            cache_page = page;
+            dlogger_sink_notify();
+        }
+    }
+
+    // One write per block instead of one fprintf + fflush per entry
+    write_block_to_file();
+    return drained;
+}
+
+/**
+ * @brief Arena size of ring `index`: core rings, then the overflow and
+ *        priority rings
+ */
+static uint32_t buffer_ring_size(int index) {
+    if (index < LOG_CORE_RINGS) return LOG_CORE_RING_SIZE;
+    if (LOG_SPILL_SIZE && index == LOG_SPILL_RING) return LOG_SPILL_SIZE;
+    return LOG_PRIORITY_SIZE;
+}
+
+/**
+ * @brief Free every ring
+ */
+static void buffer_rings_deinit(void) {
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        dlogger_ring_deinit(&dlogger_ctx.rings[i]);
+    }
+}
+
+/**
+ * @brief Delete the reader/store mutexes
+ */
+static void buffer_mutexes_deinit(void) {
+    if (dlogger_ctx.span_mutex) {
+        vSemaphoreDelete(dlogger_ctx.span_mutex);
+        dlogger_ctx.span_mutex = NULL;
+    }
+    if (dlogger_ctx.store_mutex) {
+        vSemaphoreDelete(dlogger_ctx.store_mutex);
+        dlogger_ctx.store_mutex = NULL;
+    }
+}
+
+/**
+ * @brief Notify the flush task (no-op before init / after deinit)
+ */
+static inline void flush_task_notify(uint32_t bits) {
+    TaskHandle_t task = dlogger_ctx.flush_task;
+    if (task) {
+        xTaskNotify(task, bits, eSetBits);
+    }
+}
+
+/**
+ * @brief Whether the calling producer may wait for the flush task
+ *
+ * Never in an interrupt, before the scheduler runs, on the flush task (it
+ * is the one being waited for) or on the storage I/O task (the flush task's
+ * writes and syncs wait for it, e.g. an error it logs from a callback).
+ */
+static inline bool producer_may_wait(void) {
+    return !dlogger_port_in_isr() &&
+           xTaskGetSchedulerState() == taskSCHEDULER_RUNNING &&
+           dlogger_ctx.flush_task != NULL &&
+           xTaskGetCurrentTaskHandle() != dlogger_ctx.flush_task &&
+           !storage_io_in_service_task();
+}
+
+/**
+ * @brief Raise ring `index`'s durable target to `end` (never lowers it)
+ */
+static inline void buffer_raise_durable(int index, uint32_t end) {
+    _Atomic uint32_t *target = &dlogger_ctx.durable_target[index];
+    uint32_t current = atomic_load_explicit(target, memory_order_relaxed);
+    while ((int32_t)(end - current) > 0 &&
+           !atomic_compare_exchange_weak_explicit(target, &current, end,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Have a priority-level entry written and synced right away
+ *
+ * Raises the ring's durable target to the entry's end (`end`) and wakes
+ * the flush task; the caller returns at once. Only with
+ * CONFIG_DLOGGER_PRIORITY_WAIT_MS (off by default) does it then wait
+ * until the flush task has synced a drain that got past it.
+ */
+static void buffer_request_durable(dlogger_ring_t *ring, uint32_t end) {
+    int index = (int)(ring - dlogger_ctx.rings);
+    buffer_raise_durable(index, end);
+    flush_task_notify(FLUSH_NOTIFY_DURABLE);
+
+#if LOG_PRIORITY_WAIT_MS > 0
+    if (!producer_may_wait()) return;
+    _Atomic uint32_t *done = &dlogger_ctx.durable_done[index];
+    TickType_t start = xTaskGetTickCount();
+    while ((int32_t)(atomic_load_explicit(done, memory_order_acquire) - end) < 0) {
+        if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(LOG_PRIORITY_WAIT_MS)) {
+            atomic_fetch_add_explicit(&dlogger_ctx.durable_timeouts, 1, memory_order_relaxed);
+            return;
+        }
+        vTaskDelay(1);
+    }
+#endif
+}
+
+/**
+ * @brief Whether a priority-level entry waits for a synced drain
+ */
+static bool buffer_durable_outstanding(void) {
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        if ((int32_t)(atomic_load_explicit(&dlogger_ctx.durable_target[i], memory_order_acquire) -
+                      atomic_load_explicit(&dlogger_ctx.durable_done[i], memory_order_relaxed)) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Raise the ring's high-water mark to `pending` bytes
+ */
+static inline void buffer_track_peak(dlogger_ring_t *ring, uint32_t pending) {
+    _Atomic uint32_t *peak = &dlogger_ctx.peak[ring - dlogger_ctx.rings];
+    uint32_t seen = atomic_load_explicit(peak, memory_order_relaxed);
+    while (pending > seen &&
+           !atomic_compare_exchange_weak_explicit(peak, &seen, pending, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+#if DLOGGER_TAIL_SIZE
+/**
+ * @brief Copy a filled record into the crash tail, as stored
+ *
+ * Nothing is formatted here: deferred records keep their capture, and a
+ * tagged record's id is swapped for the tag name, which outlives the reset.
+ */
+static void tail_mirror(const dlogger_rec_t *rec) {
+    const char *payload = dlogger_rec_message(rec);
+    size_t length = rec->length;
+    const char *tag = NULL;
+    if ((rec->level & DLOGGER_REC_FLAG_TAGGED) && length > 0) {
+        tag = dlogger_tag_name((uint8_t)payload[0]);
+        if (!tag) tag = "?";
+        payload++;
+        length--;
+    }
+    dlogger_tail_append(rec->timestamp, dlogger_rec_seq(rec), rec->source, rec->level, tag,
+                        payload, length);
+}
+#endif
+
+/**
+ * @brief Publish a filled reservation and wake the flush task if needed
+ *
+ * Priority-level entries (CONFIG_DLOGGER_PRIORITY_LANE) are made durable
+ * at once, whichever ring holds them.
+ */
+static void buffer_commit(dlogger_ring_t *ring, const dlogger_ring_resv_t *resv) {
+    // Number entries in commit order (padding from a discarded reservation has none)
+    if (resv->rec->source != DLOGGER_REC_PAD) {
+        dlogger_rec_set_seq(resv->rec, atomic_fetch_add_explicit(&dlogger_ctx.next_seq, 1,
+                                                                 memory_order_relaxed));
+        dlogger_metrics_stored(resv->rec->source, resv->rec->level & DLOGGER_REC_LEVEL_MASK);
+#if DLOGGER_TAIL_SIZE
+        tail_mirror(resv->rec);
+#endif
     }
     
-    vTaskDelete(NULL);
+    // Commit: publish the payload to the flush task and readers
+    bool durable = resv->rec->source != DLOGGER_REC_PAD &&
+                   (DLOGGER_LEVEL_BIT(resv->rec->level & DLOGGER_REC_LEVEL_MASK) &
+                    LOG_PRIORITY_LEVELS);
+    uint32_t pending = dlogger_ring_commit(ring, resv);
+    buffer_track_peak(ring, pending);
+    if (durable) {
+        buffer_request_durable(ring, resv->end);
+        return;
+    }
+    
+    // Wake the flush task on the empty -> non-empty edge and once when the
+    // high-water mark is crossed; all other commits are notification free
+    if (pending == resv->end - resv->start) {
+        flush_task_notify(FLUSH_NOTIFY_DATA);
+    } else if (pending >= RING_HIGH_WATER &&
+               !atomic_exchange_explicit(&dlogger_ctx.high_water_signalled, true,
+                                         memory_order_relaxed)) {
+        flush_task_notify(FLUSH_NOTIFY_HIGH_WATER);
+    }
 }
 
 /**
- * @brief Add entry to active buffer (thread-safe)
+ * @brief Reserve room for a record, applying the overflow policy
+ *
+ * Priority levels (CONFIG_DLOGGER_PRIORITY_LANE) try the priority ring
+ * first. Then the calling core's ring, the overflow ring, eviction
+ * (DROP_OLDEST / LEVEL_PRIORITY) and finally waits for the flush task
+ * (CONFIG_DLOGGER_OVERFLOW_BLOCK_MS, DEBUG/INFO only). Lock-free unless
+ * the caller waits.
+ *
+ * @param level dlogger_level_t of the entry (flags are ignored)
+ * @return Index of the ring holding the reservation, or -1 if the entry is dropped
  */
-static bool buffer_add_entry(uint8_t source, uint8_t level, const char *message) {
-    bool success = false;
+static int buffer_reserve(uint8_t level, size_t length, dlogger_ring_resv_t *resv) {
+    int core = (int)dlogger_port_core_id();
+    dlogger_ring_t *ring = &dlogger_ctx.rings[core];
+    if (!ring->buf) return -1;
     
-    xSemaphoreTake(dlogger_ctx.mutex, portMAX_DELAY);
+#if LOG_PRIORITY_SIZE
+    // Priority levels have their own ring, which DEBUG/INFO floods cannot fill
+    if ((DLOGGER_LEVEL_BIT(level & DLOGGER_REC_LEVEL_MASK) & LOG_PRIORITY_LEVELS) &&
+        dlogger_ring_reserve(&dlogger_ctx.rings[LOG_PRIORITY_RING], length, resv)) {
+        return LOG_PRIORITY_RING;
+    }
+#endif
     
-    // Check if buffer is full
-    if (dlogger_ctx.fill_idx >= dlogger_ctx.capacity) {
-        if (dlogger_ctx.flush_pending) {
-            // Both buffers busy - drop entry
-            success = false;
-        } else {
-            // Swap buffers
-            dlogger_ctx.active = !dlogger_ctx.active;
-            dlogger_ctx.fill_idx = 0;
-            dlogger_ctx.flush_pending = true;
-            success = true;
+    bool low = (DLOGGER_LEVEL_BIT(level & DLOGGER_REC_LEVEL_MASK) & LOG_LOW_LEVELS) != 0;
+    (void)low;      // Not every policy looks at the level
+#if CONFIG_DLOGGER_OVERFLOW_LEVEL_PRIORITY
+    // DEBUG/INFO stop short of the share kept for WARN/ERROR
+    bool admitted = !low || dlogger_ring_pending(ring) < LOG_LOW_LEVEL_LIMIT;
+#else
+    bool admitted = true;
+#endif
+    if (admitted && dlogger_ring_reserve(ring, length, resv)) {
+        return core;
+    }
+    
+#if LOG_SPILL_SIZE
+    if (dlogger_ring_reserve(&dlogger_ctx.rings[LOG_SPILL_RING], length, resv)) {
+        atomic_fetch_add_explicit(&dlogger_ctx.spilled, 1, memory_order_relaxed);
+        return LOG_SPILL_RING;
+    }
+#endif
+    
+    // Make room by evicting the oldest unflushed entries
+#if CONFIG_DLOGGER_OVERFLOW_DROP_OLDEST
+    uint32_t evictable = DLOGGER_MASK_ALL;
+    _Atomic uint32_t *evict_count = &dlogger_ctx.evicted;
+#elif CONFIG_DLOGGER_OVERFLOW_LEVEL_PRIORITY
+    uint32_t evictable = low ? 0 : LOG_LOW_LEVELS;
+    _Atomic uint32_t *evict_count = &dlogger_ctx.priority_evicted;
+#else
+    uint32_t evictable = 0;
+    _Atomic uint32_t *evict_count = NULL;
+#endif
+    if (admitted && evictable) {
+        int r;
+        while ((r = dlogger_ring_evict(ring, evictable)) != 0) {
+            if (r > 0) {
+                atomic_fetch_add_explicit(evict_count, 1, memory_order_relaxed);
+            }
+            if (dlogger_ring_reserve(ring, length, resv)) {
+                return core;
+            }
         }
-    } else {
-        success = true;
     }
     
-    // Add entry if we have space
-    if (success) {
-        dlogger_entry_t *active_buffer = (dlogger_ctx.active == 0) ? 
-                                        dlogger_ctx.buffer_a : dlogger_ctx.buffer_b;
-        
-        dlogger_entry_t *entry = &active_buffer[dlogger_ctx.fill_idx];
-        entry->timestamp = (uint32_t)(esp_timer_get_time() / 1000);
-        entry->source = source;
-        entry->level = level;
+#if LOG_OVERFLOW_BLOCK_MS > 0
+    // Non-critical producers wait for the flush task to make room
+    if (low && producer_may_wait()) {
+        atomic_fetch_add_explicit(&dlogger_ctx.blocked, 1, memory_order_relaxed);
+        flush_task_notify(FLUSH_NOTIFY_FORCE);
+        TickType_t start = xTaskGetTickCount();
+        do {
+            vTaskDelay(1);
+#if CONFIG_DLOGGER_OVERFLOW_LEVEL_PRIORITY
+            admitted = dlogger_ring_pending(ring) < LOG_LOW_LEVEL_LIMIT;
+#endif
+            if (admitted && dlogger_ring_reserve(ring, length, resv)) {
+                return core;
+            }
+        } while (xTaskGetTickCount() - start < pdMS_TO_TICKS(LOG_OVERFLOW_BLOCK_MS));
+        atomic_fetch_add_explicit(&dlogger_ctx.block_timeouts, 1, memory_order_relaxed);
+    }
+#endif
+    
+    // Drop the new entry (the flush task is already notified)
+    atomic_fetch_add_explicit(admitted ? &dlogger_ctx.dropped : &dlogger_ctx.priority_dropped, 1,
+                              memory_order_relaxed);
+    return -1;
+}
+
+/**
+ * @brief Add a record to the ring (lock-free unless the overflow policy waits)
+ *
+ * Safe to call concurrently from tasks on both cores. Only the payload
+ * bytes are stored (no fixed 188-byte slot). Returns false when the
+ * overflow policy drops the entry.
+ */
+static bool buffer_add_record(uint32_t timestamp, uint8_t source, uint8_t level,
+                              const void *payload, size_t length) {
+    uint32_t begin = dlogger_metrics_enqueue_begin();
+    dlogger_ring_resv_t resv;
+    int index = buffer_reserve(level, length, &resv);
+    if (index < 0) {
+        dlogger_metrics_dropped(source, level & DLOGGER_REC_LEVEL_MASK);
+        dlogger_metrics_enqueue_end(begin);
+        return false;
+    }
+    dlogger_ring_t *ring = &dlogger_ctx.rings[index];
+
+    resv.rec->timestamp = timestamp;
+    resv.rec->length = (uint16_t)length;
+    resv.rec->source = source;
+    resv.rec->level = level;
+    memcpy(dlogger_rec_message(resv.rec), payload, length);
+
+    buffer_commit(ring, &resv);
+    dlogger_metrics_enqueue_end(begin);
+    return true;
+}
+
+// ============================================================================
+// STORM SUPPRESSION
+// ============================================================================
+
+/**
+ * @brief Store a "repeated N times" record for a suppressed storm
+ */
+static void storm_emit_summary(const dlogger_storm_summary_t *summary, void *user_ctx) {
+    char text[DLOGGER_STORM_TEXT_MAX + 32];
+    int length = summary->length ?
+        snprintf(text, sizeof(text), "%.*s [repeated %" PRIu32 " times]",
+                 (int)summary->length, summary->text, summary->count) :
+        snprintf(text, sizeof(text), "[repeated %" PRIu32 " times]", summary->count);
+    if (length >= (int)sizeof(text)) length = sizeof(text) - 1;
+    buffer_add_record(dlogger_port_time_ms(), summary->source, summary->level, text, (size_t)length);
+}
+
+/**
+ * @brief Start of the message proper of a rendered ESP log line
+ *
+ * Skips "X (timestamp) " (and a color sequence) so repeats of a line hash
+ * the same; returns `text` unchanged if it is not in that format. Only the
+ * first `length` bytes are looked at, so the result is never past them.
+ */
+static const char *esp_text_body(const char *text, size_t length) {
+    const char *end = text + length;
+    const char *p = text;
+    if (length >= 2 && p[0] == '\033' && p[1] == '[') {
+        p = memchr(p, 'm', length);
+        if (!p) return text;
+        p++;
+    }
+    if (end - p < 3 || p[1] != ' ' || p[2] != '(') return text;
+    for (p += 3; end - p >= 2; p++) {
+        if (p[0] == ')' && p[1] == ' ') return p + 2;
+    }
+    return text;
+}
+
+/**
+ * @brief Coarse clock of the storm table (a tick read; record timestamps
+ *        are still taken right before the reservation)
+ */
+static inline uint32_t storm_now(void) {
+    return pdTICKS_TO_MS(xTaskGetTickCount());
+}
+
+/**
+ * @brief Run an entry through the storm table before it is stored
+ *
+ * @param level dlogger_level_t | DLOGGER_REC_FLAG_* of the record to store
+ * @param payload Its message bytes (text unless flagged)
+ * @return true if the entry is suppressed (counted, not stored)
+ */
+static bool storm_suppress(uint32_t key, uint8_t source, uint8_t level,
+                           const void *payload, size_t length) {
+    dlogger_storm_summary_t summary;
+    dlogger_storm_verdict_t verdict = dlogger_storm_check(key, source,
+                                                          level & DLOGGER_REC_LEVEL_MASK,
+                                                          storm_now(), &summary);
+    if (summary.count) {
+        storm_emit_summary(&summary, NULL);
+    }
+    if (verdict == DLOGGER_STORM_PASS) return false;
+
+    if (verdict == DLOGGER_STORM_SUPPRESS_TEXT) {
+        // Once per key: the summary quotes the start of the message
+        char text[DLOGGER_STORM_TEXT_MAX + 1];
+        if (level & DLOGGER_REC_FLAG_RENDER) {
+            dlogger_rec_t hdr = {
+                .timestamp = dlogger_port_time_ms(),
+                .length = (uint16_t)length,
+                .source = source,
+                .level = level,
+            };
+            length = dlogger_payload_render(&hdr, payload, text, sizeof(text));
+            payload = text;
+        }
+        // ESP lines end with a newline; the summary appends to the text
+        const char *str = (const char *)payload;
+        if (length > DLOGGER_STORM_TEXT_MAX) length = DLOGGER_STORM_TEXT_MAX;
+        while (length > 0 && (str[length - 1] == '\n' || str[length - 1] == '\r')) {
+            length--;
+        }
+        dlogger_storm_set_text(key, str, length);
+    }
+    return true;
+}
+
+/**
+ * @brief Add a preformatted text entry to the ring
+ */
+static bool buffer_add_entry(uint8_t source, uint8_t level, const char *message) {
+    if (!message) return false;
+
+    size_t length = strnlen(message, MAX_MESSAGE_LENGTH - 1);
+    const char *body = (source == LOG_SOURCE_ESP) ? esp_text_body(message, length) : message;
+    uint32_t key = dlogger_storm_hash(dlogger_storm_key(source, level), body,
+                                      length - (size_t)(body - message));
+    if (storm_suppress(key, source, level, message, length)) {
+        return true;
+    }
+    if (!buffer_add_record(dlogger_port_time_ms(), source, level, message, length)) {
+        dlogger_storm_refund(key);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Add an ESP log line as a tagged record
+ *
+ * @param payload dlogger_tag id, then the message after the "X (time) TAG: "
+ *                prefix (rebuilt when the record is rendered)
+ */
+static bool buffer_add_tagged(uint8_t level, const char *payload, size_t length) {
+    if (length > MAX_MESSAGE_LENGTH - 1) length = MAX_MESSAGE_LENGTH - 1;
+
+    uint32_t key = dlogger_storm_hash(dlogger_storm_key(LOG_SOURCE_ESP, level), payload, length);
+    if (storm_suppress(key, LOG_SOURCE_ESP, level | DLOGGER_REC_FLAG_TAGGED, payload, length)) {
+        return true;
+    }
+    if (!buffer_add_record(dlogger_port_time_ms(), LOG_SOURCE_ESP, level | DLOGGER_REC_FLAG_TAGGED,
+                           payload, length)) {
+        dlogger_storm_refund(key);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a printf-style entry to the ring
+ *
+ * With CONFIG_DLOGGER_DEFERRED_FORMAT the format address and raw arguments
+ * are stored and the text is produced by whoever reads the record; formats
+ * that cannot be deferred (see dlogger_fmt_capture) are formatted here.
+ */
+static bool buffer_add_formatted(uint8_t source, uint8_t level, const char *format, va_list args) {
+    if (!format) return false;
+
+#if CONFIG_DLOGGER_DEFERRED_FORMAT
+    uint8_t payload[DLOGGER_FMT_MAX_PAYLOAD];
+    va_list args_copy;
+    va_copy(args_copy, args);
+    size_t length = dlogger_fmt_capture(payload, sizeof(payload), format, args_copy);
+    va_end(args_copy);
+    
+    if (length > 0) {
+        // Repeats are recognized before any text is produced: the payload
+        // is the format address plus the arguments
+        uint32_t key = dlogger_storm_hash(dlogger_storm_key(source, level), payload, length);
+        if (storm_suppress(key, source, level | DLOGGER_REC_FLAG_DEFERRED, payload, length)) {
+            return true;
+        }
+        if (!buffer_add_record(dlogger_port_time_ms(), source, level | DLOGGER_REC_FLAG_DEFERRED,
+                               payload, length)) {
+            dlogger_storm_refund(key);
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    char message[MAX_MESSAGE_LENGTH];
+    vsnprintf(message, sizeof(message), format, args);
+    return buffer_add_entry(source, level, message);
+}
+
+/**
+ * @brief Copy one staged ISR entry into the main ring (import callback)
+ */
+static bool import_isr_slot(const dlogger_isr_slot_t *slot, void *user_ctx) {
+    return buffer_add_record(slot->timestamp, slot->source, slot->level,
+                             slot->message, slot->length);
+}
+
+/**
+ * @brief Move staged ISR entries into the main ring (flush task only)
+ *
+ * Entries keep their interrupt-time timestamps and are merged across cores
+ * in timestamp order. If the main ring is full they stay staged.
+ */
+static size_t import_isr_entries(void) {
+    return dlogger_isr_import(import_isr_slot, NULL);
+}
+
+/**
+ * @brief Sync the drained records to flash and release their waiters
+ *        (flush task only)
+ *
+ * A failed sync releases them too (they count it); the entries are only
+ * as safe as the store then.
+ *
+ * @return true if no priority-level entry is left behind, false if the
+ *         drain stopped at a record still being filled before one
+ */
+static bool flush_sync_durable(void) {
+    uint32_t tails[LOG_RING_COUNT];
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        tails[i] = dlogger_ring_tail(&dlogger_ctx.rings[i]);
+    }
+
+    xSemaphoreTake(dlogger_ctx.store_mutex, portMAX_DELAY);
+    esp_err_t ret = dlogger_store_sync(&log_store);
+    xSemaphoreGive(dlogger_ctx.store_mutex);
+    atomic_fetch_add_explicit((ret == ESP_OK) ? &dlogger_ctx.durable_syncs
+                                              : &dlogger_ctx.durable_failures,
+                              1, memory_order_relaxed);
+
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        atomic_store_explicit(&dlogger_ctx.durable_done[i], tails[i], memory_order_release);
+    }
+    return !buffer_durable_outstanding();
+}
+
+/**
+ * @brief Background flush task function
+ *
+ * Event driven: sleeps without a timeout while the ring is empty, is woken
+ * by the first entry after a drain (or the first staged ISR entry), and then drains as soon as the
+ * high-water mark is crossed (or a flush is forced), or after
+ * FLUSH_IDLE_TIMEOUT_MS for a partially filled ring. While a storm window
+ * is open it also wakes when the window ends, to store its summary.
+ * A priority-level entry is drained and synced at once.
+ */
+static void flush_task_func(void *arg) {
+    xSemaphoreTake(dlogger_ctx.store_mutex, portMAX_DELAY);
+    ensure_log_store_open();
+    xSemaphoreGive(dlogger_ctx.store_mutex);
+    
+    bool durable_retry = false;
+    while (dlogger_ctx.task_running) {
+        // Staged ISR entries join the main stream on every wakeup
+        import_isr_entries();
         
-        // Copy message with null termination
-        strncpy(entry->message, message, MAX_MESSAGE_LENGTH - 1);
-        entry->message[MAX_MESSAGE_LENGTH - 1] = '\0';
+        // Storms that ended leave their "repeated N times" record
+        uint32_t storm_next = dlogger_storm_sweep(storm_now(), false,
+                                                  storm_emit_summary, NULL);
         
-        dlogger_ctx.fill_idx++;
+        uint32_t pending = buffer_pending();
+        uint32_t bits = 0;
+        bool durable = buffer_durable_outstanding();
+
+        if (pending == 0 && !durable) {
+            // Nothing reserved: no idle wakeups until a producer notifies
+            // (or an open storm window ends)
+            TickType_t wait = (storm_next == UINT32_MAX) ? portMAX_DELAY
+                                                         : pdMS_TO_TICKS(storm_next) + 1;
+            xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+            continue;
+        }
+
+        if (durable) {
+            // Drain now; a retry (the last drain stopped at a record still
+            // being filled) gives its producer a tick first
+            if (durable_retry) vTaskDelay(1);
+        } else if (pending < FLUSH_HIGH_WATER &&
+                   !atomic_load_explicit(&dlogger_ctx.high_water_signalled, memory_order_relaxed)) {
+            // Partially filled: give the batch time to grow. A high-water
+            // notify already consumed by another wait still counts (the
+            // flag stays set until the drain), or one ring could fill up
+            if (xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(FLUSH_IDLE_TIMEOUT_MS)) == pdTRUE &&
+                !(bits & (FLUSH_NOTIFY_HIGH_WATER | FLUSH_NOTIFY_FORCE | FLUSH_NOTIFY_STOP |
+                          FLUSH_NOTIFY_DURABLE))) {
+                continue;
+            }
+        }
+
+        atomic_store_explicit(&dlogger_ctx.high_water_signalled, false, memory_order_relaxed);
+        uint32_t begin = dlogger_port_cycles();
+        uint32_t written = log_store.written;
+        size_t drained = ring_drain_to_file();
+        durable_retry = (durable || buffer_durable_outstanding()) && !flush_sync_durable();
+        if (log_store.written != written) {
+            dlogger_metrics_flush(begin, log_store.written - written);
+        }
+        if (drained) {
+            dlogger_sink_notify();
+        }
     }
-    
-    xSemaphoreGive(dlogger_ctx.mutex);
-    return success;
+
+    // Final drain so nothing committed before deinit is lost
+    import_isr_entries();
+    dlogger_storm_sweep(storm_now(), true, storm_emit_summary, NULL);
+    ring_drain_to_file();
+    if (buffer_durable_outstanding()) {
+        flush_sync_durable();
+    }
+    dlogger_sink_notify();
+    dlogger_ctx.flush_task = NULL;
+    vTaskDelete(NULL);
 }
 
 // ============================================================================
@@ -222,75 +1010,185 @@ static bool buffer_add_entry(uint8_t source, uint8_t level, const char *message)
 // ============================================================================
 
 /**
- * @brief ESP-IDF log handler - parses level from ESP log format
+ * @brief Parse the ESP log level from the format string
+ *
+ * Format: "E (%lu) %s: ...", "W (%lu) %s: ...", etc., preceded by an ANSI
+ * color sequence when CONFIG_LOG_COLORS is enabled.
+ */
+static uint8_t esp_log_level_from_format(const char *format) {
+    const char *p = format;
+    if (p[0] == '\033' && p[1] == '[') {
+        // Skip "\033[0;31m"
+        p += 2;
+        while (*p && *p != 'm') p++;
+        if (*p == 'm') p++;
+    }
+
+    switch (*p) {
+        case 'E': return LOG_LEVEL_ERROR;
+        case 'W': return LOG_LEVEL_WARN;
+        case 'D':
+        case 'V': return LOG_LEVEL_DEBUG;
+        default:  return LOG_LEVEL_INFO;
+    }
+}
+
+/**
+ * @brief Length of the "X (%lu) %s: " prefix ESP-IDF puts before a log
+ *        format (color sequence included), 0 for any other format
+ *
+ * Lines stamped with the system time ("X (%s) %s: ") are not split.
+ */
+static size_t esp_format_prefix(const char *format) {
+    const char *p = format;
+    if (p[0] == '\033' && p[1] == '[') {
+        p = strchr(p, 'm');
+        if (!p) return 0;
+        p++;
+    }
+    if (!*p || strncmp(p + 1, " (%", 3) != 0) return 0;
+    p += 4;
+    if (*p == 'l') p++;     // PRIu32 is "lu" on Xtensa, "u" on the host
+    if (strncmp(p, "u) %s: ", 7) != 0) return 0;
+    return (size_t)(p + 7 - format);
+}
+
+/**
+ * @brief ESP-IDF log handler - parses level and tag from ESP log format
+ *
+ * The timestamp and tag lead the arguments, so the tag's runtime level is
+ * checked before anything is formatted. The line is then formatted once;
+ * the same text is queued for the console task (the caller never waits
+ * for the UART) and stored as a tagged record: the interned tag id
+ * replaces the "X (time) TAG: " prefix.
  */
 static int esp_log_handler(const char *format, va_list args) {
-    char message[256];
-    vsnprintf(message, sizeof(message), format, args);
+    uint8_t level = esp_log_level_from_format(format);
+    char line[DLOGGER_CONSOLE_LINE_MAX];
+    char prefix_format[32];
+    size_t prefix = esp_format_prefix(format);
+    size_t body = 0;                    // Offset of the message in `line` (0 = not split)
+    uint8_t tag_id = DLOGGER_TAG_NONE;
+    int length;
     
-    // Parse ESP log level from first character
-    // Format: "E (1234) tag: message", "W (1234) tag: message", etc.
-    uint8_t log_level = LOG_LEVEL_INFO;
-    if (message[0] == 'E') {
-        log_level = LOG_LEVEL_ERROR;
-    } else if (message[0] == 'W') {
-        log_level = LOG_LEVEL_WARN;
-    } else if (message[0] == 'I') {
-        log_level = LOG_LEVEL_INFO;
-    } else if (message[0] == 'D' || message[0] == 'V') {
-        log_level = LOG_LEVEL_DEBUG;
+    if (prefix > 0 && prefix < sizeof(prefix_format)) {
+        va_list body_args;
+        va_copy(body_args, args);
+        uint32_t timestamp = va_arg(body_args, uint32_t);
+        const char *tag = va_arg(body_args, const char *);
+        tag_id = dlogger_tag_intern(tag);
+        if (!dlogger_tag_enabled(tag_id, level)) {
+            va_end(body_args);
+            return 0;
+        }
+        
+        // Prefix, then the message with the remaining arguments
+        memcpy(prefix_format, format, prefix);
+        prefix_format[prefix] = '\0';
+        length = snprintf(line, sizeof(line), prefix_format, timestamp, tag);
+        if (length < 0) {
+            va_end(body_args);
+            return length;
+        }
+        body = ((size_t)length < sizeof(line) - 1) ? (size_t)length : sizeof(line) - 1;
+        int rest = vsnprintf(line + body, sizeof(line) - body, format + prefix, body_args);
+        va_end(body_args);
+        if (rest < 0) return rest;
+        length += rest;
+    } else {
+        if (!dlogger_tag_enabled(DLOGGER_TAG_NONE, level)) return 0;
+        length = vsnprintf(line, sizeof(line), format, args);
+        if (length < 0) return length;
     }
     
-    // Add to buffer (skip the printf return for actual logging)
-    buffer_add_entry(LOG_SOURCE_ESP, log_level, message);
+    size_t used = (size_t)length;
+    if (used >= sizeof(line)) {
+        // Cut lines still end the way ESP-IDF ends them
+        used = sizeof(line) - 1;
+        line[used - 1] = '\n';
+    }
+    dlogger_console_write(line, used);
     
-    // Pass through to original output
-    return vprintf(format, args);
+    if (tag_id != DLOGGER_TAG_NONE && body > 0 && body < used) {
+        // The color reset is not stored (nor is the color, in the prefix)
+        size_t end = used;
+        if (end - body >= 5 && memcmp(line + end - 5, "\033[0m\n", 5) == 0) {
+            line[end - 5] = '\n';
+            end -= 4;
+        }
+        // The tag id goes in place of the prefix's last byte
+        line[body - 1] = (char)tag_id;
+        buffer_add_tagged(level, line + body - 1, end - body + 1);
+    } else {
+        buffer_add_entry(LOG_SOURCE_ESP, level, line);
+    }
+    return length;
 }
 
-
-
 // ============================================================================
 // PUBLIC API IMPLEMENTATION
 // ============================================================================
 
 esp_err_t dlogger_init(void) {
-    // Allocate buffers (prefer PSRAM)
-    size_t buffer_size = LOG_BUFFER_CAPACITY * sizeof(dlogger_entry_t);
-    
-    dlogger_ctx.buffer_a = (dlogger_entry_t*)heap_caps_malloc(
-        buffer_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    dlogger_ctx.buffer_b = (dlogger_entry_t*)heap_caps_malloc(
-        buffer_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    
-    // Fall back to SRAM if PSRAM fails
-    if (!dlogger_ctx.buffer_a || !dlogger_ctx.buffer_b) {
-        ESP_LOGE(TAG, "PSRAM allocation failed, using SRAM");
-        if (dlogger_ctx.buffer_a) free(dlogger_ctx.buffer_a);
-        if (dlogger_ctx.buffer_b) free(dlogger_ctx.buffer_b);
-        
-        dlogger_ctx.buffer_a = (dlogger_entry_t*)malloc(buffer_size);
-        dlogger_ctx.buffer_b = (dlogger_entry_t*)malloc(buffer_size);
-        
-        if (!dlogger_ctx.buffer_a || !dlogger_ctx.buffer_b) {
-            ESP_LOGE(TAG, "SRAM allocation failed");
-            return ESP_ERR_NO_MEM;
+    // Allocate one ring per core, the overflow ring and the priority ring
+    // (prefers PSRAM, falls back to SRAM)
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        esp_err_t ret = dlogger_ring_init(&dlogger_ctx.rings[i], buffer_ring_size(i));
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Ring allocation failed (%s)", esp_err_to_name(ret));
+            buffer_rings_deinit();
+            return ret;
         }
+        atomic_store(&dlogger_ctx.durable_target[i], 0);
+        atomic_store(&dlogger_ctx.durable_done[i], 0);
+    }
+    
+    if (dlogger_block_writer_init(&block_writer, LOG_COMPRESS) != ESP_OK) {
+        ESP_LOGE(TAG, "Block buffer allocation failed");
+        buffer_rings_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Optional: without the cache, reads simply end at the oldest ring record
+    if (dlogger_cache_init(&log_cache, LOG_CACHE_PAGES) != ESP_OK) {
+        ESP_LOGW(TAG, "Entry cache allocation failed, reads limited to the rings");
+    }
+    
+    dlogger_storm_reset();
+    
+    // Extra sinks follow the cache; without it dlogger_sink_add() refuses
+    if (dlogger_sink_init(&log_cache) != ESP_OK) {
+        ESP_LOGW(TAG, "Sink registry not created, dlogger_sink_add() unavailable");
     }
     
-    // Initialize buffers
-    memset(dlogger_ctx.buffer_a, 0, buffer_size);
-    memset(dlogger_ctx.buffer_b, 0, buffer_size);
+    // Segment writes go through the shared I/O service, so SPIFFS pauses
+    // stall its task instead of the flush task
+#if CONFIG_DLOGGER_ASYNC_WRITES
+    log_store.async = (storage_io_init() == ESP_OK);
+#else
+    log_store.async = false;
+#endif
+    
+    for (int i = 0; i < LOG_SEGMENT_COUNT; i++) {
+        dlogger_segment_path(LOG_DIR, i, segment_paths[i], sizeof(segment_paths[i]));
+    }
+    // The old append-only file would hold on to flash the segments need
+    remove(LOG_LEGACY_PATH);
     
-    // Create mutex
-    dlogger_ctx.mutex = xSemaphoreCreateMutex();
-    if (!dlogger_ctx.mutex) {
-        ESP_LOGE(TAG, "Failed to create mutex");
-        free(dlogger_ctx.buffer_a);
-        free(dlogger_ctx.buffer_b);
+    dlogger_ctx.span_mutex = xSemaphoreCreateMutex();
+    dlogger_ctx.store_mutex = xSemaphoreCreateMutex();
+    if (!dlogger_ctx.span_mutex || !dlogger_ctx.store_mutex) {
+        ESP_LOGE(TAG, "Failed to create dlogger mutexes");
+        buffer_mutexes_deinit();
+        dlogger_cache_free(&log_cache);
+        dlogger_block_writer_free(&block_writer);
+        buffer_rings_deinit();
         return ESP_ERR_NO_MEM;
     }
     
+    // The last run's unflushed entries go first, before anything is logged
+    size_t recovered = tail_recover_to_log();
+    
     // Start background flush task
     dlogger_ctx.task_running = true;
     BaseType_t task_created = xTaskCreatePinnedToCore(
@@ -300,143 +1198,664 @@ esp_err_t dlogger_init(void) {
         NULL,
         tskIDLE_PRIORITY + 1,
         &dlogger_ctx.flush_task,
-        PRO_CPU_NUM
+        DLOGGER_PORT_FLUSH_CORE
     );
     
     if (task_created != pdPASS) {
         ESP_LOGE(TAG, "Failed to create flush task");
-        vSemaphoreDelete(dlogger_ctx.mutex);
-        free(dlogger_ctx.buffer_a);
-        free(dlogger_ctx.buffer_b);
+        dlogger_ctx.task_running = false;
+        buffer_mutexes_deinit();
+        dlogger_cache_free(&log_cache);
+        dlogger_block_writer_free(&block_writer);
+        buffer_rings_deinit();
         return ESP_FAIL;
     }
     
+    // Optional: without the console task ESP logs are printed synchronously
+    if (dlogger_console_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Console task not started, console output stays synchronous");
+    }
+    
     // Hook into logging systems
     dlogger_hook_esp_log();
     
     
     // Log initialization
-    dlogger_log("DLogger initialized with double buffer system");
-    ESP_LOGI(TAG, "Double buffer logging initialized. Capacity: %d entries", 
-             LOG_BUFFER_CAPACITY);
+    dlogger_log("DLogger initialized with lock-free ring buffer");
+    ESP_LOGI(TAG, "Ring buffer logging initialized. Capacity: %d KB", 
+             CONFIG_DLOGGER_RING_SIZE_KB);
+    if (recovered > 0) {
+        ESP_LOGW(TAG, "Recovered %u entries logged before the last reset", (unsigned)recovered);
+    }
     
     return ESP_OK;
 }
 
 esp_err_t dlogger_log(const char *format, ...) {
-    char message[256];
     va_list args;
     va_start(args, format);
-    vsnprintf(message, sizeof(message), format, args);
+    bool success = buffer_add_formatted(LOG_SOURCE_USER, LOG_LEVEL_INFO, format, args);
     va_end(args);
     
-    bool success = buffer_add_entry(LOG_SOURCE_USER, LOG_LEVEL_INFO, message);
     return success ? ESP_OK : ESP_ERR_NO_MEM;
 }
 
+/**
+ * @brief Copy a cached entry into the public fixed-size entry layout
+ */
+static void cache_rec_decode(const dlogger_cache_rec_t *rec, dlogger_entry_t *entry) {
+    size_t len = (rec->length < sizeof(entry->message) - 1) ? rec->length
+                                                             : sizeof(entry->message) - 1;
+    entry->timestamp = rec->timestamp;
+    entry->source = rec->source;
+    entry->level = rec->level;
+    memcpy(entry->message, dlogger_cache_rec_message(rec), len);
+    entry->message[len] = '\0';
+}
+
 size_t dlogger_get_raw_entries(dlogger_entry_t *dest, size_t max_entries) {
-    if (!dest || max_entries == 0) return 0;
+    if (!dest || max_entries == 0 || !dlogger_ctx.rings[0].buf) return 0;
+    
+    // One stream over every core ring (unflushed records and flushed
+    // history) and, below the oldest record each ring still holds, the
+    // cache of flushed entries, merged newest first by timestamp. Only
+    // the winner of each step is copied, straight into `dest`
+    dlogger_ring_read_iter_t iters[LOG_RING_COUNT];
+    uint32_t below[LOG_RING_COUNT];
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        dlogger_ring_read_begin(&dlogger_ctx.rings[i], max_entries, &iters[i]);
+        below[i] = iters[i].begin;
+    }
+    dlogger_cache_iter_t cache_it;
+    bool cached = dlogger_cache_iter_begin(&log_cache, below, &cache_it);
+    
+    size_t copied = 0;
+    while (copied < max_entries) {
+        int newest = -1;
+        uint32_t top_ts = 0, top_seq = 0;
+        for (int i = 0; i < LOG_RING_COUNT; i++) {
+            uint32_t ts, seq;
+            if (dlogger_ring_read_peek(&iters[i], &ts, &seq) &&
+                (newest < 0 || dlogger_entry_after(ts, seq, top_ts, top_seq))) {
+                newest = i;
+                top_ts = ts;
+                top_seq = seq;
+            }
+        }
+        const dlogger_cache_rec_t *c = cached ? dlogger_cache_iter_peek(&cache_it) : NULL;
+        
+        if (c && (newest < 0 || dlogger_entry_after(c->timestamp, c->seq, top_ts, top_seq))) {
+            cache_rec_decode(c, &dest[copied++]);
+            dlogger_cache_iter_next(&cache_it);
+        } else if (newest >= 0) {
+            if (dlogger_ring_read_take(&iters[newest], &dest[copied])) {
+                copied++;
+            }
+        } else {
+            break;
+        }
+    }
+    
+    if (cached) {
+        dlogger_cache_iter_end(&cache_it);
+    }
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        dlogger_ring_read_end(&iters[i]);
+    }
+    return copied;
+}
+
+/**
+ * @brief Fill a span for a held record
+ *
+ * @param rendered MAX_MESSAGE_LENGTH bytes for deferred and tagged records
+ */
+static void span_from_rec(const dlogger_rec_t *rec, dlogger_span_t *span, char *rendered) {
+    span->timestamp = rec->timestamp;
+    span->seq = dlogger_rec_seq(rec);
+    span->source = rec->source;
+    span->level = rec->level & DLOGGER_REC_LEVEL_MASK;
+    span->length = rec->length;
+    span->message = dlogger_rec_message(rec);
+    if (rec->level & DLOGGER_REC_FLAG_RENDER) {
+        // Deferred and tagged records are rendered into the caller's stack buffer
+        span->length = (uint16_t)dlogger_rec_render(rec, rendered, MAX_MESSAGE_LENGTH);
+        span->message = rendered;
+    }
+}
+
+/**
+ * @brief Whether a rendered ESP log line carries `tag`
+ *
+ * Parses "X (time) TAG: ..." after the optional ANSI color sequence.
+ */
+static bool esp_text_has_tag(const char *text, const char *tag) {
+    const char *p = esp_text_body(text, strlen(text));
+    if (p == text) return false;
+
+    size_t len = strlen(tag);
+    return strncmp(p, tag, len) == 0 && p[len] == ':';
+}
+
+/**
+ * @brief Ring filter predicate: whether an ESP log entry carries the tag `ctx`
+ *
+ * `rec` is a validated private copy, so deferred records can be rendered.
+ * Tagged records compare the interned name without rendering.
+ */
+static bool esp_tag_matches(const dlogger_rec_t *rec, void *ctx) {
+    if (rec->source != LOG_SOURCE_ESP) return false;
+    if (rec->level & DLOGGER_REC_FLAG_TAGGED) {
+        const char *name = (rec->length > 0) ? dlogger_tag_name(*dlogger_rec_message(rec)) : NULL;
+        return name && strcmp(name, (const char *)ctx) == 0;
+    }
+
+    char text[96];
+    dlogger_rec_render(rec, text, sizeof(text));
+    return esp_text_has_tag(text, (const char *)ctx);
+}
+
+/**
+ * @brief Next cached entry that passes `filter` (NULL = all), or NULL
+ */
+static const dlogger_cache_rec_t *cache_peek_filtered(dlogger_cache_iter_t *it,
+                                                      const dlogger_filter_t *filter) {
+    const dlogger_cache_rec_t *rec;
+    while ((rec = dlogger_cache_iter_peek(it)) != NULL) {
+        if (!filter) return rec;
+        
+        bool match = (filter->source_mask & DLOGGER_SOURCE_BIT(rec->source)) &&
+                     (filter->level_mask & DLOGGER_LEVEL_BIT(rec->level));
+        if (match && filter->tag) {
+            char text[96];
+            size_t len = (rec->length < sizeof(text) - 1) ? rec->length : sizeof(text) - 1;
+            memcpy(text, dlogger_cache_rec_message(rec), len);
+            text[len] = '\0';
+            match = (rec->source == LOG_SOURCE_ESP) && esp_text_has_tag(text, filter->tag);
+        }
+        if (match) return rec;
+        dlogger_cache_iter_next(it);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Translate a public filter for the ring walk
+ *
+ * @return `out`, or NULL if `filter` lets every entry through
+ */
+static const dlogger_ring_filter_t *ring_filter_from(const dlogger_filter_t *filter,
+                                                     dlogger_ring_filter_t *out) {
+    if (!filter) return NULL;
+    uint32_t all_sources = DLOGGER_SOURCE_BIT(LOG_SOURCE_COUNT) - 1;
+    uint32_t all_levels = DLOGGER_LEVEL_BIT(LOG_LEVEL_COUNT) - 1;
+    if ((filter->source_mask & all_sources) == all_sources &&
+        (filter->level_mask & all_levels) == all_levels && !filter->tag) {
+        return NULL;
+    }
+
+    dlogger_ring_filter_init(out, filter->source_mask, filter->level_mask);
+    if (filter->tag) {
+        out->match = esp_tag_matches;
+        out->match_ctx = (void *)filter->tag;
+    }
+    return out;
+}
+
+size_t dlogger_read_spans(size_t max_entries, dlogger_span_cb_t callback, void *user_ctx) {
+    return dlogger_read_spans_filtered(NULL, max_entries, callback, user_ctx);
+}
+
+size_t dlogger_read_spans_filtered(const dlogger_filter_t *filter, size_t max_entries,
+                                   dlogger_span_cb_t callback, void *user_ctx) {
+    if (!callback || max_entries == 0 || !dlogger_ctx.rings[0].buf || !dlogger_ctx.span_mutex) {
+        return 0;
+    }
+    
+    // Each ring supports a single span reader (one hold position)
+    xSemaphoreTake(dlogger_ctx.span_mutex, portMAX_DELAY);
+    
+    dlogger_ring_filter_t ring_filter;
+    const dlogger_ring_filter_t *rf = ring_filter_from(filter, &ring_filter);
+    dlogger_ring_span_iter_t iters[LOG_RING_COUNT];
+    uint32_t below[LOG_RING_COUNT];
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        dlogger_ring_span_begin(&dlogger_ctx.rings[i], rf, max_entries, &iters[i]);
+        below[i] = iters[i].begin;
+    }
+    
+    // Entries already reclaimed from a ring continue from the cache (a
+    // private copy per page, so the flush task is never held up)
+    dlogger_cache_iter_t cache_it;
+    bool cached = dlogger_cache_iter_begin(&log_cache, below, &cache_it);
+    
+    // Merge the core rings and the cache newest first by timestamp
+    char rendered[MAX_MESSAGE_LENGTH];
+    size_t visited = 0;
+    while (visited < max_entries) {
+        int newest = -1;
+        const dlogger_rec_t *rec = NULL;
+        for (int i = 0; i < LOG_RING_COUNT; i++) {
+            const dlogger_rec_t *r = dlogger_ring_span_peek(&iters[i]);
+            if (r && (!rec || dlogger_entry_after(r->timestamp, dlogger_rec_seq(r),
+                                                  rec->timestamp, dlogger_rec_seq(rec)))) {
+                rec = r;
+                newest = i;
+            }
+        }
+        const dlogger_cache_rec_t *c = cached ? cache_peek_filtered(&cache_it, filter) : NULL;
+        
+        dlogger_span_t span;
+        if (c && (!rec || dlogger_entry_after(c->timestamp, c->seq,
+                                              rec->timestamp, dlogger_rec_seq(rec)))) {
+            span.timestamp = c->timestamp;
+            span.seq = c->seq;
+            span.source = c->source;
+            span.level = c->level;
+            span.length = c->length;
+            span.message = dlogger_cache_rec_message(c);
+            dlogger_cache_iter_next(&cache_it);
+        } else if (rec) {
+            span_from_rec(rec, &span, rendered);
+            dlogger_ring_span_next(&iters[newest]);
+        } else {
+            break;
+        }
+        
+        visited++;
+        if (!callback(&span, user_ctx)) break;
+    }
     
-    size_t entries_copied = 0;
+    if (cached) {
+        dlogger_cache_iter_end(&cache_it);
+    }
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        dlogger_ring_span_end(&iters[i]);
+    }
+    xSemaphoreGive(dlogger_ctx.span_mutex);
+    return visited;
+}
+
+size_t dlogger_read_since(dlogger_cursor_t *cursor, const dlogger_filter_t *filter,
+                          size_t max_entries, dlogger_span_cb_t callback, void *user_ctx) {
+    if (!cursor || !callback || max_entries == 0 || !dlogger_ctx.rings[0].buf ||
+        !dlogger_ctx.span_mutex) {
+        return 0;
+    }
     
-    xSemaphoreTake(dlogger_ctx.mutex, portMAX_DELAY);
+    xSemaphoreTake(dlogger_ctx.span_mutex, portMAX_DELAY);
     
-    // Get active buffer
-    dlogger_entry_t *active_buffer = (dlogger_ctx.active == 0) ? 
-                                    dlogger_ctx.buffer_a : dlogger_ctx.buffer_b;
+    // Each ring resumes at its own position, so nothing committed late on
+    // one core is skipped because the other core's entries were read first
+    dlogger_ring_filter_t ring_filter;
+    const dlogger_ring_filter_t *rf = ring_filter_from(filter, &ring_filter);
+    dlogger_ring_span_iter_t iters[LOG_RING_COUNT];
+    size_t total = 0;
+    cursor->gap = false;
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        bool lost;
+        dlogger_ring_span_begin_since(&dlogger_ctx.rings[i], cursor->priv[i], rf, max_entries,
+                                      &iters[i], &lost);
+        cursor->gap |= lost;
+        total += (iters[i].found < max_entries) ? iters[i].found : max_entries;
+    }
     
-    // Copy in reverse order (newest first)
-    for (size_t i = 0; i < dlogger_ctx.fill_idx && i < max_entries; i++) {
-        size_t src_idx = dlogger_ctx.fill_idx - 1 - i;
-        memcpy(&dest[i], &active_buffer[src_idx], sizeof(dlogger_entry_t));
-        entries_copied++;
+    // More new entries than requested: only the newest max_entries are returned
+    size_t skip = (total > max_entries) ? total - max_entries : 0;
+    if (skip) {
+        cursor->gap = true;
     }
     
-    xSemaphoreGive(dlogger_ctx.mutex);
+    // Merge the core rings oldest first by sequence number
+    char rendered[MAX_MESSAGE_LENGTH];
+    size_t visited = 0;
+    for (;;) {
+        int oldest = -1;
+        const dlogger_rec_t *rec = NULL;
+        for (int i = 0; i < LOG_RING_COUNT; i++) {
+            const dlogger_rec_t *r = dlogger_ring_span_peek(&iters[i]);
+            if (r && (!rec || (int32_t)(dlogger_rec_seq(r) - dlogger_rec_seq(rec)) < 0)) {
+                rec = r;
+                oldest = i;
+            }
+        }
+        if (!rec) break;
+        
+        dlogger_ring_span_next(&iters[oldest]);
+        if (skip) {
+            skip--;
+            continue;
+        }
+        
+        dlogger_span_t span;
+        span_from_rec(rec, &span, rendered);
+        cursor->seq = span.seq;
+        visited++;
+        if (!callback(&span, user_ctx)) break;
+    }
     
-    return entries_copied;
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        cursor->priv[i] = dlogger_ring_span_resume(&iters[i]);
+        dlogger_ring_span_end(&iters[i]);
+    }
+    xSemaphoreGive(dlogger_ctx.span_mutex);
+    return visited;
 }
 
 void dlogger_get_stats(dlogger_stats_t *stats) {
     if (!stats) return;
     
-    xSemaphoreTake(dlogger_ctx.mutex, portMAX_DELAY);
+    uint32_t pending = buffer_pending();
     
-    stats->entries_in_buffer = dlogger_ctx.fill_idx;
-    stats->flush_pending = dlogger_ctx.flush_pending;
-    stats->active_buffer = dlogger_ctx.active;
-    stats->total_capacity = dlogger_ctx.capacity;
+    stats->bytes_in_buffer = pending;
+    stats->flush_pending = (pending != 0);
+    stats->total_capacity = 0;
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        stats->total_capacity += dlogger_ctx.rings[i].size;
+    }
+    stats->isr_dropped = dlogger_isr_dropped();
+    stats->dropped = atomic_load_explicit(&dlogger_ctx.dropped, memory_order_relaxed);
+    stats->evicted = atomic_load_explicit(&dlogger_ctx.evicted, memory_order_relaxed);
+    stats->priority_dropped = atomic_load_explicit(&dlogger_ctx.priority_dropped,
+                                                   memory_order_relaxed);
+    stats->priority_evicted = atomic_load_explicit(&dlogger_ctx.priority_evicted,
+                                                   memory_order_relaxed);
+    stats->blocked = atomic_load_explicit(&dlogger_ctx.blocked, memory_order_relaxed);
+    stats->block_timeouts = atomic_load_explicit(&dlogger_ctx.block_timeouts, memory_order_relaxed);
+    stats->spilled = atomic_load_explicit(&dlogger_ctx.spilled, memory_order_relaxed);
+    stats->storm_suppressed = dlogger_storm_suppressed();
+    stats->storm_summaries = dlogger_storm_summaries();
+    stats->console_dropped = dlogger_console_dropped();
+    stats->tag_filtered = dlogger_tag_filtered();
+    stats->durable_syncs = atomic_load_explicit(&dlogger_ctx.durable_syncs, memory_order_relaxed);
+    stats->durable_failures = atomic_load_explicit(&dlogger_ctx.durable_failures, memory_order_relaxed);
+    stats->durable_timeouts = atomic_load_explicit(&dlogger_ctx.durable_timeouts, memory_order_relaxed);
+    dlogger_metrics_read(stats);
     
-    xSemaphoreGive(dlogger_ctx.mutex);
+    stats->ring_capacity = LOG_CORE_RING_SIZE;
+    stats->ring_peak = 0;
+    for (int i = 0; i < LOG_CORE_RINGS; i++) {
+        uint32_t peak = atomic_load_explicit(&dlogger_ctx.peak[i], memory_order_relaxed);
+        if (peak > stats->ring_peak) stats->ring_peak = peak;
+    }
+    stats->spill_peak = LOG_SPILL_SIZE ?
+        atomic_load_explicit(&dlogger_ctx.peak[LOG_SPILL_RING], memory_order_relaxed) : 0;
+    stats->priority_peak = LOG_PRIORITY_SIZE ?
+        atomic_load_explicit(&dlogger_ctx.peak[LOG_PRIORITY_RING], memory_order_relaxed) : 0;
 }
 
-esp_err_t dlogger_force_flush(void) {
-    esp_err_t result = ESP_FAIL;
+void dlogger_log_stats(void) {
+    dlogger_stats_t stats;
+    dlogger_get_stats(&stats);
     
-    xSemaphoreTake(dlogger_ctx.mutex, portMAX_DELAY);
+    static const char *const source_names[LOG_SOURCE_COUNT] = { "ESP", "LVGL", "USER" };
+    for (int s = 0; s < LOG_SOURCE_COUNT; s++) {
+        ESP_LOGI(TAG, "%-4s E/W/I/D stored %u/%u/%u/%u dropped %u/%u/%u/%u", source_names[s],
+                 (unsigned)stats.entries[s][LOG_LEVEL_ERROR], (unsigned)stats.entries[s][LOG_LEVEL_WARN],
+                 (unsigned)stats.entries[s][LOG_LEVEL_INFO], (unsigned)stats.entries[s][LOG_LEVEL_DEBUG],
+                 (unsigned)stats.entries_dropped[s][LOG_LEVEL_ERROR],
+                 (unsigned)stats.entries_dropped[s][LOG_LEVEL_WARN],
+                 (unsigned)stats.entries_dropped[s][LOG_LEVEL_INFO],
+                 (unsigned)stats.entries_dropped[s][LOG_LEVEL_DEBUG]);
+    }
     
-    if (!dlogger_ctx.flush_pending && dlogger_ctx.fill_idx > 0) {
-        dlogger_ctx.active = !dlogger_ctx.active;
-        dlogger_ctx.flush_pending = true;
-        dlogger_ctx.fill_idx = 0;
-        result = ESP_OK;
-    } else {
-        result = ESP_ERR_INVALID_STATE;
+    // Histograms as "count@<bound>" pairs, empty buckets left out
+    char hist[2][160];
+    const size_t *buckets[2] = { stats.enqueue_ns_hist, stats.flush_us_hist };
+    for (int h = 0; h < 2; h++) {
+        int len = 0;
+        hist[h][0] = '\0';
+        for (int i = 0; i < DLOGGER_STATS_BUCKETS && len < (int)sizeof(hist[h]); i++) {
+            if (!buckets[h][i]) continue;
+            len += snprintf(&hist[h][len], sizeof(hist[h]) - len,
+                            (i == DLOGGER_STATS_BUCKETS - 1) ? " %u@>=%u" : " %u@<%u",
+                            (unsigned)buckets[h][i],
+                            (unsigned)(256u << ((i == DLOGGER_STATS_BUCKETS - 1) ? i - 1 : i)));
+        }
     }
+    ESP_LOGI(TAG, "enqueue ns:%s (max %u)", hist[0], (unsigned)stats.enqueue_ns_max);
+    ESP_LOGI(TAG, "flush us:%s (max %u), %u flushes, last %u B, max %u B, %llu B written, "
+             "%u write errors", hist[1], (unsigned)stats.flush_us_max, (unsigned)stats.flushes,
+             (unsigned)stats.flush_bytes_last, (unsigned)stats.flush_bytes_max,
+             (unsigned long long)stats.bytes_written, (unsigned)stats.write_errors);
+    ESP_LOGI(TAG, "ring peak %u of %u B, spill peak %u B, priority peak %u B, pending %u B",
+             (unsigned)stats.ring_peak, (unsigned)stats.ring_capacity, (unsigned)stats.spill_peak,
+             (unsigned)stats.priority_peak, (unsigned)stats.bytes_in_buffer);
     
-    xSemaphoreGive(dlogger_ctx.mutex);
+    if (log_store.async) {
+        storage_io_stats_t io;
+        storage_io_get_stats(&io);
+        ESP_LOGI(TAG, "storage I/O: %u requests (%u merged), %u writes, %u syncs, %u errors, "
+                 "latency max %u us, service max %u us, queue peak %u B, %u stalls",
+                 (unsigned)io.requests, (unsigned)io.coalesced, (unsigned)io.writes,
+                 (unsigned)io.syncs, (unsigned)io.errors, (unsigned)io.latency_us_max,
+                 (unsigned)io.service_us_max, (unsigned)io.queued_peak, (unsigned)io.stalls);
+    }
+}
+
+esp_err_t dlogger_sync(uint32_t timeout_ms) {
+    if (!producer_may_wait()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Everything reserved so far becomes a durable target
+    uint32_t ends[LOG_RING_COUNT];
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        ends[i] = atomic_load_explicit(&dlogger_ctx.rings[i].head, memory_order_acquire);
+        buffer_raise_durable(i, ends[i]);
+    }
+    uint32_t failures = atomic_load_explicit(&dlogger_ctx.durable_failures, memory_order_relaxed);
+    flush_task_notify(FLUSH_NOTIFY_DURABLE);
+
+    TickType_t start = xTaskGetTickCount();
+    for (int i = 0; i < LOG_RING_COUNT; i++) {
+        while ((int32_t)(atomic_load_explicit(&dlogger_ctx.durable_done[i], memory_order_acquire) -
+                         ends[i]) < 0) {
+            if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(timeout_ms)) {
+                return ESP_ERR_TIMEOUT;
+            }
+            vTaskDelay(1);
+        }
+    }
+    return (atomic_load_explicit(&dlogger_ctx.durable_failures, memory_order_relaxed) == failures)
+           ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t dlogger_force_flush(void) {
+    if (!dlogger_ctx.flush_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (buffer_pending() == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    return result;
+    // Wake the flush task early; it drains everything committed so far
+    flush_task_notify(FLUSH_NOTIFY_FORCE);
+    return ESP_OK;
 }
 
 void dlogger_hook_esp_log(void) {
     esp_log_set_vprintf(esp_log_handler);
 }
 
+esp_err_t dlogger_set_tag_level(const char *tag, dlogger_level_t level) {
+    if (!tag || level >= LOG_LEVEL_COUNT) return ESP_ERR_INVALID_ARG;
+    return dlogger_tag_set_level(tag, (uint8_t)level) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+dlogger_level_t dlogger_get_tag_level(const char *tag) {
+    return (dlogger_level_t)dlogger_tag_get_level(tag);
+}
+
 esp_err_t dlogger_add_entry(dlogger_source_t source, dlogger_level_t level, const char *message) {
     bool success = buffer_add_entry(source, level, message);
     return success ? ESP_OK : ESP_ERR_NO_MEM;
 }
 
-const char* dlogger_get_current_log_filepath(void) {
-    return current_log_path;
+esp_err_t IRAM_ATTR dlogger_add_entry_from_isr(dlogger_source_t source, dlogger_level_t level,
+                                               const char *message) {
+    if (!message) return ESP_ERR_INVALID_ARG;
+    
+    bool was_empty;
+    if (!dlogger_isr_push((uint8_t)source, (uint8_t)level, message, &was_empty)) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Wake the flush task only for the first staged entry
+    TaskHandle_t task = dlogger_ctx.flush_task;
+    if (was_empty && task) {
+        if (dlogger_port_in_isr()) {
+            BaseType_t woken = pdFALSE;
+            xTaskNotifyFromISR(task, FLUSH_NOTIFY_DATA, eSetBits, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            xTaskNotify(task, FLUSH_NOTIFY_DATA, eSetBits);
+        }
+    }
+    return ESP_OK;
 }
 
-void dlogger_deinit(void) {
-    // Stop background task
-    dlogger_ctx.task_running = false;
-    if (dlogger_ctx.flush_task) {
-        vTaskDelete(dlogger_ctx.flush_task);
-        dlogger_ctx.flush_task = NULL;
+char *dlogger_reserve(dlogger_source_t source, dlogger_level_t level, size_t len,
+                      dlogger_reservation_t *resv) {
+    if (!resv) return NULL;
+    resv->message = NULL;
+    if (len > MAX_MESSAGE_LENGTH - 1) return NULL;
+    
+    // Admitted like any other entry of this level; timed until the commit
+    uint32_t begin = dlogger_metrics_enqueue_begin();
+    dlogger_ring_resv_t r;
+    int index = buffer_reserve((uint8_t)level, len, &r);
+    if (index < 0) {
+        dlogger_metrics_dropped((uint8_t)source, (uint8_t)level);
+        dlogger_metrics_enqueue_end(begin);
+        return NULL;
     }
     
-    // Flush any remaining logs
-    xSemaphoreTake(dlogger_ctx.mutex, portMAX_DELAY);
+    // Stamp at reserve time so timestamps follow ring order
+    r.rec->timestamp = dlogger_port_time_ms();
+    r.rec->length = (uint16_t)len;
+    r.rec->source = (uint8_t)source;
+    r.rec->level = (uint8_t)level;
     
-    if (dlogger_ctx.fill_idx > 0) {
-        dlogger_entry_t *active_buffer = (dlogger_ctx.active == 0) ? 
-                                        dlogger_ctx.buffer_a : dlogger_ctx.buffer_b;
-        flush_buffer_to_file(active_buffer, dlogger_ctx.fill_idx);
-    }
+    resv->message = dlogger_rec_message(r.rec);
+    resv->capacity = len;
+    resv->priv.rec = r.rec;
+    resv->priv.pos = r.pos;
+    resv->priv.start = r.start;
+    resv->priv.end = r.end;
+    resv->priv.ring = (uint32_t)index;
+    resv->priv.begin = begin;
+    return resv->message;
+}
+
+esp_err_t dlogger_commit(dlogger_reservation_t *resv, size_t len) {
+    if (!resv || !resv->message) return ESP_ERR_INVALID_ARG;
+    
+    dlogger_ring_resv_t r = {
+        .rec = (dlogger_rec_t *)resv->priv.rec,
+        .pos = resv->priv.pos,
+        .start = resv->priv.start,
+        .end = resv->priv.end,
+    };
     
-    if (dlogger_ctx.flush_pending) {
-        dlogger_entry_t *inactive_buffer = (dlogger_ctx.active == 0) ? 
-                                          dlogger_ctx.buffer_b : dlogger_ctx.buffer_a;
-        flush_buffer_to_file(inactive_buffer, dlogger_ctx.capacity);
+    // A shorter message shrinks the record; 0 turns it into padding
+    if (len > resv->capacity) len = resv->capacity;
+    r.rec->length = (uint16_t)len;
+    if (len == 0) {
+        r.rec->source = DLOGGER_REC_PAD;
+    } else {
+        // Repeats are only known once the text is written: a suppressed
+        // entry gives its room back as padding
+        uint8_t source = r.rec->source;
+        uint8_t level = r.rec->level;
+        uint32_t key = dlogger_storm_hash(dlogger_storm_key(source, level), resv->message, len);
+        if (storm_suppress(key, source, level, resv->message, len)) {
+            r.rec->source = DLOGGER_REC_PAD;
+        }
     }
     
-    xSemaphoreGive(dlogger_ctx.mutex);
+    // The task may have migrated since the reservation: commit to its ring
+    buffer_commit(&dlogger_ctx.rings[resv->priv.ring], &r);
+    dlogger_metrics_enqueue_end(resv->priv.begin);
+    resv->message = NULL;
+    return ESP_OK;
+}
+
+const char* dlogger_get_current_log_filepath(void) {
+    return segment_paths[atomic_load(&log_store.index) % LOG_SEGMENT_COUNT];
+}
+
+esp_err_t dlogger_read_log_file(const char *path, dlogger_entry_cb_t callback, void *user_ctx) {
+    dlogger_store_settle(&log_store);
+    return dlogger_file_read(path, callback, user_ctx);
+}
+
+esp_err_t dlogger_query(uint32_t t_from, uint32_t t_to, uint32_t source_mask,
+                        uint32_t level_mask, dlogger_entry_cb_t callback, void *user_ctx) {
+    if (!callback || t_from > t_to) return ESP_ERR_INVALID_ARG;
+    if (!dlogger_ctx.store_mutex) return ESP_ERR_INVALID_STATE;
     
-    // Cleanup
-    close_log_file();
+    dlogger_file_filter_t filter = {
+        .t_from = t_from,
+        .t_to = t_to,
+        .source_mask = source_mask,
+        .level_mask = level_mask,
+    };
     
-    if (dlogger_ctx.buffer_a) free(dlogger_ctx.buffer_a);
-    if (dlogger_ctx.buffer_b) free(dlogger_ctx.buffer_b);
-    dlogger_ctx.buffer_a = NULL;
-    dlogger_ctx.buffer_b = NULL;
+    // Plan from the sparse index under the lock, read flash without it
+    // (once the blocks it lists are out of the I/O queue)
+    dlogger_range_t *ranges = (dlogger_range_t*)malloc(LOG_INDEX_ENTRIES * sizeof(dlogger_range_t));
+    if (!ranges) return ESP_ERR_NO_MEM;
     
-    if (dlogger_ctx.mutex) {
-        vSemaphoreDelete(dlogger_ctx.mutex);
-        dlogger_ctx.mutex = NULL;
+    xSemaphoreTake(dlogger_ctx.store_mutex, portMAX_DELAY);
+    size_t count = dlogger_store_plan(&log_store, &filter, ranges);
+    xSemaphoreGive(dlogger_ctx.store_mutex);
+    dlogger_store_settle(&log_store);
+    
+    for (size_t i = 0; i < count; i++) {
+        if (!dlogger_store_read_range(LOG_DIR, &ranges[i], &filter, callback, user_ctx)) {
+            break;
+        }
     }
-}
\ No newline at end of file
+    
+    free(ranges);
+    return ESP_OK;
+}
+
+int dlogger_entry_to_text(const dlogger_entry_t *entry, char *buf, size_t buf_len) {
+    if (!entry || !buf || buf_len == 0) return 0;
+    
+    return snprintf(buf, buf_len, "%" PRIu32 " [%s][%c] %s",
+                    entry->timestamp,
+                    source_to_string(entry->source),
+                    level_to_char(entry->level),
+                    entry->message);
+}
+
+void dlogger_deinit(void) {
+    // Stop background task; it drains the ring once more before exiting
+    dlogger_ctx.task_running = false;
+    if (dlogger_ctx.flush_task) {
+        flush_task_notify(FLUSH_NOTIFY_STOP);
+        while (dlogger_ctx.flush_task) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    
+    // Print what is still queued; later ESP logs go to the console directly
+    dlogger_console_deinit();
+    
+    // Sinks deliver what the final drain left in the cache, then stop
+    dlogger_sink_deinit();
+    
+    // Cleanup
+    dlogger_store_free(&log_store);
+    dlogger_block_writer_free(&block_writer);
+    dlogger_cache_free(&log_cache);
+    buffer_mutexes_deinit();
+    buffer_rings_deinit();
+    
+    // Everything reached the log: nothing to recover at the next init
+    dlogger_tail_deinit();
+}
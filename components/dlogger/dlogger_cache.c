@@ -0,0 +1,306 @@
+#include "dlogger_cache.h"
+#include "dlogger_port.h"
+#include <string.h>
+#include <stdlib.h>
+
+_Static_assert(sizeof(dlogger_cache_rec_t) == 16, "Cached entry header must stay 16 bytes");
+
+#define CACHE_MAX_ENTRIES  (DLOGGER_CACHE_PAGE_SIZE / sizeof(dlogger_cache_rec_t))
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+/**
+ * @brief Bytes occupied by a cached entry with `length` message bytes
+ */
+static inline uint32_t cache_rec_size(size_t length) {
+    return (uint32_t)((sizeof(dlogger_cache_rec_t) + length + 3) & ~(size_t)3);
+}
+
+static inline uint8_t *page_data(dlogger_cache_t *cache, uint32_t id) {
+    return cache->data + (size_t)(id % cache->count) * DLOGGER_CACHE_PAGE_SIZE;
+}
+
+static inline dlogger_cache_page_t *page_at(dlogger_cache_t *cache, uint32_t id) {
+    return &cache->pages[id % cache->count];
+}
+
+/**
+ * @brief Recycle the oldest page as page `id` (flush task only)
+ *
+ * The id is cleared first, so a reader still copying the old content
+ * notices the change when it validates.
+ */
+static void page_start(dlogger_cache_t *cache, uint32_t id) {
+    dlogger_cache_page_t *page = page_at(cache, id);
+    atomic_store_explicit(&page->id, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&page->used, 0, memory_order_relaxed);
+    atomic_store_explicit(&page->first, atomic_load_explicit(&cache->appended, memory_order_relaxed),
+                          memory_order_relaxed);
+    atomic_store_explicit(&page->id, id, memory_order_release);
+    atomic_store_explicit(&cache->newest, id, memory_order_release);
+}
+
+/**
+ * @brief Copy page `id` into the iterator and index its entries
+ *
+ * @return false if the page is not cached (any more)
+ */
+static bool page_load(dlogger_cache_iter_t *it, uint32_t id) {
+    dlogger_cache_t *cache = it->cache;
+    uint32_t newest = atomic_load_explicit(&cache->newest, memory_order_acquire);
+    if (id == 0 || newest - id >= cache->count) {
+        return false;
+    }
+
+    dlogger_cache_page_t *page = page_at(cache, id);
+    if (atomic_load_explicit(&page->id, memory_order_acquire) != id) {
+        return false;
+    }
+    uint32_t used = atomic_load_explicit(&page->used, memory_order_acquire);
+    if (used > DLOGGER_CACHE_PAGE_SIZE) {
+        return false;
+    }
+    memcpy(it->copy, page_data(cache, id), used);
+
+    // Recycled while copying: this page and all older ones are gone
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&page->id, memory_order_relaxed) != id) {
+        return false;
+    }
+
+    size_t n = 0;
+    for (uint32_t off = 0; off + sizeof(dlogger_cache_rec_t) <= used && n < CACHE_MAX_ENTRIES; ) {
+        const dlogger_cache_rec_t *rec = (const dlogger_cache_rec_t *)(it->copy + off);
+        it->offsets[n++] = (uint16_t)off;
+        off += cache_rec_size(rec->length);
+    }
+    it->page = id;
+    it->remaining = n;
+    return true;
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+esp_err_t dlogger_cache_init(dlogger_cache_t *cache, uint32_t pages) {
+    if (!cache) return ESP_ERR_INVALID_ARG;
+    memset(cache, 0, sizeof(*cache));
+    if (pages == 0) return ESP_OK;
+
+    // Page bookkeeping is atomic and stays in internal RAM; the pages
+    // themselves are plain data
+    size_t bytes = (size_t)pages * DLOGGER_CACHE_PAGE_SIZE;
+    cache->data = (uint8_t *)dlogger_port_alloc_psram(bytes);
+    if (!cache->data) {
+        cache->data = (uint8_t *)malloc(bytes);
+    }
+    cache->pages = (dlogger_cache_page_t *)dlogger_port_alloc_internal(
+        pages * sizeof(dlogger_cache_page_t));
+
+    if (!cache->data || !cache->pages) {
+        dlogger_cache_free(cache);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (uint32_t i = 0; i < pages; i++) {
+        atomic_store(&cache->pages[i].id, 0);
+        atomic_store(&cache->pages[i].used, 0);
+        atomic_store(&cache->pages[i].first, 0);
+    }
+    cache->count = pages;
+    atomic_store(&cache->newest, 0);
+    atomic_store(&cache->appended, 0);
+    return ESP_OK;
+}
+
+void dlogger_cache_free(dlogger_cache_t *cache) {
+    if (!cache) return;
+    free(cache->data);
+    free(cache->pages);
+    cache->data = NULL;
+    cache->pages = NULL;
+    cache->count = 0;
+}
+
+// ============================================================================
+// FLUSH TASK SIDE
+// ============================================================================
+
+void dlogger_cache_append(dlogger_cache_t *cache, uint32_t ring, uint32_t pos, uint32_t seq,
+                          uint32_t timestamp, uint8_t source, uint8_t level,
+                          const char *message, size_t length) {
+    if (!cache->count) return;
+
+    if (length > DLOGGER_CACHE_PAGE_SIZE - sizeof(dlogger_cache_rec_t)) {
+        length = DLOGGER_CACHE_PAGE_SIZE - sizeof(dlogger_cache_rec_t);
+    }
+    uint32_t need = cache_rec_size(length);
+
+    uint32_t id = atomic_load_explicit(&cache->newest, memory_order_relaxed);
+    uint32_t used = (id == 0) ? DLOGGER_CACHE_PAGE_SIZE :
+                    atomic_load_explicit(&page_at(cache, id)->used, memory_order_relaxed);
+    if (used + need > DLOGGER_CACHE_PAGE_SIZE) {
+        id++;
+        if (id == 0) id = 1;    // 0 marks a page being recycled
+        page_start(cache, id);
+        used = 0;
+    }
+
+    // Bytes past `used` are invisible to readers until it is published
+    dlogger_cache_rec_t *rec = (dlogger_cache_rec_t *)(page_data(cache, id) + used);
+    rec->timestamp = timestamp;
+    rec->seq = seq;
+    rec->pos = pos;
+    rec->length = (uint16_t)length;
+    rec->source = source;
+    rec->level = level & 0x0F;
+    rec->ring = ring & 0x0F;
+    memcpy(rec + 1, message, length);
+    atomic_store_explicit(&page_at(cache, id)->used, used + need, memory_order_release);
+    atomic_fetch_add_explicit(&cache->appended, 1, memory_order_release);
+}
+
+// ============================================================================
+// READER SIDE
+// ============================================================================
+
+bool dlogger_cache_iter_begin(dlogger_cache_t *cache, const uint32_t *below,
+                              dlogger_cache_iter_t *it) {
+    memset(it, 0, sizeof(*it));
+    if (!cache->count) return false;
+
+    it->copy = (uint8_t *)malloc(DLOGGER_CACHE_PAGE_SIZE + CACHE_MAX_ENTRIES * sizeof(uint16_t));
+    if (!it->copy) return false;
+    it->offsets = (uint16_t *)(it->copy + DLOGGER_CACHE_PAGE_SIZE);
+    it->cache = cache;
+    it->below = below;
+
+    if (!page_load(it, atomic_load_explicit(&cache->newest, memory_order_acquire))) {
+        it->page = 0;   // Nothing cached yet
+    }
+    return true;
+}
+
+const dlogger_cache_rec_t *dlogger_cache_iter_peek(dlogger_cache_iter_t *it) {
+    while (it->page != 0) {
+        while (it->remaining) {
+            const dlogger_cache_rec_t *rec =
+                (const dlogger_cache_rec_t *)(it->copy + it->offsets[it->remaining - 1]);
+            // Entries from this position on are still in their ring
+            if ((int32_t)(it->below[rec->ring] - rec->pos) > 0) {
+                return rec;
+            }
+            it->remaining--;
+        }
+        if (!page_load(it, it->page - 1)) {
+            it->page = 0;
+        }
+    }
+    return NULL;
+}
+
+void dlogger_cache_iter_end(dlogger_cache_iter_t *it) {
+    free(it->copy);
+    it->copy = NULL;
+    it->offsets = NULL;
+}
+
+// ============================================================================
+// FORWARD READERS
+// ============================================================================
+
+void dlogger_cache_cursor_init(dlogger_cache_t *cache, dlogger_cache_cursor_t *cursor) {
+    // Retry until no append completed between the reads; one in progress
+    // lands exactly at the position read
+    uint32_t index;
+    do {
+        index = atomic_load_explicit(&cache->appended, memory_order_acquire);
+        cursor->page = atomic_load_explicit(&cache->newest, memory_order_acquire);
+        cursor->offset = (cursor->page == 0 || !cache->count) ? 0 :
+            atomic_load_explicit(&page_at(cache, cursor->page)->used, memory_order_acquire);
+        cursor->index = index;
+    } while (atomic_load_explicit(&cache->appended, memory_order_acquire) != index);
+}
+
+/**
+ * @brief Move `cursor` to the oldest page still cached, counting what it missed
+ *
+ * @return false if no page is cached
+ */
+static bool cursor_resync(dlogger_cache_t *cache, dlogger_cache_cursor_t *cursor, uint32_t *lost) {
+    uint32_t newest = atomic_load_explicit(&cache->newest, memory_order_acquire);
+    if (newest == 0) return false;
+    uint32_t oldest = (newest >= cache->count) ? newest - cache->count + 1 : 1;
+    for (uint32_t id = oldest; (int32_t)(newest - id) >= 0; id++) {
+        if (id == 0) continue;
+        dlogger_cache_page_t *page = page_at(cache, id);
+        if (atomic_load_explicit(&page->id, memory_order_acquire) != id) continue;
+        uint32_t first = atomic_load_explicit(&page->first, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&page->id, memory_order_relaxed) != id) continue;
+
+        if ((int32_t)(first - cursor->index) > 0) {
+            *lost += first - cursor->index;
+        }
+        cursor->page = id;
+        cursor->offset = 0;
+        cursor->index = first;
+        return true;
+    }
+    return false;
+}
+
+const dlogger_cache_rec_t *dlogger_cache_read_next(dlogger_cache_t *cache,
+                                                   dlogger_cache_cursor_t *cursor,
+                                                   dlogger_cache_rec_t *rec, char *message,
+                                                   size_t capacity, uint32_t *lost) {
+    if (!cache->count || capacity == 0) return NULL;
+
+    for (;;) {
+        uint32_t newest = atomic_load_explicit(&cache->newest, memory_order_acquire);
+        if (newest == 0) return NULL;
+        if (cursor->page == 0) {
+            // Initialized before the first append: start at the first page
+            cursor->page = 1;
+            cursor->offset = 0;
+        }
+
+        dlogger_cache_page_t *page = page_at(cache, cursor->page);
+        if ((int32_t)(cursor->page - newest) > 0) return NULL;
+        if (newest - cursor->page >= cache->count ||
+            atomic_load_explicit(&page->id, memory_order_acquire) != cursor->page) {
+            if (!cursor_resync(cache, cursor, lost)) return NULL;
+            continue;
+        }
+
+        uint32_t used = atomic_load_explicit(&page->used, memory_order_acquire);
+        if (cursor->offset + sizeof(dlogger_cache_rec_t) <= used) {
+            const uint8_t *at = page_data(cache, cursor->page) + cursor->offset;
+            memcpy(rec, at, sizeof(*rec));
+            size_t length = (rec->length < capacity - 1) ? rec->length : capacity - 1;
+            if (cursor->offset + sizeof(*rec) + length > DLOGGER_CACHE_PAGE_SIZE) {
+                length = 0;     // Torn header; the validation below discards it
+            }
+            memcpy(message, at + sizeof(*rec), length);
+            message[length] = '\0';
+
+            // Recycled while copying: start over from the oldest page left
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&page->id, memory_order_relaxed) != cursor->page) {
+                continue;
+            }
+            cursor->offset += cache_rec_size(rec->length);
+            cursor->index++;
+            return rec;
+        }
+
+        // The flush task only moves on once a page is full
+        if (cursor->page == newest) return NULL;
+        cursor->page = (cursor->page + 1) ? cursor->page + 1 : 1;
+        cursor->offset = 0;
+    }
+}
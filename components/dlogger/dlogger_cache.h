@@ -0,0 +1,163 @@
+#pragma once
+
+/**
+ * @file dlogger_cache.h
+ * @brief RAM cache of recently flushed entries (private to dlogger)
+ *
+ * The flush task consumes records from the core rings, and producers may
+ * reclaim that space as soon as the record is consumed - before or after
+ * its block reaches flash. The cache keeps a copy of every flushed entry
+ * (already rendered) in fixed-size pages, so readers can continue below
+ * the oldest record still in a ring without touching the file system.
+ *
+ * - Only the flush task appends; pages are recycled oldest first.
+ * - Readers copy a page without locking and validate the copy against the
+ *   page id (the page's epoch): a page recycled during the copy is
+ *   discarded, along with every older page.
+ * - Each cached entry remembers its core ring and ring position, so a
+ *   reader that walked a ring from position P takes only the cached
+ *   entries of that ring below P and returns every entry exactly once.
+ * - Forward readers (sinks) follow the cache through their own cursor,
+ *   oldest first. One that falls more than the cache behind skips to the
+ *   oldest page left and learns how many entries it missed.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+
+#define DLOGGER_CACHE_PAGE_SIZE  4096   ///< Bytes per cache page
+
+/**
+ * @brief Cached entry header (16 bytes), followed by `length` message
+ *        bytes (no NUL) and padding to a 4-byte boundary
+ */
+typedef struct {
+    uint32_t timestamp;      ///< Milliseconds since boot
+    uint32_t seq;            ///< Entry sequence number
+    uint32_t pos;            ///< Position of the entry in its core ring
+    uint16_t length;         ///< Message length in bytes
+    uint8_t source;          ///< dlogger_source_t
+    uint8_t level : 4;       ///< dlogger_level_t
+    uint8_t ring : 4;        ///< Core ring the entry was flushed from
+} dlogger_cache_rec_t;
+
+/**
+ * @brief Page bookkeeping (internal RAM)
+ */
+typedef struct {
+    _Atomic uint32_t id;     ///< Page number held, 0 while being recycled
+    _Atomic uint32_t used;   ///< Bytes published
+    _Atomic uint32_t first;  ///< Entries appended to the cache before this page
+} dlogger_cache_page_t;
+
+/**
+ * @brief Cache instance
+ */
+typedef struct {
+    uint8_t *data;                   ///< `count` pages of DLOGGER_CACHE_PAGE_SIZE bytes
+    dlogger_cache_page_t *pages;     ///< Bookkeeping per page
+    uint32_t count;                  ///< Number of pages (0 = cache disabled)
+    _Atomic uint32_t newest;         ///< Number of the page being filled (0 = none yet)
+    _Atomic uint32_t appended;       ///< Entries appended so far (wraps)
+} dlogger_cache_t;
+
+/**
+ * @brief Allocate `pages` pages, preferring PSRAM (0 leaves the cache disabled)
+ */
+esp_err_t dlogger_cache_init(dlogger_cache_t *cache, uint32_t pages);
+
+/**
+ * @brief Free the cache's memory
+ */
+void dlogger_cache_free(dlogger_cache_t *cache);
+
+/**
+ * @brief Copy a flushed entry into the cache (flush task only)
+ *
+ * @param ring Core ring index the entry was consumed from
+ * @param pos Ring position of the entry
+ */
+void dlogger_cache_append(dlogger_cache_t *cache, uint32_t ring, uint32_t pos, uint32_t seq,
+                          uint32_t timestamp, uint8_t source, uint8_t level,
+                          const char *message, size_t length);
+
+/**
+ * @brief Message bytes of a cached entry
+ */
+static inline const char *dlogger_cache_rec_message(const dlogger_cache_rec_t *rec) {
+    return (const char *)(rec + 1);
+}
+
+/**
+ * @brief Iterator over the cached entries, newest first (see dlogger_cache_iter_begin())
+ */
+typedef struct {
+    dlogger_cache_t *cache;
+    const uint32_t *below;   ///< Per-ring position bound (entries at or above it are skipped)
+    uint8_t *copy;           ///< Private copy of the current page
+    uint16_t *offsets;       ///< Entry offsets in `copy`
+    uint32_t page;           ///< Number of the page in `copy`
+    size_t remaining;        ///< Entries of `copy` not returned yet
+} dlogger_cache_iter_t;
+
+/**
+ * @brief Start visiting the cached entries, newest first
+ *
+ * @param below Per-ring bound: only entries of ring i at positions before
+ *              below[i] are returned; must stay valid until the end
+ * @return false if the cache is disabled or the page copy cannot be allocated
+ */
+bool dlogger_cache_iter_begin(dlogger_cache_t *cache, const uint32_t *below,
+                              dlogger_cache_iter_t *it);
+
+/**
+ * @brief Current entry of the iterator (NULL when exhausted)
+ *
+ * Valid until dlogger_cache_iter_next() or dlogger_cache_iter_end().
+ */
+const dlogger_cache_rec_t *dlogger_cache_iter_peek(dlogger_cache_iter_t *it);
+
+/**
+ * @brief Advance the iterator
+ */
+static inline void dlogger_cache_iter_next(dlogger_cache_iter_t *it) {
+    if (it->remaining) it->remaining--;
+}
+
+/**
+ * @brief Free the iterator
+ */
+void dlogger_cache_iter_end(dlogger_cache_iter_t *it);
+
+/**
+ * @brief Position of a forward reader (see dlogger_cache_read_next())
+ */
+typedef struct {
+    uint32_t page;           ///< Page number being read
+    uint32_t offset;         ///< Byte offset of the next entry in `page`
+    uint32_t index;          ///< Entries appended before the next entry
+} dlogger_cache_cursor_t;
+
+/**
+ * @brief Place `cursor` after the newest cached entry (where the next
+ *        appended entry will go)
+ */
+void dlogger_cache_cursor_init(dlogger_cache_t *cache, dlogger_cache_cursor_t *cursor);
+
+/**
+ * @brief Copy the entry at `cursor` and advance past it, oldest first
+ *
+ * Lock-free; the copy is validated against the page id like the iterator's.
+ *
+ * @param message Receives the NUL-terminated text, cut to `capacity - 1` bytes
+ * @param lost Incremented by the entries recycled before the cursor reached them
+ * @return NULL if the cursor is at the newest entry (or the cache is disabled),
+ *         else `rec`, filled in
+ */
+const dlogger_cache_rec_t *dlogger_cache_read_next(dlogger_cache_t *cache,
+                                                   dlogger_cache_cursor_t *cursor,
+                                                   dlogger_cache_rec_t *rec, char *message,
+                                                   size_t capacity, uint32_t *lost);
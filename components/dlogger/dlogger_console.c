@@ -0,0 +1,134 @@
+#include "dlogger_console.h"
+#include "dlogger_port.h"
+#include "dlogger_ring.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/task.h"
+
+#define CONSOLE_TASK_STACK   3072
+#define CONSOLE_TASK_PRIO    (tskIDLE_PRIORITY + 1)
+
+_Static_assert((DLOGGER_CONSOLE_QUEUE_SIZE & (DLOGGER_CONSOLE_QUEUE_SIZE - 1)) == 0,
+               "CONFIG_DLOGGER_CONSOLE_QUEUE_KB must be a power of two");
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+static dlogger_ring_t console_ring;
+static TaskHandle_t console_task;
+static _Atomic bool console_running;     ///< Producers queue lines while set
+static _Atomic bool console_idle;        ///< Task is about to sleep, the next line wakes it
+static _Atomic uint32_t console_dropped;
+
+// ============================================================================
+// CONSOLE TASK
+// ============================================================================
+
+/**
+ * @brief Print every committed line, in order
+ */
+static void console_drain(void) {
+    bool wrote = false;
+    const dlogger_rec_t *rec;
+    while ((rec = dlogger_ring_peek(&console_ring)) != NULL) {
+        if (!dlogger_ring_take(&console_ring)) continue;   // Lines are never evicted
+        fwrite(dlogger_rec_message(rec), 1, rec->length, stdout);
+        dlogger_ring_consume(&console_ring);
+        wrote = true;
+    }
+    if (wrote) {
+        fflush(stdout);
+    }
+}
+
+/**
+ * @brief Console task: prints queued lines, sleeps while the queue is empty
+ */
+static void console_task_func(void *arg) {
+    while (atomic_load(&console_running)) {
+        console_drain();
+
+        // Announce the sleep, then look once more: a line committed before
+        // the announcement is seen here, one committed after it notifies
+        atomic_store(&console_idle, true);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (dlogger_ring_peek(&console_ring)) {
+            atomic_store(&console_idle, false);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    // Lines queued before deinit still reach the console
+    console_drain();
+    console_task = NULL;
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// PUBLIC (PRIVATE TO DLOGGER) API
+// ============================================================================
+
+esp_err_t dlogger_console_init(void) {
+    if (DLOGGER_CONSOLE_QUEUE_SIZE == 0 || console_task) return ESP_OK;
+
+    esp_err_t ret = dlogger_ring_init(&console_ring, DLOGGER_CONSOLE_QUEUE_SIZE);
+    if (ret != ESP_OK) return ret;
+
+    atomic_store(&console_running, true);
+    if (xTaskCreatePinnedToCore(console_task_func, "dlogger_con", CONSOLE_TASK_STACK, NULL,
+                                CONSOLE_TASK_PRIO, &console_task,
+                                DLOGGER_PORT_FLUSH_CORE) != pdPASS) {
+        atomic_store(&console_running, false);
+        console_task = NULL;
+        dlogger_ring_deinit(&console_ring);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void dlogger_console_write(const char *text, size_t length) {
+    TaskHandle_t task = console_task;
+    if (!task || !atomic_load_explicit(&console_running, memory_order_acquire)) {
+        fwrite(text, 1, length, stdout);
+        return;
+    }
+
+    dlogger_ring_resv_t resv;
+    if (!dlogger_ring_reserve(&console_ring, length, &resv)) {
+        atomic_fetch_add_explicit(&console_dropped, 1, memory_order_relaxed);
+        return;
+    }
+    resv.rec->timestamp = 0;
+    resv.rec->length = (uint16_t)length;
+    resv.rec->source = 0;
+    resv.rec->level = 0;
+    dlogger_rec_set_seq(resv.rec, 0);
+    memcpy(dlogger_rec_message(resv.rec), text, length);
+    dlogger_ring_commit(&console_ring, &resv);
+
+    // Only the first line after the task announced its sleep notifies
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&console_idle, memory_order_relaxed) &&
+        atomic_exchange(&console_idle, false)) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void dlogger_console_deinit(void) {
+    if (!console_task) return;
+
+    // New lines go straight to stdout from here on
+    atomic_store(&console_running, false);
+    xTaskNotifyGive(console_task);
+    while (console_task) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    dlogger_ring_deinit(&console_ring);
+}
+
+uint32_t dlogger_console_dropped(void) {
+    return atomic_load_explicit(&console_dropped, memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * @file dlogger_console.h
+ * @brief Asynchronous console output of hooked ESP logs (private to dlogger)
+ *
+ * The ESP log hook formats a line once and hands the same text to the log
+ * ring and to the console. Printing it in the calling task would make every
+ * ESP_LOGx wait for the UART, so lines are queued instead in a small
+ * dlogger_ring (same lock-free reserve/commit as the log rings) and written
+ * by a low-priority console task.
+ *
+ * - Producers never wait: a line that does not fit in the queue is dropped
+ *   from the console (it is still logged) and counted.
+ * - Without the task (before init, after deinit, or with
+ *   CONFIG_DLOGGER_CONSOLE_QUEUE_KB = 0) lines are written synchronously.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#define DLOGGER_CONSOLE_QUEUE_SIZE  (CONFIG_DLOGGER_CONSOLE_QUEUE_KB * 1024)  ///< Bytes, 0 = synchronous
+#define DLOGGER_CONSOLE_LINE_MAX    256    ///< Longest console line (incl. NUL), longer ones are cut
+
+/**
+ * @brief Allocate the queue and start the console task
+ *
+ * @return ESP_OK (also when the queue is disabled), ESP_ERR_NO_MEM or
+ *         ESP_FAIL; on error output stays synchronous
+ */
+esp_err_t dlogger_console_init(void);
+
+/**
+ * @brief Print a formatted line (any task, never waits for the UART)
+ */
+void dlogger_console_write(const char *text, size_t length);
+
+/**
+ * @brief Print everything queued, stop the task and free the queue
+ */
+void dlogger_console_deinit(void);
+
+/**
+ * @brief Lines dropped from the console because the queue was full
+ */
+uint32_t dlogger_console_dropped(void);
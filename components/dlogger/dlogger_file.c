@@ -0,0 +1,779 @@
+#include "dlogger_file.h"
+#include "dlogger_lz4.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+#include "storage_io.h"
+
+#define BLOCK_PAYLOAD_MAX  DLOGGER_BLOCK_PAYLOAD_MAX
+#define SEGMENT_FILL_BYTE  0xFF    // Erased-flash value, never a valid header
+
+static const char *TAG = "DLOGGER_FILE";
+
+// ============================================================================
+// BLOCK WRITER
+// ============================================================================
+
+/**
+ * @brief Start a new, empty pending block
+ */
+static void writer_reset(dlogger_block_writer_t *writer) {
+    writer->used = 0;
+    writer->stored = 0;
+    writer->flags = 0;
+    writer->count = 0;
+    writer->ts_min = UINT32_MAX;
+    writer->ts_max = 0;
+    writer->sources = 0;
+    writer->levels = 0;
+}
+
+esp_err_t dlogger_block_writer_init(dlogger_block_writer_t *writer, bool compress) {
+    if (!writer) return ESP_ERR_INVALID_ARG;
+
+    writer->buf = (uint8_t*)malloc(DLOGGER_BLOCK_SIZE);
+    writer->packed = compress ? (uint8_t*)malloc(DLOGGER_BLOCK_SIZE) : NULL;
+    writer->lz4_table = compress ? (uint16_t*)malloc(DLOGGER_LZ4_TABLE_SIZE) : NULL;
+    if (!writer->buf || (compress && (!writer->packed || !writer->lz4_table))) {
+        dlogger_block_writer_free(writer);
+        return ESP_ERR_NO_MEM;
+    }
+
+    writer_reset(writer);
+    return ESP_OK;
+}
+
+void dlogger_block_writer_free(dlogger_block_writer_t *writer) {
+    if (!writer) return;
+    free(writer->buf);
+    free(writer->packed);
+    free(writer->lz4_table);
+    writer->buf = NULL;
+    writer->packed = NULL;
+    writer->lz4_table = NULL;
+    writer_reset(writer);
+}
+
+bool dlogger_block_append(dlogger_block_writer_t *writer, uint32_t timestamp, uint32_t seq,
+                          uint8_t source, uint8_t level,
+                          const char *message, size_t length) {
+    size_t rec_len = sizeof(dlogger_record_hdr_t) + length;
+
+    if (writer->stored || !dlogger_block_fits(writer, length)) {
+        return false;
+    }
+
+    dlogger_record_hdr_t rec = {
+        .timestamp = timestamp,
+        .source = source,
+        .level = level,
+        .length = (uint16_t)length,
+        .seq = seq,
+    };
+
+    uint8_t *dst = writer->buf + sizeof(dlogger_block_hdr_t) + writer->used;
+    memcpy(dst, &rec, sizeof(rec));
+    memcpy(dst + sizeof(rec), message, length);
+
+    writer->used += rec_len;
+    writer->count++;
+
+    // Summary for the sparse index
+    if (timestamp < writer->ts_min) writer->ts_min = timestamp;
+    if (timestamp > writer->ts_max) writer->ts_max = timestamp;
+    writer->sources |= (uint8_t)(1u << (source & 7));
+    writer->levels |= (uint8_t)(1u << (level & 7));
+    return true;
+}
+
+void dlogger_block_seal(dlogger_block_writer_t *writer) {
+    if (writer->stored || writer->count == 0) return;
+
+    writer->stored = writer->used;
+    writer->flags = 0;
+    if (writer->packed) {
+        // Kept only if strictly smaller; text usually shrinks 2-4x
+        size_t packed = dlogger_lz4_compress(writer->buf + sizeof(dlogger_block_hdr_t), writer->used,
+                                             writer->packed + sizeof(dlogger_block_hdr_t),
+                                             writer->used - 1, writer->lz4_table);
+        if (packed) {
+            writer->stored = packed;
+            writer->flags = DLOGGER_BLOCK_FLAG_LZ4;
+        }
+    }
+}
+
+const uint8_t *dlogger_block_finish(dlogger_block_writer_t *writer, uint32_t sequence,
+                                    size_t *len) {
+    dlogger_block_seal(writer);
+    uint8_t *block = (writer->flags & DLOGGER_BLOCK_FLAG_LZ4) ? writer->packed : writer->buf;
+    const uint8_t *payload = block + sizeof(dlogger_block_hdr_t);
+    dlogger_block_hdr_t hdr = {
+        .magic = DLOGGER_BLOCK_MAGIC,
+        .version = DLOGGER_BLOCK_VERSION,
+        .flags = writer->flags,
+        .record_count = writer->count,
+        .payload_len = (uint32_t)writer->stored,
+        .crc32 = esp_rom_crc32_le(sequence, payload, (uint32_t)writer->stored),
+    };
+    memcpy(block, &hdr, sizeof(hdr));
+
+    *len = sizeof(hdr) + writer->stored;
+    return block;
+}
+
+void dlogger_block_reset(dlogger_block_writer_t *writer) {
+    writer_reset(writer);
+}
+
+esp_err_t dlogger_block_write(dlogger_block_writer_t *writer, FILE *file, uint32_t sequence) {
+    if (writer->count == 0) return ESP_OK;
+
+    size_t total;
+    const uint8_t *block = dlogger_block_finish(writer, sequence, &total);
+    size_t written = file ? fwrite(block, 1, total, file) : 0;
+
+    writer_reset(writer);
+    return (written == total) ? ESP_OK : ESP_FAIL;
+}
+
+// ============================================================================
+// SEGMENT FORMAT
+// ============================================================================
+
+void dlogger_segment_path(const char *dir, uint32_t index, char *buf, size_t buf_len) {
+    snprintf(buf, buf_len, "%s/log%u.dlog", dir, (unsigned)index);
+}
+
+/**
+ * @brief Read and validate the segment header at the start of `file`
+ */
+static bool segment_hdr_read(FILE *file, dlogger_segment_hdr_t *hdr) {
+    if (fseek(file, 0, SEEK_SET) != 0 ||
+        fread(hdr, 1, sizeof(*hdr), file) != sizeof(*hdr)) {
+        return false;
+    }
+    return hdr->magic == DLOGGER_SEGMENT_MAGIC &&
+           hdr->version == DLOGGER_SEGMENT_VERSION &&
+           hdr->crc32 == esp_rom_crc32_le(0, (const uint8_t*)hdr,
+                                          offsetof(dlogger_segment_hdr_t, crc32));
+}
+
+/**
+ * @brief Read the block at the current position if it belongs to the chain
+ *
+ * @param sequence Sequence of the segment (CRC seed)
+ * @param limit Bytes left in the segment from the current position
+ * @return false at the end of the chain
+ */
+static bool segment_block_read(FILE *file, uint32_t sequence, uint32_t limit,
+                               dlogger_block_hdr_t *hdr, uint8_t *payload) {
+    return limit >= sizeof(*hdr) &&
+           fread(hdr, 1, sizeof(*hdr), file) == sizeof(*hdr) &&
+           hdr->magic == DLOGGER_BLOCK_MAGIC &&
+           hdr->version >= DLOGGER_BLOCK_VERSION_MIN && hdr->version <= DLOGGER_BLOCK_VERSION &&
+           (hdr->flags & ~DLOGGER_BLOCK_FLAG_LZ4) == 0 &&
+           hdr->payload_len <= BLOCK_PAYLOAD_MAX &&
+           hdr->payload_len <= limit - sizeof(*hdr) &&
+           fread(payload, 1, hdr->payload_len, file) == hdr->payload_len &&
+           esp_rom_crc32_le(sequence, payload, hdr->payload_len) == hdr->crc32;
+}
+
+/**
+ * @brief Record header bytes in a block of `version`
+ */
+static inline size_t record_hdr_size(uint8_t version) {
+    return (version >= DLOGGER_BLOCK_VERSION_SEQ) ? sizeof(dlogger_record_hdr_t)
+                                                  : offsetof(dlogger_record_hdr_t, seq);
+}
+
+/**
+ * @brief Records of a block read by segment_block_read()
+ *
+ * Compressed payloads are expanded into `raw` (BLOCK_PAYLOAD_MAX bytes), one
+ * block at a time as the chain is read, so readers never hold more than a
+ * block whatever the segment size.
+ *
+ * @param len Set to the record bytes
+ * @return The records, or NULL if the payload does not decompress
+ */
+static const uint8_t *block_records(const dlogger_block_hdr_t *hdr, const uint8_t *payload,
+                                    uint8_t *raw, size_t *len) {
+    if (!(hdr->flags & DLOGGER_BLOCK_FLAG_LZ4)) {
+        *len = hdr->payload_len;
+        return payload;
+    }
+    *len = dlogger_lz4_decompress(payload, hdr->payload_len, raw, BLOCK_PAYLOAD_MAX);
+    return *len ? raw : NULL;
+}
+
+// ============================================================================
+// SEGMENTED STORE
+// ============================================================================
+
+/**
+ * @brief Index entries of segment `index`
+ */
+static inline dlogger_index_entry_t *store_entries(const dlogger_store_t *store, uint32_t index) {
+    return &store->entries[index * store->strides];
+}
+
+/**
+ * @brief Record a (re)started segment; its old index entries no longer apply
+ */
+static void store_set_sequence(dlogger_store_t *store, uint32_t index, uint32_t sequence) {
+    if (store->sequences[index] != sequence) {
+        store->sequences[index] = sequence;
+        memset(store_entries(store, index), 0, store->strides * sizeof(dlogger_index_entry_t));
+    }
+}
+
+/**
+ * @brief Fold a block written at `offset` into the sparse index
+ */
+static void store_index_block(dlogger_store_t *store, uint32_t offset,
+                              const dlogger_block_writer_t *summary) {
+    dlogger_index_entry_t *entry =
+        &store_entries(store, atomic_load(&store->index))[offset / DLOGGER_INDEX_STRIDE];
+
+    if (entry->offset == 0) {
+        entry->offset = offset;
+        entry->ts_min = summary->ts_min;
+        entry->ts_max = summary->ts_max;
+        entry->sources = summary->sources;
+        entry->levels = summary->levels;
+        return;
+    }
+    if (summary->ts_min < entry->ts_min) entry->ts_min = summary->ts_min;
+    if (summary->ts_max > entry->ts_max) entry->ts_max = summary->ts_max;
+    entry->sources |= summary->sources;
+    entry->levels |= summary->levels;
+}
+
+/**
+ * @brief Create (or resize) a segment file filled with SEGMENT_FILL_BYTE
+ *
+ * Only done once per segment: afterwards blocks overwrite it in place.
+ */
+static esp_err_t segment_preallocate(const char *path, uint32_t size) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return ESP_FAIL;
+
+    uint8_t *chunk = (uint8_t*)malloc(DLOGGER_BLOCK_SIZE);
+    if (!chunk) {
+        fclose(file);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(chunk, SEGMENT_FILL_BYTE, DLOGGER_BLOCK_SIZE);
+
+    esp_err_t ret = ESP_OK;
+    for (uint32_t done = 0; done < size; done += DLOGGER_BLOCK_SIZE) {
+        size_t n = (size - done < DLOGGER_BLOCK_SIZE) ? size - done : DLOGGER_BLOCK_SIZE;
+        if (fwrite(chunk, 1, n, file) != n) {
+            ret = ESP_FAIL;
+            break;
+        }
+    }
+
+    free(chunk);
+    fclose(file);
+    if (ret != ESP_OK) {
+        // Leave no short segment behind; it would be recreated anyway
+        remove(path);
+    }
+    return ret;
+}
+
+/**
+ * @brief Open segment `index` for in-place writing
+ */
+static FILE *segment_open(const dlogger_store_t *store, uint32_t index) {
+    char path[DLOGGER_SEGMENT_PATH_MAX];
+    dlogger_segment_path(store->dir, index, path, sizeof(path));
+
+    FILE *file = fopen(path, "r+b");
+    if (file) {
+        // Whole blocks are written with one fwrite; stdio buffering
+        // would only add a copy
+        setvbuf(file, NULL, _IONBF, 0);
+    }
+    return file;
+}
+
+/**
+ * @brief Completion of a background write (I/O task)
+ */
+static void store_io_done(esp_err_t result, void *user_ctx) {
+    if (result != ESP_OK) {
+        dlogger_store_t *store = (dlogger_store_t*)user_ctx;
+        atomic_fetch_add_explicit(&store->io_failures, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Write `len` bytes at `offset` of segment `index` (the open one)
+ *
+ * With `async` the bytes are copied to the storage I/O service, which
+ * merges consecutive blocks into one write; otherwise a single fwrite.
+ */
+static esp_err_t store_put(dlogger_store_t *store, uint32_t index, uint32_t offset,
+                           const void *data, size_t len) {
+    if (store->async) {
+        char path[DLOGGER_SEGMENT_PATH_MAX];
+        dlogger_segment_path(store->dir, index, path, sizeof(path));
+        return storage_io_write_at(path, offset, data, len, store_io_done, store);
+    }
+    if (fseek(store->file, offset, SEEK_SET) != 0 || fwrite(data, 1, len, store->file) != len) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Make segment `index` active under a new sequence number
+ *
+ * The header is the only write besides the blocks themselves; blocks of the
+ * segment's previous use no longer match the sequence and end the chain.
+ */
+static esp_err_t store_start_segment(dlogger_store_t *store, uint32_t index) {
+    dlogger_store_close(store);
+
+    FILE *file = segment_open(store, index);
+    if (!file) return ESP_FAIL;
+
+    dlogger_segment_hdr_t hdr = {
+        .magic = DLOGGER_SEGMENT_MAGIC,
+        .version = DLOGGER_SEGMENT_VERSION,
+        .reserved = 0,
+        .index = (uint16_t)index,
+        .sequence = store->sequence + 1,
+        .size = store->size,
+    };
+    hdr.crc32 = esp_rom_crc32_le(0, (const uint8_t*)&hdr, offsetof(dlogger_segment_hdr_t, crc32));
+
+    store->file = file;
+    if (store_put(store, index, 0, &hdr, sizeof(hdr)) != ESP_OK) {
+        dlogger_store_close(store);
+        return ESP_FAIL;
+    }
+
+    store->sequence = hdr.sequence;
+    store->offset = sizeof(hdr);
+    store_set_sequence(store, index, hdr.sequence);
+    atomic_store(&store->index, index);
+    return ESP_OK;
+}
+
+/**
+ * @brief Find the end of the block chain in the active segment
+ */
+static esp_err_t store_find_end(dlogger_store_t *store) {
+    uint8_t *payload = (uint8_t*)malloc(BLOCK_PAYLOAD_MAX);
+    if (!payload) return ESP_ERR_NO_MEM;
+
+    uint32_t offset = sizeof(dlogger_segment_hdr_t);
+    dlogger_block_hdr_t hdr;
+    fseek(store->file, offset, SEEK_SET);
+    while (segment_block_read(store->file, store->sequence, store->size - offset,
+                              &hdr, payload)) {
+        offset += sizeof(hdr) + hdr.payload_len;
+    }
+
+    free(payload);
+    store->offset = offset;
+    return ESP_OK;
+}
+
+esp_err_t dlogger_store_open(dlogger_store_t *store, const char *dir,
+                             uint32_t count, uint32_t size) {
+    if (!store || !dir || count == 0 ||
+        size < sizeof(dlogger_segment_hdr_t) + DLOGGER_BLOCK_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The files are read below: let queued blocks land first (reopen)
+    dlogger_store_settle(store);
+
+    // The index survives a reopen after an I/O error
+    uint32_t strides = (size + DLOGGER_INDEX_STRIDE - 1) / DLOGGER_INDEX_STRIDE;
+    if (!store->entries || store->count != count || store->strides != strides) {
+        dlogger_store_free(store);
+        store->sequences = (uint32_t*)calloc(count, sizeof(uint32_t));
+        store->entries = (dlogger_index_entry_t*)calloc(count * strides,
+                                                        sizeof(dlogger_index_entry_t));
+        if (!store->sequences || !store->entries) {
+            dlogger_store_free(store);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    store->dir = dir;
+    store->count = count;
+    store->size = size;
+    store->strides = strides;
+    store->file = NULL;
+    store->sequence = 0;
+    store->offset = 0;
+
+    // Pick the most recently started segment, preallocating as we go
+    bool found = false;
+    uint32_t active = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        char path[DLOGGER_SEGMENT_PATH_MAX];
+        dlogger_segment_path(dir, i, path, sizeof(path));
+
+        FILE *file = fopen(path, "rb");
+        long length = -1;
+        dlogger_segment_hdr_t hdr;
+        bool valid = false;
+        if (file) {
+            if (fseek(file, 0, SEEK_END) == 0) {
+                length = ftell(file);
+            }
+            valid = (length == (long)size) && segment_hdr_read(file, &hdr) &&
+                    hdr.index == i && hdr.size == size;
+            fclose(file);
+        }
+
+        if (length != (long)size) {
+            ESP_LOGI(TAG, "Preallocating %s (%u bytes)", path, (unsigned)size);
+            esp_err_t ret = segment_preallocate(path, size);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to preallocate %s", path);
+                return ret;
+            }
+        }
+
+        store_set_sequence(store, i, valid ? hdr.sequence : 0);
+
+        // Sequence numbers are compared modulo 2^32
+        if (valid && (!found || (int32_t)(hdr.sequence - store->sequence) > 0)) {
+            found = true;
+            active = i;
+            store->sequence = hdr.sequence;
+        }
+    }
+
+    if (!found) {
+        return store_start_segment(store, 0);
+    }
+
+    // Resume after the last intact block of the active segment
+    store->file = segment_open(store, active);
+    if (!store->file) return ESP_FAIL;
+    atomic_store(&store->index, active);
+    return store_find_end(store);
+}
+
+esp_err_t dlogger_store_write(dlogger_store_t *store, dlogger_block_writer_t *writer) {
+    if (writer->count == 0) return ESP_OK;
+
+    // Compress first: rotation is decided on the bytes actually stored
+    dlogger_block_seal(writer);
+    if (store->file && store->offset + dlogger_block_bytes(writer) > store->size) {
+        uint32_t next = (atomic_load(&store->index) + 1) % store->count;
+        if (store_start_segment(store, next) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to start segment %u", (unsigned)next);
+        }
+    }
+
+    if (!store->file) {
+        dlogger_block_reset(writer);   // Drops the block
+        return ESP_FAIL;
+    }
+
+    dlogger_block_writer_t summary = *writer;
+    size_t bytes;
+    const uint8_t *block = dlogger_block_finish(writer, store->sequence, &bytes);
+    esp_err_t ret = store_put(store, atomic_load(&store->index), store->offset, block, bytes);
+    dlogger_block_reset(writer);
+    if (ret != ESP_OK) {
+        // The offset is kept: the next block overwrites whatever was torn
+        dlogger_store_close(store);
+        return ESP_FAIL;
+    }
+
+    store_index_block(store, store->offset, &summary);
+    store->offset += (uint32_t)bytes;
+    store->written += (uint32_t)bytes;
+    return ESP_OK;
+}
+
+esp_err_t dlogger_store_sync(dlogger_store_t *store) {
+    if (!store->file) return ESP_ERR_INVALID_STATE;
+    if (store->async) {
+        return storage_io_drain(true);
+    }
+    if (fflush(store->file) != 0 || fsync(fileno(store->file)) != 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void dlogger_store_settle(const dlogger_store_t *store) {
+    if (store->async) {
+        storage_io_drain(false);
+    }
+}
+
+uint32_t dlogger_store_take_failures(dlogger_store_t *store) {
+    if (atomic_load_explicit(&store->io_failures, memory_order_relaxed) ==
+        store->io_failures_seen) {
+        return 0;
+    }
+
+    dlogger_store_settle(store);
+    uint32_t failures = atomic_load_explicit(&store->io_failures, memory_order_relaxed);
+    uint32_t count = failures - store->io_failures_seen;
+    store->io_failures_seen = failures;
+    return count;
+}
+
+void dlogger_store_close(dlogger_store_t *store) {
+    if (store && store->file) {
+        fclose(store->file);
+        store->file = NULL;
+    }
+}
+
+void dlogger_store_free(dlogger_store_t *store) {
+    if (!store) return;
+    dlogger_store_settle(store);
+    dlogger_store_close(store);
+    free(store->sequences);
+    free(store->entries);
+    store->sequences = NULL;
+    store->entries = NULL;
+}
+
+/**
+ * @brief Whether an index entry may hold records matching `filter`
+ */
+static bool index_entry_matches(const dlogger_index_entry_t *entry, const dlogger_file_filter_t *filter) {
+    return entry->offset != 0 &&
+           entry->ts_max >= filter->t_from && entry->ts_min <= filter->t_to &&
+           (entry->sources & filter->source_mask) != 0 &&
+           (entry->levels & filter->level_mask) != 0;
+}
+
+size_t dlogger_store_plan(const dlogger_store_t *store, const dlogger_file_filter_t *filter,
+                          dlogger_range_t *ranges) {
+    if (!store->entries) return 0;
+
+    size_t n = 0;
+    uint32_t active = atomic_load(&store->index);
+
+    // Round-robin order: the segment after the active one is the oldest
+    for (uint32_t k = 1; k <= store->count; k++) {
+        uint32_t seg = (active + k) % store->count;
+        if (store->sequences[seg] == 0) continue;
+
+        const dlogger_index_entry_t *entries = store_entries(store, seg);
+        for (uint32_t s = 0; s < store->strides; s++) {
+            if (!index_entry_matches(&entries[s], filter)) continue;
+
+            uint32_t stride_end = (s + 1) * DLOGGER_INDEX_STRIDE;
+            if (n > 0 && ranges[n - 1].segment == seg &&
+                ranges[n - 1].end == s * DLOGGER_INDEX_STRIDE) {
+                // Adjacent stride: one sequential read
+                ranges[n - 1].end = stride_end;
+                continue;
+            }
+            ranges[n++] = (dlogger_range_t){
+                .segment = seg,
+                .sequence = store->sequences[seg],
+                .offset = entries[s].offset,
+                .end = stride_end,
+            };
+        }
+    }
+    return n;
+}
+
+// ============================================================================
+// READER (TEXT RENDERING HAPPENS ONLY ON THIS PATH)
+// ============================================================================
+
+/**
+ * @brief Whether a persisted record passes `filter`
+ */
+static inline bool record_matches(const dlogger_record_hdr_t *rec, const dlogger_file_filter_t *filter) {
+    return rec->timestamp >= filter->t_from && rec->timestamp <= filter->t_to &&
+           rec->source < 32 && (filter->source_mask & (1u << rec->source)) &&
+           rec->level < 32 && (filter->level_mask & (1u << rec->level));
+}
+
+/**
+ * @brief Walk the records of one CRC-checked payload
+ *
+ * @return false if the callback asked to stop
+ */
+static bool decode_payload(const dlogger_block_hdr_t *hdr, const uint8_t *payload, size_t len,
+                           const dlogger_file_filter_t *filter,
+                           dlogger_entry_cb_t callback, void *user_ctx) {
+    dlogger_entry_t entry;
+    size_t rec_size = record_hdr_size(hdr->version);
+    size_t off = 0;
+
+    for (uint16_t i = 0; i < hdr->record_count; i++) {
+        dlogger_record_hdr_t rec;
+        if (off + rec_size > len) break;
+        memcpy(&rec, payload + off, rec_size);
+        off += rec_size;
+        if (off + rec.length > len) break;
+
+        if (filter && !record_matches(&rec, filter)) {
+            off += rec.length;
+            continue;
+        }
+
+        size_t copy = rec.length;
+        if (copy > sizeof(entry.message) - 1) {
+            copy = sizeof(entry.message) - 1;
+        }
+        entry.timestamp = rec.timestamp;
+        entry.source = rec.source;
+        entry.level = rec.level;
+        memcpy(entry.message, payload + off, copy);
+        entry.message[copy] = '\0';
+        off += rec.length;
+
+        if (!callback(&entry, user_ctx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t dlogger_file_read(const char *path, dlogger_entry_cb_t callback, void *user_ctx) {
+    if (!path || !callback) return ESP_ERR_INVALID_ARG;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return ESP_ERR_NOT_FOUND;
+
+    dlogger_segment_hdr_t seg;
+    if (!segment_hdr_read(file, &seg)) {
+        // Preallocated but never started: nothing to decode
+        fclose(file);
+        return ESP_OK;
+    }
+
+    // Stored payload, then room for it decompressed
+    uint8_t *payload = (uint8_t*)malloc(2 * BLOCK_PAYLOAD_MAX);
+    if (!payload) {
+        fclose(file);
+        return ESP_ERR_NO_MEM;
+    }
+
+    dlogger_block_hdr_t hdr;
+    uint32_t offset = sizeof(seg);
+    while (segment_block_read(file, seg.sequence, seg.size - offset, &hdr, payload)) {
+        offset += sizeof(hdr) + hdr.payload_len;
+        size_t len;
+        const uint8_t *records = block_records(&hdr, payload, payload + BLOCK_PAYLOAD_MAX, &len);
+        if (records && !decode_payload(&hdr, records, len, NULL, callback, user_ctx)) {
+            break;
+        }
+    }
+
+    free(payload);
+    fclose(file);
+    return ESP_OK;
+}
+
+bool dlogger_store_read_range(const char *dir, const dlogger_range_t *range,
+                              const dlogger_file_filter_t *filter,
+                              dlogger_entry_cb_t callback, void *user_ctx) {
+    char path[DLOGGER_SEGMENT_PATH_MAX];
+    dlogger_segment_path(dir, range->segment, path, sizeof(path));
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return true;
+
+    bool keep_going = true;
+    dlogger_segment_hdr_t seg;
+    uint8_t *payload = NULL;
+    if (!segment_hdr_read(file, &seg) || seg.sequence != range->sequence ||
+        range->offset >= seg.size || fseek(file, range->offset, SEEK_SET) != 0) {
+        // Recycled since the plan was made: the range is gone
+        goto done;
+    }
+
+    payload = (uint8_t*)malloc(2 * BLOCK_PAYLOAD_MAX);
+    if (!payload) goto done;
+
+    // Seek straight to the indexed block and stop at the end of the range
+    dlogger_block_hdr_t hdr;
+    uint32_t offset = range->offset;
+    while (offset < range->end &&
+           segment_block_read(file, seg.sequence, seg.size - offset, &hdr, payload)) {
+        offset += sizeof(hdr) + hdr.payload_len;
+        size_t len;
+        const uint8_t *records = block_records(&hdr, payload, payload + BLOCK_PAYLOAD_MAX, &len);
+        if (records && !decode_payload(&hdr, records, len, filter, callback, user_ctx)) {
+            keep_going = false;
+            break;
+        }
+    }
+
+done:
+    free(payload);
+    fclose(file);
+    return keep_going;
+}
+
+void dlogger_store_mark_written(dlogger_store_t *store, uint32_t sequence, uint32_t offset,
+                                uint32_t first, uint32_t count, uint8_t *written) {
+    if (!store->sequences) return;
+
+    // The segments are read through their paths: let every block land first
+    dlogger_store_settle(store);
+    if (store->file) fflush(store->file);
+
+    // Stored payload, then room for it decompressed
+    uint8_t *payload = (uint8_t*)malloc(2 * BLOCK_PAYLOAD_MAX);
+    if (!payload) return;
+
+    for (uint32_t i = 0; i < store->count; i++) {
+        // Sequence numbers are compared modulo 2^32
+        if (store->sequences[i] == 0 || (int32_t)(store->sequences[i] - sequence) < 0) continue;
+
+        char path[DLOGGER_SEGMENT_PATH_MAX];
+        dlogger_segment_path(store->dir, i, path, sizeof(path));
+        FILE *file = fopen(path, "rb");
+        if (!file) continue;
+
+        dlogger_segment_hdr_t seg;
+        uint32_t pos = (store->sequences[i] == sequence) ? offset : sizeof(seg);
+        if (!segment_hdr_read(file, &seg) || pos >= seg.size ||
+            fseek(file, pos, SEEK_SET) != 0) {
+            fclose(file);
+            continue;
+        }
+
+        dlogger_block_hdr_t hdr;
+        while (segment_block_read(file, seg.sequence, seg.size - pos, &hdr, payload)) {
+            pos += sizeof(hdr) + hdr.payload_len;
+            size_t len;
+            const uint8_t *records = block_records(&hdr, payload, payload + BLOCK_PAYLOAD_MAX, &len);
+            if (!records || hdr.version < DLOGGER_BLOCK_VERSION_SEQ) continue;
+
+            size_t off = 0;
+            for (uint16_t r = 0; r < hdr.record_count && off + sizeof(dlogger_record_hdr_t) <= len; r++) {
+                dlogger_record_hdr_t rec;
+                memcpy(&rec, records + off, sizeof(rec));
+                off += sizeof(rec) + rec.length;
+                uint32_t bit = rec.seq - first;
+                if (rec.seq != 0 && bit < count) {
+                    written[bit / 8] |= (uint8_t)(1u << (bit % 8));
+                }
+            }
+        }
+        fclose(file);
+    }
+    free(payload);
+}
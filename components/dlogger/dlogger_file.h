@@ -0,0 +1,337 @@
+#pragma once
+
+/**
+ * @file dlogger_file.h
+ * @brief On-flash binary log format (private to dlogger)
+ *
+ * Logs live in a fixed set of preallocated, fixed-size segment files that
+ * are recycled round-robin, so the store never grows and the cost of a
+ * write does not depend on uptime. A segment starts with a header written
+ * once when the segment is (re)started, followed by a chain of
+ * self-contained blocks. Each block is a fixed header plus length-prefixed
+ * records, LZ4-compressed when that makes the block smaller (see
+ * dlogger_lz4.h). Its CRC32 covers the stored bytes and is seeded with the
+ * segment sequence number, so blocks left over from the segment's previous
+ * use fail the check and mark the end of the chain. All integers are
+ * little-endian (native on both ESP32-S3 and the host).
+ *
+ *   [seg hdr][block hdr][rec hdr][msg][rec hdr][msg]...[block hdr]...[stale]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "dlogger.h"
+
+#define DLOGGER_BLOCK_MAGIC    0x474C4C44u  ///< "DLLG" in file byte order
+#define DLOGGER_BLOCK_VERSION  4
+#define DLOGGER_BLOCK_VERSION_MIN 2         ///< Oldest block version still read (never compressed)
+#define DLOGGER_BLOCK_VERSION_SEQ 4         ///< First block version whose records carry a sequence number
+#define DLOGGER_BLOCK_SIZE     4096         ///< Max bytes per uncompressed block incl. header (one SPIFFS block)
+#define DLOGGER_BLOCK_PAYLOAD_MAX (DLOGGER_BLOCK_SIZE - sizeof(dlogger_block_hdr_t))
+
+#define DLOGGER_BLOCK_FLAG_LZ4 0x01         ///< Payload is an LZ4 block of the records
+
+#define DLOGGER_SEGMENT_MAGIC   0x47534C44u ///< "DLSG" in file byte order
+#define DLOGGER_SEGMENT_VERSION 1
+#define DLOGGER_SEGMENT_PATH_MAX 32
+
+/**
+ * @brief Segment header (20 bytes), at offset 0 of every started segment
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;          ///< DLOGGER_SEGMENT_MAGIC
+    uint8_t version;         ///< DLOGGER_SEGMENT_VERSION
+    uint8_t reserved;        ///< Zero
+    uint16_t index;          ///< Segment slot (file number)
+    uint32_t sequence;       ///< Store-wide counter, incremented on every rotation
+    uint32_t size;           ///< Segment file size in bytes
+    uint32_t crc32;          ///< CRC32 (LE) of the fields above
+} dlogger_segment_hdr_t;
+
+/**
+ * @brief Block header (16 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;          ///< DLOGGER_BLOCK_MAGIC
+    uint8_t version;         ///< DLOGGER_BLOCK_VERSION
+    uint8_t flags;           ///< DLOGGER_BLOCK_FLAG_*
+    uint16_t record_count;   ///< Records in this block
+    uint32_t payload_len;    ///< Bytes following this header (as stored)
+    uint32_t crc32;          ///< CRC32 (LE) of the stored payload, seeded with the segment sequence
+} dlogger_block_hdr_t;
+
+/**
+ * @brief Record header (12 bytes), followed by `length` message bytes (no NUL)
+ *
+ * Blocks older than DLOGGER_BLOCK_VERSION_SEQ stop before `seq` (8 bytes).
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;      ///< Milliseconds since boot
+    uint8_t source;          ///< dlogger_source_t
+    uint8_t level;           ///< dlogger_level_t
+    uint16_t length;         ///< Message length in bytes
+    uint32_t seq;            ///< Commit sequence number of the run that wrote it (0 = none)
+} dlogger_record_hdr_t;
+
+/**
+ * @brief Block assembly buffer used by the flush task
+ */
+typedef struct {
+    uint8_t *buf;            ///< DLOGGER_BLOCK_SIZE bytes, header first
+    uint8_t *packed;         ///< DLOGGER_BLOCK_SIZE bytes for the compressed block, NULL = off
+    uint16_t *lz4_table;     ///< Compressor scratch (DLOGGER_LZ4_TABLE_SIZE bytes)
+    size_t used;             ///< Payload bytes used
+    size_t stored;           ///< Payload bytes once sealed, 0 until dlogger_block_seal()
+    uint8_t flags;           ///< DLOGGER_BLOCK_FLAG_* of the sealed block
+    uint16_t count;          ///< Records in the pending block
+    uint32_t ts_min;         ///< Oldest timestamp in the pending block
+    uint32_t ts_max;         ///< Newest timestamp in the pending block
+    uint8_t sources;         ///< Bit per dlogger_source_t present
+    uint8_t levels;          ///< Bit per dlogger_level_t present
+} dlogger_block_writer_t;
+
+/**
+ * @brief Allocate the block assembly buffer
+ *
+ * @param compress LZ4-compress blocks that get smaller
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t dlogger_block_writer_init(dlogger_block_writer_t *writer, bool compress);
+
+/**
+ * @brief Free the block assembly buffer
+ */
+void dlogger_block_writer_free(dlogger_block_writer_t *writer);
+
+/**
+ * @brief Append one record to the pending block
+ *
+ * @param seq Sequence number the entry was committed with, 0 if it has none
+ * @param message Message bytes (not NUL-terminated)
+ * @param length Message length in bytes
+ * @return false if the block is full (seal it and retry)
+ */
+bool dlogger_block_append(dlogger_block_writer_t *writer, uint32_t timestamp, uint32_t seq,
+                          uint8_t source, uint8_t level,
+                          const char *message, size_t length);
+
+/**
+ * @brief Whether a record with `length` message bytes fits in the pending block
+ */
+static inline bool dlogger_block_fits(const dlogger_block_writer_t *writer, size_t length) {
+    return writer->used + sizeof(dlogger_record_hdr_t) + length <= DLOGGER_BLOCK_PAYLOAD_MAX;
+}
+
+/**
+ * @brief Compress the pending block if that makes it smaller
+ *
+ * No more records can be appended afterwards. Called by
+ * dlogger_block_write() if needed.
+ */
+void dlogger_block_seal(dlogger_block_writer_t *writer);
+
+/**
+ * @brief Bytes the pending block occupies on flash (exact once sealed)
+ */
+static inline size_t dlogger_block_bytes(const dlogger_block_writer_t *writer) {
+    return sizeof(dlogger_block_hdr_t) + (writer->stored ? writer->stored : writer->used);
+}
+
+/**
+ * @brief Seal the pending block (compression, CRC) and fill in its header
+ *
+ * The block stays in the writer until dlogger_block_reset().
+ *
+ * @param sequence Sequence number of the segment the block goes to
+ * @param len Set to the block's size on flash
+ * @return The block as it goes to flash
+ */
+const uint8_t *dlogger_block_finish(dlogger_block_writer_t *writer, uint32_t sequence,
+                                    size_t *len);
+
+/**
+ * @brief Start a new, empty pending block
+ */
+void dlogger_block_reset(dlogger_block_writer_t *writer);
+
+/**
+ * @brief Seal the pending block (compression, CRC) and write it with a single fwrite
+ *
+ * Does nothing if the block is empty. The writer is reset either way.
+ *
+ * @param sequence Sequence number of the segment the block goes to
+ * @return ESP_OK, or ESP_FAIL on a short write
+ */
+esp_err_t dlogger_block_write(dlogger_block_writer_t *writer, FILE *file, uint32_t sequence);
+
+#define DLOGGER_INDEX_STRIDE   DLOGGER_BLOCK_SIZE  ///< Segment bytes covered by one index entry
+
+/**
+ * @brief Sparse index entry: summary of the blocks starting in one stride
+ *
+ * Only blocks written since the store was opened are indexed (timestamps
+ * restart at every boot, so older ones are not comparable).
+ */
+typedef struct {
+    uint32_t offset;         ///< First block starting in this stride, 0 if none
+    uint32_t ts_min;         ///< Oldest record timestamp
+    uint32_t ts_max;         ///< Newest record timestamp
+    uint8_t sources;         ///< Bit per dlogger_source_t present
+    uint8_t levels;          ///< Bit per dlogger_level_t present
+} dlogger_index_entry_t;
+
+/**
+ * @brief Record filter applied while decoding (see dlogger_query())
+ */
+typedef struct {
+    uint32_t t_from;         ///< Oldest timestamp (inclusive)
+    uint32_t t_to;           ///< Newest timestamp (inclusive)
+    uint32_t source_mask;    ///< Bit per dlogger_source_t to keep
+    uint32_t level_mask;     ///< Bit per dlogger_level_t to keep
+} dlogger_file_filter_t;
+
+/**
+ * @brief Byte range of one segment that may hold matching records
+ */
+typedef struct {
+    uint32_t segment;        ///< Segment slot
+    uint32_t sequence;       ///< Segment sequence when planned (detects recycling)
+    uint32_t offset;         ///< First block to read
+    uint32_t end;            ///< Stop at the first block starting at or after this
+} dlogger_range_t;
+
+/**
+ * @brief Segmented log store (owned by the flush task)
+ */
+typedef struct {
+    const char *dir;         ///< Directory holding the segment files
+    uint32_t count;          ///< Number of segments
+    uint32_t size;           ///< Bytes per segment file
+    FILE *file;              ///< Active segment, NULL until opened
+    _Atomic uint32_t index;  ///< Active segment slot (read by other tasks)
+    uint32_t sequence;       ///< Sequence of the active segment
+    uint32_t offset;         ///< Where the next block goes in the active segment
+    uint32_t written;        ///< Block bytes written so far (wraps, kept across a reopen)
+    bool async;              ///< Write through the storage I/O service (set before opening)
+    _Atomic uint32_t io_failures;   ///< Failed background writes (I/O task)
+    uint32_t io_failures_seen;      ///< io_failures at the last dlogger_store_take_failures()
+    uint32_t strides;        ///< Index entries per segment
+    uint32_t *sequences;     ///< Sequence per segment slot (0 = never started)
+    dlogger_index_entry_t *entries; ///< count * strides index entries
+} dlogger_store_t;
+
+/**
+ * @brief Build the path of segment `index` ("<dir>/log<index>.dlog")
+ */
+void dlogger_segment_path(const char *dir, uint32_t index, char *buf, size_t buf_len);
+
+/**
+ * @brief Open the store, preallocating missing segments
+ *
+ * Segment files that are missing or have the wrong size are created once,
+ * filled with 0xFF. The segment with the highest valid sequence becomes
+ * active and writing resumes after its last valid block.
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM, or ESP_FAIL if a segment cannot be created
+ */
+esp_err_t dlogger_store_open(dlogger_store_t *store, const char *dir,
+                             uint32_t count, uint32_t size);
+
+/**
+ * @brief Write the pending block to the active segment
+ *
+ * Rotates to the next segment (overwriting it in place) when the block does
+ * not fit. The writer is reset either way. With `async` the block is only
+ * queued; a failure shows up in dlogger_store_take_failures().
+ *
+ * @return ESP_OK, or ESP_FAIL on an I/O error (the store is closed)
+ */
+esp_err_t dlogger_store_write(dlogger_store_t *store, dlogger_block_writer_t *writer);
+
+/**
+ * @brief Flush the active segment through to flash (fflush + fsync)
+ *
+ * With `async`, waits for the blocks handed to the I/O service first.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if no segment is open, or ESP_FAIL
+ */
+esp_err_t dlogger_store_sync(dlogger_store_t *store);
+
+/**
+ * @brief Wait until every block handed to the I/O service is in its file
+ *
+ * Readers of the segment files call it first. Does nothing without `async`.
+ */
+void dlogger_store_settle(const dlogger_store_t *store);
+
+/**
+ * @brief Background writes that failed since the last call
+ *
+ * With failures, waits for the writes still queued first, so the caller
+ * can reopen the store after the last intact block.
+ */
+uint32_t dlogger_store_take_failures(dlogger_store_t *store);
+
+/**
+ * @brief Close the active segment
+ *
+ * The index is kept: a reopened store continues it.
+ */
+void dlogger_store_close(dlogger_store_t *store);
+
+/**
+ * @brief Close the store and free its index (after its queued writes)
+ */
+void dlogger_store_free(dlogger_store_t *store);
+
+/**
+ * @brief List the segment ranges whose index entries may match `filter`
+ *
+ * Ranges are returned oldest first, adjacent strides merged. Only the
+ * index is consulted; the caller must keep the store from being written
+ * concurrently but can read the ranges afterwards without that guarantee.
+ *
+ * @param ranges Destination, at least count * strides entries
+ * @return Number of ranges
+ */
+size_t dlogger_store_plan(const dlogger_store_t *store, const dlogger_file_filter_t *filter,
+                          dlogger_range_t *ranges);
+
+/**
+ * @brief Decode the records of one planned range that match `filter`
+ *
+ * Safe while the flush task keeps writing: a segment recycled since the
+ * plan was made no longer matches the planned sequence and is skipped.
+ *
+ * @return false if the callback asked to stop
+ */
+bool dlogger_store_read_range(const char *dir, const dlogger_range_t *range,
+                              const dlogger_file_filter_t *filter,
+                              dlogger_entry_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Mark which sequence numbers were written since a store position
+ *
+ * Walks the blocks from `sequence`/`offset` to the end of the open store
+ * and sets bit `seq - first` of `written` for every record whose `seq` is
+ * in [first, first + count). Segments recycled since are skipped. The
+ * caller must keep the store from being written concurrently.
+ */
+void dlogger_store_mark_written(dlogger_store_t *store, uint32_t sequence, uint32_t offset,
+                                uint32_t first, uint32_t count, uint8_t *written);
+
+/**
+ * @brief Decode every valid record in one segment file
+ *
+ * Blocks are read in order up to the first one whose magic, length or
+ * sequence-seeded CRC does not check out (a torn write or data from the
+ * segment's previous use).
+ *
+ * @return ESP_OK (also for a segment that was never started), or
+ *         ESP_ERR_NOT_FOUND if the file cannot be opened
+ */
+esp_err_t dlogger_file_read(const char *path, dlogger_entry_cb_t callback, void *user_ctx);
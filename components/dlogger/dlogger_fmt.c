@@ -0,0 +1,290 @@
+#include "dlogger_fmt.h"
+#include "dlogger_port.h"
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================================
+// FORMAT SPEC PARSING (SHARED BY CAPTURE AND RENDER)
+// ============================================================================
+
+typedef enum {
+    ARG_NONE,           ///< "%%"
+    ARG_INT,            ///< int (also char/short after promotion)
+    ARG_LONG,           ///< long
+    ARG_LLONG,          ///< long long
+    ARG_SIZE,           ///< size_t
+    ARG_INTMAX,         ///< intmax_t
+    ARG_PTRDIFF,        ///< ptrdiff_t
+    ARG_PTR,            ///< void *
+    ARG_DOUBLE,         ///< double (float after promotion)
+    ARG_STR,            ///< const char *, copied into the payload
+    ARG_UNSUPPORTED     ///< Cannot be deferred
+} arg_kind_t;
+
+/**
+ * @brief One parsed conversion specification
+ */
+typedef struct {
+    char flags[6];      ///< "-+ #0" flags as written (NUL-terminated)
+    int width;          ///< Field width, -1 if none
+    int prec;           ///< Precision, -1 if none
+    bool width_star;    ///< Width comes from an int argument
+    bool prec_star;     ///< Precision comes from an int argument
+    char lenmod[3];     ///< Length modifier as written (NUL-terminated)
+    char conv;          ///< Conversion character
+    arg_kind_t kind;    ///< Argument type
+} spec_t;
+
+/**
+ * @brief Map a length modifier to an integer argument kind
+ */
+static arg_kind_t int_kind(const char *lenmod) {
+    if (lenmod[0] == '\0' || lenmod[0] == 'h') return ARG_INT;
+    if (strcmp(lenmod, "l") == 0)  return ARG_LONG;
+    if (strcmp(lenmod, "ll") == 0) return ARG_LLONG;
+    if (lenmod[0] == 'z') return ARG_SIZE;
+    if (lenmod[0] == 'j') return ARG_INTMAX;
+    if (lenmod[0] == 't') return ARG_PTRDIFF;
+    return ARG_UNSUPPORTED;
+}
+
+/**
+ * @brief Parse the conversion starting at `p` (which points at '%')
+ *
+ * @return Pointer just past the conversion
+ */
+static const char *parse_spec(const char *p, spec_t *spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->width = -1;
+    spec->prec = -1;
+    p++;
+
+    if (*p == '%') {
+        spec->conv = '%';
+        spec->kind = ARG_NONE;
+        return p + 1;
+    }
+
+    size_t nflags = 0;
+    while (*p && strchr("-+ #0", *p)) {
+        if (nflags < sizeof(spec->flags) - 1) spec->flags[nflags++] = *p;
+        p++;
+    }
+
+    if (*p == '*') {
+        spec->width_star = true;
+        p++;
+    } else if (*p >= '0' && *p <= '9') {
+        spec->width = 0;
+        while (*p >= '0' && *p <= '9') spec->width = spec->width * 10 + (*p++ - '0');
+    }
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->prec_star = true;
+            p++;
+        } else {
+            spec->prec = 0;
+            while (*p >= '0' && *p <= '9') spec->prec = spec->prec * 10 + (*p++ - '0');
+        }
+    }
+
+    size_t nlen = 0;
+    while (*p && strchr("hlzjtLq", *p) && nlen < sizeof(spec->lenmod) - 1) {
+        spec->lenmod[nlen++] = *p++;
+    }
+
+    spec->conv = *p;
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+            spec->kind = int_kind(spec->lenmod);
+            break;
+        case 'c':
+            spec->kind = (nlen == 0) ? ARG_INT : ARG_UNSUPPORTED;
+            break;
+        case 's':
+            spec->kind = (nlen == 0) ? ARG_STR : ARG_UNSUPPORTED;
+            break;
+        case 'p':
+            spec->kind = ARG_PTR;
+            break;
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A':
+            spec->kind = (nlen == 0 || strcmp(spec->lenmod, "l") == 0) ? ARG_DOUBLE
+                                                                     : ARG_UNSUPPORTED;
+            break;
+        default:
+            // %n, wide conversions, truncated format...
+            spec->kind = ARG_UNSUPPORTED;
+            return *p ? p + 1 : p;
+    }
+    return p + 1;
+}
+
+// ============================================================================
+// CAPTURE (LOGGING TASK HOT PATH)
+// ============================================================================
+
+#define PUT(type, value) do {                                   \
+        type v_ = (value);                                      \
+        if (o + sizeof(type) > out_len) return 0;               \
+        memcpy(out + o, &v_, sizeof(type));                     \
+        o += sizeof(type);                                      \
+    } while (0)
+
+size_t dlogger_fmt_capture(uint8_t *out, size_t out_len, const char *format, va_list args) {
+    if (!out || !format || !dlogger_port_ptr_is_static(format)) return 0;
+
+    size_t o = 0;
+    PUT(const char *, format);
+
+    for (const char *p = format; *p; ) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+
+        spec_t spec;
+        p = parse_spec(p, &spec);
+        if (spec.kind == ARG_UNSUPPORTED) return 0;
+        if (spec.kind == ARG_NONE) continue;
+
+        if (spec.width_star) PUT(int, va_arg(args, int));
+        int prec = spec.prec;
+        if (spec.prec_star) {
+            prec = va_arg(args, int);
+            PUT(int, prec);
+        }
+
+        switch (spec.kind) {
+            case ARG_INT:     PUT(int, va_arg(args, int)); break;
+            case ARG_LONG:    PUT(long, va_arg(args, long)); break;
+            case ARG_LLONG:   PUT(long long, va_arg(args, long long)); break;
+            case ARG_SIZE:    PUT(size_t, va_arg(args, size_t)); break;
+            case ARG_INTMAX:  PUT(intmax_t, va_arg(args, intmax_t)); break;
+            case ARG_PTRDIFF: PUT(ptrdiff_t, va_arg(args, ptrdiff_t)); break;
+            case ARG_PTR:     PUT(void *, va_arg(args, void *)); break;
+            case ARG_DOUBLE:  PUT(double, va_arg(args, double)); break;
+            case ARG_STR: {
+                // The string may not outlive the call: copy its bytes
+                const char *str = va_arg(args, const char *);
+                if (!str) str = "(null)";
+                size_t n = (prec >= 0) ? strnlen(str, (size_t)prec) : strlen(str);
+                if (o + sizeof(uint16_t) + n > out_len) return 0;
+                PUT(uint16_t, (uint16_t)n);
+                memcpy(out + o, str, n);
+                o += n;
+                break;
+            }
+            default:
+                return 0;
+        }
+    }
+
+    return o;
+}
+
+// ============================================================================
+// RENDER (FLUSH TASK / READERS)
+// ============================================================================
+
+#define GET(type, var)                                          \
+        type var;                                               \
+        if (i + sizeof(type) > payload_len) goto done;          \
+        memcpy(&var, payload + i, sizeof(type));                \
+        i += sizeof(type)
+
+/**
+ * @brief Rebuild a concrete conversion with '*' values substituted
+ *
+ * Strings are always emitted as "%<flags><width>.*s" because the copied
+ * bytes are not NUL-terminated.
+ */
+static void build_spec(const spec_t *spec, char *buf, size_t len) {
+    int n = snprintf(buf, len, "%%%s", spec->flags);
+    if (spec->width >= 0) {
+        n += snprintf(buf + n, len - n, "%d", spec->width);
+    }
+    if (spec->kind == ARG_STR) {
+        snprintf(buf + n, len - n, ".*s");
+        return;
+    }
+    if (spec->prec >= 0) {
+        n += snprintf(buf + n, len - n, ".%d", spec->prec);
+    }
+    snprintf(buf + n, len - n, "%s%c", spec->lenmod, spec->conv);
+}
+
+size_t dlogger_fmt_render(const uint8_t *payload, size_t payload_len, char *out, size_t out_len) {
+    if (!out || out_len == 0) return 0;
+
+    size_t o = 0;
+    size_t i = 0;
+    out[0] = '\0';
+
+    GET(const char *, format);
+    if (!dlogger_port_ptr_is_static(format)) goto done;   // Corrupt payload
+
+    for (const char *p = format; *p && o < out_len - 1; ) {
+        if (*p != '%') {
+            out[o++] = *p++;
+            continue;
+        }
+
+        spec_t spec;
+        p = parse_spec(p, &spec);
+        if (spec.kind == ARG_NONE) {
+            out[o++] = '%';
+            continue;
+        }
+        if (spec.kind == ARG_UNSUPPORTED) break;
+
+        if (spec.width_star) {
+            GET(int, width);
+            spec.width = width;
+            if (spec.width < 0) {
+                // Negative '*' width means left-justify
+                spec.width = -spec.width;
+                strncat(spec.flags, "-", sizeof(spec.flags) - strlen(spec.flags) - 1);
+            }
+        }
+        if (spec.prec_star) {
+            GET(int, prec);
+            spec.prec = (prec < 0) ? -1 : prec;
+        }
+
+        char conv[32];
+        build_spec(&spec, conv, sizeof(conv));
+
+        char *dst = out + o;
+        size_t room = out_len - o;
+        int n = 0;
+        switch (spec.kind) {
+            case ARG_INT:     { GET(int, v);       n = snprintf(dst, room, conv, v); break; }
+            case ARG_LONG:    { GET(long, v);      n = snprintf(dst, room, conv, v); break; }
+            case ARG_LLONG:   { GET(long long, v); n = snprintf(dst, room, conv, v); break; }
+            case ARG_SIZE:    { GET(size_t, v);    n = snprintf(dst, room, conv, v); break; }
+            case ARG_INTMAX:  { GET(intmax_t, v);  n = snprintf(dst, room, conv, v); break; }
+            case ARG_PTRDIFF: { GET(ptrdiff_t, v); n = snprintf(dst, room, conv, v); break; }
+            case ARG_PTR:     { GET(void *, v);    n = snprintf(dst, room, conv, v); break; }
+            case ARG_DOUBLE:  { GET(double, v);    n = snprintf(dst, room, conv, v); break; }
+            case ARG_STR: {
+                GET(uint16_t, slen);
+                if (i + slen > payload_len) goto done;
+                n = snprintf(dst, room, conv, (int)slen, (const char *)(payload + i));
+                i += slen;
+                break;
+            }
+            default:
+                goto done;
+        }
+
+        if (n < 0) break;
+        o += ((size_t)n < room) ? (size_t)n : room - 1;
+    }
+
+done:
+    out[o] = '\0';
+    return o;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+/**
+ * @file dlogger_fmt.h
+ * @brief Deferred printf formatting (private to dlogger)
+ *
+ * Instead of running vsnprintf on the logging task, a deferred record
+ * stores the format string *address* plus the raw argument words:
+ *
+ *   [const char *format][arg][arg]...
+ *
+ * Integers, pointers and doubles are stored in their native width; `%s`
+ * arguments are copied (uint16 length + bytes) because the caller's
+ * buffer may be gone by the time the record is read. The text is only
+ * produced when the flush task, a reader or a decoder renders the record.
+ *
+ * Only formats that live in read-only program memory may be deferred
+ * (the pointer must stay valid for the lifetime of the record).
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DLOGGER_FMT_MAX_PAYLOAD  192    ///< Largest captured format + argument blob
+
+/**
+ * @brief Capture `format` and its arguments into `out`
+ *
+ * Scans the format once to learn the argument types; no text is produced.
+ *
+ * @return Payload length, or 0 if the format cannot be deferred
+ *         (not in read-only memory, `%n`, wide/long double conversions,
+ *         or arguments larger than `out_len`) - format it immediately
+ */
+size_t dlogger_fmt_capture(uint8_t *out, size_t out_len, const char *format, va_list args);
+
+/**
+ * @brief Render a captured payload as text (NUL-terminated, truncated)
+ *
+ * @return Number of characters written to `out` (excluding the NUL)
+ */
+size_t dlogger_fmt_render(const uint8_t *payload, size_t payload_len, char *out, size_t out_len);
@@ -0,0 +1,110 @@
+#include "dlogger_isr.h"
+#include "esp_attr.h"
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+// Plain .bss: internal RAM, reachable with the flash cache disabled
+static dlogger_isr_ring_t isr_rings[DLOGGER_PORT_NUM_CORES];
+
+_Static_assert((DLOGGER_ISR_SLOTS & (DLOGGER_ISR_SLOTS - 1)) == 0,
+               "CONFIG_DLOGGER_ISR_RING_SLOTS must be a power of two");
+
+// ============================================================================
+// PRODUCER SIDE (ANY CONTEXT)
+// ============================================================================
+
+bool IRAM_ATTR dlogger_isr_push(uint8_t source, uint8_t level, const char *message,
+                                bool *was_empty) {
+    // Claim a slot with this core's interrupts masked: nothing else can
+    // touch this core's ring meanwhile, so the CAS only ever retries on the
+    // host (where "ISRs" are ordinary threads)
+    uint32_t irq_state = dlogger_port_irq_mask();
+    dlogger_isr_ring_t *ring = &isr_rings[dlogger_port_core_id()];
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail;
+    do {
+        tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - tail >= DLOGGER_ISR_SLOTS) {
+            dlogger_port_irq_restore(irq_state);
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&ring->head, &head, head + 1,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+    // Stamped inside the masked section so slot order is timestamp order
+    uint32_t timestamp = dlogger_port_time_ms();
+    dlogger_port_irq_restore(irq_state);
+
+    dlogger_isr_slot_t *slot = &ring->slots[head & (DLOGGER_ISR_SLOTS - 1)];
+    slot->timestamp = timestamp;
+    slot->source = source;
+    slot->level = level;
+
+    // Byte loop instead of strnlen/memcpy: those may live in flash
+    uint16_t length = 0;
+    while (length < DLOGGER_ISR_MSG_MAX && message[length] != '\0') {
+        slot->message[length] = message[length];
+        length++;
+    }
+    slot->length = length;
+
+    atomic_store_explicit(&slot->seq, head + 1, memory_order_release);
+    *was_empty = (head == tail);
+    return true;
+}
+
+// ============================================================================
+// CONSUMER SIDE (FLUSH TASK)
+// ============================================================================
+
+/**
+ * @brief Oldest published slot of a ring, or NULL
+ */
+static dlogger_isr_slot_t *ring_peek(dlogger_isr_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+        return NULL;
+    }
+    dlogger_isr_slot_t *slot = &ring->slots[tail & (DLOGGER_ISR_SLOTS - 1)];
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tail + 1) {
+        return NULL;    // Claimed but still being filled
+    }
+    return slot;
+}
+
+size_t dlogger_isr_import(dlogger_isr_import_cb_t callback, void *user_ctx) {
+    size_t imported = 0;
+
+    for (;;) {
+        // Each core's ring is already in time order: merge on the heads
+        dlogger_isr_ring_t *oldest = NULL;
+        dlogger_isr_slot_t *slot = NULL;
+        for (int core = 0; core < DLOGGER_PORT_NUM_CORES; core++) {
+            dlogger_isr_slot_t *s = ring_peek(&isr_rings[core]);
+            if (s && (!slot || (int32_t)(s->timestamp - slot->timestamp) < 0)) {
+                slot = s;
+                oldest = &isr_rings[core];
+            }
+        }
+        if (!slot || !callback(slot, user_ctx)) {
+            break;
+        }
+
+        // Hand the slot back to producers
+        atomic_fetch_add_explicit(&oldest->tail, 1, memory_order_release);
+        imported++;
+    }
+
+    return imported;
+}
+
+uint32_t dlogger_isr_dropped(void) {
+    uint32_t dropped = 0;
+    for (int core = 0; core < DLOGGER_PORT_NUM_CORES; core++) {
+        dropped += atomic_load_explicit(&isr_rings[core].dropped, memory_order_relaxed);
+    }
+    return dropped;
+}
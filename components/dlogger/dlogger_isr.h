@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+ * @file dlogger_isr.h
+ * @brief Per-core interrupt-context staging rings (private to dlogger)
+ *
+ * Interrupt handlers cannot use the main ring: it lives in PSRAM (not
+ * accessible from IRAM ISRs while the flash cache is disabled) and its
+ * reserve path may spin on CAS retries and reclaim. Each core instead owns
+ * a small ring of fixed-size slots in internal RAM:
+ *
+ * - The producer (any ISR or task on that core) claims a slot with
+ *   interrupts masked on its own core, so it never retries or waits.
+ * - The flush task is the only consumer. It moves slots into the main ring,
+ *   merging the cores by timestamp, before every drain.
+ *
+ * A slot is published by storing its sequence number last.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "dlogger_port.h"
+
+#define DLOGGER_ISR_SLOTS        CONFIG_DLOGGER_ISR_RING_SLOTS  ///< Slots per core (power of two)
+#define DLOGGER_ISR_MSG_MAX      52     ///< Message bytes per slot (64-byte slots)
+
+/**
+ * @brief One staged entry (64 bytes)
+ */
+typedef struct {
+    uint32_t timestamp;          ///< Milliseconds since boot
+    uint8_t source;              ///< dlogger_source_t
+    uint8_t level;               ///< dlogger_level_t
+    uint16_t length;             ///< Message length in bytes
+    char message[DLOGGER_ISR_MSG_MAX];  ///< Message bytes (no NUL)
+    _Atomic uint32_t seq;        ///< Slot index + 1 once published
+} dlogger_isr_slot_t;
+
+/**
+ * @brief One core's ring
+ */
+typedef struct {
+    dlogger_isr_slot_t slots[DLOGGER_ISR_SLOTS];
+    _Atomic uint32_t head;       ///< Next slot to claim (producers on this core)
+    _Atomic uint32_t tail;       ///< Next slot to import (flush task)
+    _Atomic uint32_t dropped;    ///< Entries lost because the ring was full
+} dlogger_isr_ring_t;
+
+/**
+ * @brief Callback for dlogger_isr_import(); returns false to stop (main ring full)
+ */
+typedef bool (*dlogger_isr_import_cb_t)(const dlogger_isr_slot_t *slot, void *user_ctx);
+
+/**
+ * @brief Stage an entry in the calling core's ring (ISR safe, wait-free)
+ *
+ * The entry is timestamped here. Messages longer than DLOGGER_ISR_MSG_MAX
+ * are truncated.
+ *
+ * @param was_empty Set to true if the ring had nothing pending (wake the consumer)
+ * @return false if the ring is full (entry dropped and counted)
+ */
+bool dlogger_isr_push(uint8_t source, uint8_t level, const char *message, bool *was_empty);
+
+/**
+ * @brief Hand every published slot to `callback`, oldest timestamp first
+ *        across cores (flush task only)
+ *
+ * @return Number of entries imported
+ */
+size_t dlogger_isr_import(dlogger_isr_import_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Entries dropped by all cores since boot
+ */
+uint32_t dlogger_isr_dropped(void);
@@ -0,0 +1,174 @@
+#include "dlogger_lz4.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define MIN_MATCH      4      // Shortest match LZ4 encodes
+#define LAST_LITERALS  5      // The block always ends with this many literals
+#define MF_LIMIT       12     // No match may start in the last 12 bytes
+#define MAX_OFFSET     65535
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - DLOGGER_LZ4_HASH_BITS);
+}
+
+/**
+ * @brief Bytes needed to encode a length beyond its 4-bit token field
+ */
+static inline size_t extra_length_bytes(size_t length) {
+    return (length >= 15) ? (length - 15) / 255 + 1 : 0;
+}
+
+/**
+ * @brief Write the 255-run continuation of a length whose nibble is 15
+ */
+static inline uint8_t *write_length(uint8_t *op, size_t length) {
+    for (length -= 15; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+/**
+ * @brief Emit one sequence: `lit_len` literals from `literals`, then a
+ *        match of `match_len` bytes at `offset` (match_len 0 = last sequence)
+ *
+ * @return New output position, or NULL if `end` would be exceeded
+ */
+static uint8_t *emit_sequence(uint8_t *op, uint8_t *end, const uint8_t *literals, size_t lit_len,
+                              size_t offset, size_t match_len) {
+    size_t ml = match_len ? match_len - MIN_MATCH : 0;
+    size_t need = 1 + extra_length_bytes(lit_len) + lit_len +
+                  (match_len ? 2 + extra_length_bytes(ml) : 0);
+    if ((size_t)(end - op) < need) return NULL;
+
+    uint8_t *token = op++;
+    *token = (uint8_t)(((lit_len < 15) ? lit_len : 15) << 4);
+    if (lit_len >= 15) op = write_length(op, lit_len);
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+
+    if (match_len) {
+        *op++ = (uint8_t)offset;
+        *op++ = (uint8_t)(offset >> 8);
+        *token |= (uint8_t)((ml < 15) ? ml : 15);
+        if (ml >= 15) op = write_length(op, ml);
+    }
+    return op;
+}
+
+// ============================================================================
+// COMPRESSOR (FLUSH TASK)
+// ============================================================================
+
+size_t dlogger_lz4_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                            uint16_t *table) {
+    if (len > DLOGGER_LZ4_MAX_INPUT) return 0;
+
+    uint8_t *op = dst;
+    uint8_t *end = dst + cap;
+    size_t anchor = 0;
+
+    if (len > MF_LIMIT) {
+        memset(table, 0, DLOGGER_LZ4_TABLE_SIZE);
+        size_t limit = len - MF_LIMIT;
+        size_t match_limit = len - LAST_LITERALS;
+
+        for (size_t ip = 0; ip < limit; ) {
+            uint32_t sequence = read32(src + ip);
+            uint32_t h = hash4(sequence);
+            size_t ref = table[h];
+            table[h] = (uint16_t)ip;
+
+            // A stale or empty slot simply fails the comparison
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(src + ref) != sequence) {
+                ip++;
+                continue;
+            }
+
+            size_t match_len = MIN_MATCH;
+            while (ip + match_len < match_limit && src[ref + match_len] == src[ip + match_len]) {
+                match_len++;
+            }
+
+            op = emit_sequence(op, end, src + anchor, ip - anchor, ip - ref, match_len);
+            if (!op) return 0;
+            ip += match_len;
+            anchor = ip;
+
+            // Index the position just before the next one, as LZ4 does
+            if (ip < limit) {
+                table[hash4(read32(src + ip - 2))] = (uint16_t)(ip - 2);
+            }
+        }
+    }
+
+    op = emit_sequence(op, end, src + anchor, len - anchor, 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+// ============================================================================
+// DECOMPRESSOR (READERS)
+// ============================================================================
+
+/**
+ * @brief Read the continuation of a length whose nibble is 15
+ *
+ * @return false if the input ends inside the length
+ */
+static inline bool read_length(const uint8_t **ip, const uint8_t *end, size_t *length) {
+    uint8_t b;
+    do {
+        if (*ip >= end) return false;
+        b = *(*ip)++;
+        *length += b;
+    } while (b == 255);
+    return true;
+}
+
+size_t dlogger_lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    const uint8_t *ip = src;
+    const uint8_t *in_end = src + len;
+    size_t op = 0;
+
+    while (ip < in_end) {
+        uint8_t token = *ip++;
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !read_length(&ip, in_end, &lit_len)) return 0;
+        if (lit_len > (size_t)(in_end - ip) || lit_len > cap - op) return 0;
+        memcpy(dst + op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip == in_end) break;    // The last sequence has no match
+
+        if (in_end - ip < 2) return 0;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) return 0;
+
+        size_t match_len = token & 15;
+        if (match_len == 15 && !read_length(&ip, in_end, &match_len)) return 0;
+        match_len += MIN_MATCH;
+        if (match_len > cap - op) return 0;
+
+        // Byte by byte: the match may overlap the bytes it produces
+        const uint8_t *match = dst + op - offset;
+        for (size_t i = 0; i < match_len; i++) {
+            dst[op + i] = match[i];
+        }
+        op += match_len;
+    }
+    return op;
+}
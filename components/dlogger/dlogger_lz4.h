@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * @file dlogger_lz4.h
+ * @brief LZ4 block-format codec for log blocks (private to dlogger)
+ *
+ * A greedy single-pass compressor with a small hash table, sized for the
+ * 4 KB blocks the flush task writes: log text repeats tags, prefixes and
+ * formats, which LZ4 matches cheaply. The output is the standard LZ4 block
+ * format (no frame), so blocks can also be decoded off-device with any LZ4
+ * library. The decoder checks every length and offset against its input
+ * and output, so a corrupt payload fails instead of overrunning.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DLOGGER_LZ4_HASH_BITS    11     ///< Compressor hash table: 2^11 positions
+#define DLOGGER_LZ4_TABLE_SIZE   ((1u << DLOGGER_LZ4_HASH_BITS) * sizeof(uint16_t))  ///< Bytes
+#define DLOGGER_LZ4_MAX_INPUT    65535  ///< Positions are stored as 16 bits
+
+/**
+ * @brief Compress `len` bytes of `src` into `dst`
+ *
+ * @param table DLOGGER_LZ4_TABLE_SIZE bytes of scratch space
+ * @return Compressed size, or 0 if it would exceed `cap` (store the block raw)
+ */
+size_t dlogger_lz4_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                            uint16_t *table);
+
+/**
+ * @brief Decompress an LZ4 block
+ *
+ * @return Decompressed size, or 0 if the input is malformed or does not
+ *         fit in `cap` bytes
+ */
+size_t dlogger_lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
@@ -0,0 +1,128 @@
+#include "dlogger_metrics.h"
+#include "dlogger_port.h"
+#include <stdatomic.h>
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+static _Atomic uint32_t stored[LOG_SOURCE_COUNT][LOG_LEVEL_COUNT];
+static _Atomic uint32_t dropped[LOG_SOURCE_COUNT][LOG_LEVEL_COUNT];
+static _Atomic uint32_t enqueue_hist[DLOGGER_STATS_BUCKETS];
+static _Atomic uint32_t enqueue_max_ns;
+
+// Written by the flush task only, read by anyone
+static _Atomic uint32_t flushes;
+static _Atomic uint32_t flush_hist[DLOGGER_STATS_BUCKETS];
+static _Atomic uint32_t flush_last_us;
+static _Atomic uint32_t flush_max_us;
+static _Atomic uint32_t flush_last_bytes;
+static _Atomic uint32_t flush_max_bytes;
+static _Atomic uint64_t bytes_written;
+static _Atomic uint32_t write_errors;
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+/**
+ * @brief Histogram bucket of `value` (see DLOGGER_METRICS_BUCKET_BASE)
+ */
+static inline uint32_t bucket_of(uint32_t value) {
+    uint32_t scaled = value / DLOGGER_METRICS_BUCKET_BASE;
+    uint32_t bucket = scaled ? 32 - (uint32_t)__builtin_clz(scaled) : 0;
+    return (bucket < DLOGGER_STATS_BUCKETS) ? bucket : DLOGGER_STATS_BUCKETS - 1;
+}
+
+static inline void store_max(_Atomic uint32_t *max, uint32_t value) {
+    uint32_t seen = atomic_load_explicit(max, memory_order_relaxed);
+    while (value > seen &&
+           !atomic_compare_exchange_weak_explicit(max, &seen, value, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Convert a dlogger_port_cycles() difference, in 32-bit arithmetic
+ */
+static inline uint32_t cycles_to_ns(uint32_t cycles) {
+    uint32_t per_us = dlogger_port_cycles_per_us();
+    uint32_t us = cycles / per_us;
+    if (us >= UINT32_MAX / 1000) return UINT32_MAX;
+    return us * 1000 + (cycles % per_us) * 1000 / per_us;
+}
+
+static inline bool in_range(uint8_t source, uint8_t level) {
+    return source < LOG_SOURCE_COUNT && level < LOG_LEVEL_COUNT;
+}
+
+// ============================================================================
+// PUBLIC (PRIVATE TO DLOGGER) API
+// ============================================================================
+
+void dlogger_metrics_stored(uint8_t source, uint8_t level) {
+    if (in_range(source, level)) {
+        atomic_fetch_add_explicit(&stored[source][level], 1, memory_order_relaxed);
+    }
+}
+
+void dlogger_metrics_dropped(uint8_t source, uint8_t level) {
+    if (in_range(source, level)) {
+        atomic_fetch_add_explicit(&dropped[source][level], 1, memory_order_relaxed);
+    }
+}
+
+uint32_t dlogger_metrics_enqueue_begin(void) {
+#if CONFIG_DLOGGER_STATS_TIMING
+    return dlogger_port_cycles();
+#else
+    return 0;
+#endif
+}
+
+void dlogger_metrics_enqueue_end(uint32_t begin) {
+#if CONFIG_DLOGGER_STATS_TIMING
+    uint32_t ns = cycles_to_ns(dlogger_port_cycles() - begin);
+    atomic_fetch_add_explicit(&enqueue_hist[bucket_of(ns)], 1, memory_order_relaxed);
+    store_max(&enqueue_max_ns, ns);
+#else
+    (void)begin;
+#endif
+}
+
+void dlogger_metrics_flush(uint32_t begin, uint32_t bytes) {
+    uint32_t us = (dlogger_port_cycles() - begin) / dlogger_port_cycles_per_us();
+    atomic_fetch_add_explicit(&flushes, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&flush_hist[bucket_of(us)], 1, memory_order_relaxed);
+    atomic_store_explicit(&flush_last_us, us, memory_order_relaxed);
+    store_max(&flush_max_us, us);
+    atomic_store_explicit(&flush_last_bytes, bytes, memory_order_relaxed);
+    store_max(&flush_max_bytes, bytes);
+    atomic_fetch_add_explicit(&bytes_written, bytes, memory_order_relaxed);
+}
+
+void dlogger_metrics_write_error(void) {
+    atomic_fetch_add_explicit(&write_errors, 1, memory_order_relaxed);
+}
+
+void dlogger_metrics_read(dlogger_stats_t *stats) {
+    for (int s = 0; s < LOG_SOURCE_COUNT; s++) {
+        for (int l = 0; l < LOG_LEVEL_COUNT; l++) {
+            stats->entries[s][l] = atomic_load_explicit(&stored[s][l], memory_order_relaxed);
+            stats->entries_dropped[s][l] = atomic_load_explicit(&dropped[s][l],
+                                                                memory_order_relaxed);
+        }
+    }
+    for (int i = 0; i < DLOGGER_STATS_BUCKETS; i++) {
+        stats->enqueue_ns_hist[i] = atomic_load_explicit(&enqueue_hist[i], memory_order_relaxed);
+        stats->flush_us_hist[i] = atomic_load_explicit(&flush_hist[i], memory_order_relaxed);
+    }
+    stats->enqueue_ns_max = atomic_load_explicit(&enqueue_max_ns, memory_order_relaxed);
+    stats->flushes = atomic_load_explicit(&flushes, memory_order_relaxed);
+    stats->flush_us_last = atomic_load_explicit(&flush_last_us, memory_order_relaxed);
+    stats->flush_us_max = atomic_load_explicit(&flush_max_us, memory_order_relaxed);
+    stats->flush_bytes_last = atomic_load_explicit(&flush_last_bytes, memory_order_relaxed);
+    stats->flush_bytes_max = atomic_load_explicit(&flush_max_bytes, memory_order_relaxed);
+    stats->bytes_written = atomic_load_explicit(&bytes_written, memory_order_relaxed);
+    stats->write_errors = atomic_load_explicit(&write_errors, memory_order_relaxed);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+ * @file dlogger_metrics.h
+ * @brief Runtime counters and histograms behind dlogger_get_stats() (private to dlogger)
+ *
+ * Everything is a relaxed atomic counter in internal RAM: producers pay one
+ * increment per entry (plus two cycle-counter reads for the enqueue
+ * histogram with CONFIG_DLOGGER_STATS_TIMING), and readers copy the
+ * counters without taking a lock, so the UI can poll them cheaply.
+ *
+ * Histograms use DLOGGER_STATS_BUCKETS power-of-two buckets: bucket i
+ * counts samples below DLOGGER_METRICS_BUCKET_BASE << i (nanoseconds for
+ * enqueues, microseconds for flushes); the last bucket takes the rest.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dlogger.h"
+#include "sdkconfig.h"
+
+#define DLOGGER_METRICS_BUCKET_BASE  256    ///< Upper bound of bucket 0 (ns or µs)
+
+/**
+ * @brief Count an entry stored in a ring
+ */
+void dlogger_metrics_stored(uint8_t source, uint8_t level);
+
+/**
+ * @brief Count an entry the overflow policy refused
+ */
+void dlogger_metrics_dropped(uint8_t source, uint8_t level);
+
+/**
+ * @brief Start timing an enqueue (0 with CONFIG_DLOGGER_STATS_TIMING off)
+ */
+uint32_t dlogger_metrics_enqueue_begin(void);
+
+/**
+ * @brief Add the time since dlogger_metrics_enqueue_begin() to the histogram
+ */
+void dlogger_metrics_enqueue_end(uint32_t begin);
+
+/**
+ * @brief Record one flush (flush task only)
+ *
+ * @param begin dlogger_port_cycles() when the drain started
+ * @param bytes Block bytes written to the store
+ */
+void dlogger_metrics_flush(uint32_t begin, uint32_t bytes);
+
+/**
+ * @brief Count a block that could not be written
+ */
+void dlogger_metrics_write_error(void);
+
+/**
+ * @brief Copy the counters into the matching `stats` fields
+ */
+void dlogger_metrics_read(dlogger_stats_t *stats);
@@ -0,0 +1,316 @@
+#pragma once
+
+/**
+ * @file dlogger_port.h
+ * @brief Platform shims for dlogger (private)
+ *
+ * dlogger builds both for the ESP32-S3 firmware and for the ESP-IDF
+ * `linux` host target (POSIX FreeRTOS port), where there is no PSRAM,
+ * no esp_timer and only one "core", and logs go to ./storage instead of
+ * the SPIFFS partition. Everything target-specific lives here so
+ * dlogger.c itself stays platform-agnostic.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+
+#include <stdbool.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <link.h>          // dl_iterate_phdr (ESP-IDF builds with _GNU_SOURCE)
+#include <stdatomic.h>
+#else
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_app_desc.h"
+#endif
+
+#include <string.h>
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#define DLOGGER_PORT_FLUSH_CORE  0              ///< Host port only has core 0
+#define DLOGGER_PORT_NUM_CORES   1
+#define DLOGGER_PORT_LOG_DIR     "storage"      ///< Relative to the working directory
+#define DLOGGER_PORT_RETAINED_ATTR              ///< See dlogger_port_retained_map()
+#define DLOGGER_PORT_RETAINED_FILE DLOGGER_PORT_LOG_DIR "/dlogger_retained.bin"
+#else
+#define DLOGGER_PORT_FLUSH_CORE  PRO_CPU_NUM    ///< Keep flushing off the LVGL core
+#define DLOGGER_PORT_NUM_CORES   portNUM_PROCESSORS
+#define DLOGGER_PORT_LOG_DIR     "/storage"     ///< SPIFFS mount point (storage component)
+#define DLOGGER_PORT_RETAINED_ATTR __NOINIT_ATTR ///< Internal RAM not cleared at reset
+#endif
+
+/**
+ * @brief Milliseconds since boot (or since process start on the host)
+ */
+static inline uint32_t dlogger_port_time_ms(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+#else
+    return (uint32_t)(esp_timer_get_time() / 1000);
+#endif
+}
+
+/**
+ * @brief Free-running counter for timing short sections (CPU cycles,
+ *        nanoseconds on the host); wraps, so only differences count
+ */
+static inline uint32_t dlogger_port_cycles(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+#else
+    return (uint32_t)esp_cpu_get_cycle_count();
+#endif
+}
+
+/**
+ * @brief dlogger_port_cycles() counts per microsecond
+ */
+static inline uint32_t dlogger_port_cycles_per_us(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    return 1000;
+#else
+    return esp_rom_get_cpu_ticks_per_us();
+#endif
+}
+
+/**
+ * @brief Allocate a large buffer, preferring PSRAM
+ *
+ * @return Pointer to memory, or NULL if PSRAM is unavailable/exhausted
+ */
+static inline void *dlogger_port_alloc_psram(size_t size) {
+#if CONFIG_IDF_TARGET_LINUX
+    return malloc(size);
+#else
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+}
+
+/**
+ * @brief Allocate memory that must stay in internal RAM
+ *
+ * Used for anything touched with atomic read-modify-write instructions,
+ * which are not reliable on PSRAM.
+ */
+static inline void *dlogger_port_alloc_internal(size_t size) {
+#if CONFIG_IDF_TARGET_LINUX
+    return malloc(size);
+#else
+    return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+#define DLOGGER_PORT_RO_RANGES  8
+
+/**
+ * @brief Non-writable load segments of the executable
+ */
+typedef struct {
+    uint32_t count;
+    uintptr_t start[DLOGGER_PORT_RO_RANGES];
+    uintptr_t end[DLOGGER_PORT_RO_RANGES];
+} dlogger_port_ro_t;
+
+static inline int dlogger_port_ro_collect(struct dl_phdr_info *info, size_t size, void *arg) {
+    dlogger_port_ro_t *ro = (dlogger_port_ro_t *)arg;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+        if (ph->p_type == PT_LOAD && !(ph->p_flags & PF_W) && ro->count < DLOGGER_PORT_RO_RANGES) {
+            ro->start[ro->count] = (uintptr_t)(info->dlpi_addr + ph->p_vaddr);
+            ro->end[ro->count] = ro->start[ro->count] + ph->p_memsz;
+            ro->count++;
+        }
+    }
+    return 1;   // The executable comes first; literals of shared libraries are copied
+}
+#endif
+
+/**
+ * @brief Whether `ptr` is in read-only program data (string literals)
+ *
+ * Such pointers stay valid forever, so a record may keep the address
+ * instead of a copy.
+ */
+static inline bool dlogger_port_ptr_is_static(const void *ptr) {
+#if CONFIG_IDF_TARGET_LINUX
+    // Non-writable load segments (.rodata, .text); [etext, edata) would
+    // also take writable .data, whose contents change before the record
+    // is rendered
+    static dlogger_port_ro_t ro;
+    static atomic_int state;    // 0 = not collected, 1 = collecting, 2 = ready
+    int seen = atomic_load_explicit(&state, memory_order_acquire);
+    if (seen != 2) {
+        if (seen != 0 || !atomic_compare_exchange_strong(&state, &seen, 1)) {
+            return false;       // Another caller is collecting: copy this time
+        }
+        dl_iterate_phdr(dlogger_port_ro_collect, &ro);
+        atomic_store_explicit(&state, 2, memory_order_release);
+    }
+    for (uint32_t i = 0; i < ro.count; i++) {
+        if ((uintptr_t)ptr >= ro.start[i] && (uintptr_t)ptr < ro.end[i]) {
+            return true;
+        }
+    }
+    return false;
+#else
+    return esp_ptr_in_drom(ptr);
+#endif
+}
+
+/**
+ * @brief Identity of the running firmware image and where it is loaded
+ *
+ * Format addresses kept across a reset (crash tail) are only meaningful
+ * for the same image: `id` tells images apart, and `base` is added to
+ * translate an address between two runs of it (0 on the target, whose
+ * flash mapping is fixed; the load bias of a position-independent host
+ * executable).
+ */
+typedef struct {
+    uint32_t id;
+    uintptr_t base;
+} dlogger_port_image_t;
+
+#if CONFIG_IDF_TARGET_LINUX
+static inline int dlogger_port_image_collect(struct dl_phdr_info *info, size_t size, void *arg) {
+    dlogger_port_image_t *image = (dlogger_port_image_t *)arg;
+    image->base = (uintptr_t)info->dlpi_addr;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+        const uint8_t *at = (const uint8_t *)(info->dlpi_addr + ph->p_vaddr);
+        if (ph->p_type == PT_NOTE) {
+            // GNU build id note, if the linker added one
+            for (size_t o = 0; o + sizeof(ElfW(Nhdr)) <= ph->p_memsz; ) {
+                const ElfW(Nhdr) *note = (const ElfW(Nhdr) *)(at + o);
+                const uint8_t *desc = (const uint8_t *)(note + 1) + ((note->n_namesz + 3) & ~3u);
+                if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 &&
+                    memcmp(note + 1, "GNU", 4) == 0) {
+                    image->id = esp_rom_crc32_le(0, desc, note->n_descsz);
+                    return 1;
+                }
+                o += sizeof(*note) + ((note->n_namesz + 3) & ~3u) + ((note->n_descsz + 3) & ~3u);
+            }
+        }
+    }
+    // No build id: the read-only segments themselves
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+        if (ph->p_type == PT_LOAD && !(ph->p_flags & PF_W)) {
+            image->id = esp_rom_crc32_le(image->id,
+                                         (const uint8_t *)(info->dlpi_addr + ph->p_vaddr),
+                                         (uint32_t)ph->p_filesz);
+        }
+    }
+    return 1;
+}
+#endif
+
+static inline void dlogger_port_image(dlogger_port_image_t *image) {
+    image->id = 0;
+    image->base = 0;
+#if CONFIG_IDF_TARGET_LINUX
+    dl_iterate_phdr(dlogger_port_image_collect, image);
+#else
+    const esp_app_desc_t *desc = esp_app_get_description();
+    image->id = esp_rom_crc32_le(0, desc->app_elf_sha256, sizeof(desc->app_elf_sha256));
+#endif
+}
+
+/**
+ * @brief Index of the calling core (0 on the host)
+ */
+static inline uint32_t dlogger_port_core_id(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    return 0;
+#else
+    return (uint32_t)xPortGetCoreID();
+#endif
+}
+
+/**
+ * @brief Whether the caller runs in interrupt context (never on the host)
+ */
+static inline bool dlogger_port_in_isr(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    return false;
+#else
+    return xPortInIsrContext();
+#endif
+}
+
+/**
+ * @brief Mask interrupts on the calling core (task or ISR context, nests)
+ *
+ * Makes a few instructions atomic with respect to nested ISRs on this
+ * core. No-op on the host, where per-core data is protected by CAS alone.
+ */
+static inline uint32_t dlogger_port_irq_mask(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    return 0;
+#else
+    return (uint32_t)portSET_INTERRUPT_MASK_FROM_ISR();
+#endif
+}
+
+static inline void dlogger_port_irq_restore(uint32_t state) {
+#if CONFIG_IDF_TARGET_LINUX
+    (void)state;
+#else
+    portCLEAR_INTERRUPT_MASK_FROM_ISR((UBaseType_t)state);
+#endif
+}
+
+/**
+ * @brief Memory whose contents survive a reset (not a power cycle)
+ *
+ * On the target this is `ram` itself, a DLOGGER_PORT_RETAINED_ATTR buffer:
+ * it keeps its contents across panics, watchdog resets and esp_restart().
+ * On the host a file (DLOGGER_PORT_RETAINED_FILE) is mapped instead, so a
+ * process that is killed and started again stands in for a reset.
+ *
+ * @return The memory to use, or NULL if the host file cannot be mapped
+ */
+static inline void *dlogger_port_retained_map(void *ram, size_t size) {
+#if CONFIG_IDF_TARGET_LINUX
+    (void)ram;
+    int fd = open(DLOGGER_PORT_RETAINED_FILE, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return NULL;
+    void *mem = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0) {
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    return (mem == MAP_FAILED) ? NULL : mem;
+#else
+    (void)size;
+    return ram;
+#endif
+}
+
+/**
+ * @brief Release memory returned by dlogger_port_retained_map()
+ */
+static inline void dlogger_port_retained_unmap(void *mem, size_t size) {
+#if CONFIG_IDF_TARGET_LINUX
+    munmap(mem, size);
+#else
+    (void)mem; (void)size;
+#endif
+}
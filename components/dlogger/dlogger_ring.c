@@ -0,0 +1,720 @@
+#include "dlogger_ring.h"
+#include "dlogger_port.h"
+#include "dlogger_fmt.h"
+#include "dlogger_tag.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+/**
+ * @brief Bytes occupied by an entry record with `msg_len` message bytes
+ */
+static inline uint32_t rec_size(uint32_t msg_len) {
+    return (uint32_t)((sizeof(dlogger_rec_t) + DLOGGER_REC_SEQ_SIZE + msg_len +
+                       DLOGGER_REC_ALIGN - 1) & ~(uint32_t)(DLOGGER_REC_ALIGN - 1));
+}
+
+/**
+ * @brief Bytes occupied by the record with header `hdr` (entry or padding)
+ */
+static inline uint32_t rec_span(const dlogger_rec_t *hdr) {
+    if (hdr->source == DLOGGER_REC_PAD) {
+        return (uint32_t)((sizeof(dlogger_rec_t) + hdr->length + DLOGGER_REC_ALIGN - 1) &
+                          ~(uint32_t)(DLOGGER_REC_ALIGN - 1));
+    }
+    return rec_size(hdr->length);
+}
+
+static inline dlogger_rec_t *rec_at(dlogger_ring_t *ring, uint32_t pos) {
+    return (dlogger_rec_t *)(ring->buf + (pos & ring->mask));
+}
+
+static inline void commit_bit_set(dlogger_ring_t *ring, uint32_t pos) {
+    uint32_t granule = (pos & ring->mask) / DLOGGER_REC_ALIGN;
+    atomic_fetch_or_explicit(&ring->commit_map[granule >> 5], 1u << (granule & 31),
+                             memory_order_release);
+}
+
+static inline void commit_bit_clear(dlogger_ring_t *ring, uint32_t pos) {
+    uint32_t granule = (pos & ring->mask) / DLOGGER_REC_ALIGN;
+    atomic_fetch_and_explicit(&ring->commit_map[granule >> 5], ~(1u << (granule & 31)),
+                              memory_order_relaxed);
+}
+
+static inline bool commit_bit_test(dlogger_ring_t *ring, uint32_t pos) {
+    uint32_t granule = (pos & ring->mask) / DLOGGER_REC_ALIGN;
+    return (atomic_load_explicit(&ring->commit_map[granule >> 5], memory_order_acquire) &
+            (1u << (granule & 31))) != 0;
+}
+
+/**
+ * @brief Clear the metadata of `len` bytes from `pos` (contiguous in the arena)
+ */
+static inline void meta_clear(dlogger_ring_t *ring, uint32_t pos, uint32_t len) {
+    memset(ring->meta + (pos & ring->mask) / DLOGGER_REC_ALIGN, 0, len / DLOGGER_REC_ALIGN);
+}
+
+/**
+ * @brief Whether the record at `pos` is committed (or already consumed)
+ */
+static inline bool rec_is_committed(dlogger_ring_t *ring, uint32_t pos) {
+    if (commit_bit_test(ring, pos)) return true;
+    // The consumer clears the bit when it moves past a record
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return (int32_t)(tail - pos) > 0;
+}
+
+/**
+ * @brief Give the oldest flushed record's space back to producers
+ *
+ * @return false if nothing is reclaimable (every record is unflushed, or
+ *         a span reader holds the oldest record)
+ */
+static bool reclaim_oldest(dlogger_ring_t *ring, uint32_t free_pos) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (free_pos == tail) {
+        return false;
+    }
+    if (atomic_load(&ring->hold_active) &&
+        (int32_t)(atomic_load(&ring->hold) - free_pos) <= 0) {
+        return false;
+    }
+    if (commit_bit_test(ring, free_pos)) {
+        return false;   // Taken by the consumer or an evictor that is still reading it
+    }
+
+    // Records behind tail are complete and immutable until reclaimed. If
+    // another producer already reclaimed this one the CAS simply fails.
+    uint32_t len = rec_span(rec_at(ring, free_pos));
+    atomic_compare_exchange_strong_explicit(&ring->free, &free_pos, free_pos + len,
+                                            memory_order_acq_rel, memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Private copy of a record, large enough for any message we decode
+ */
+typedef struct {
+    dlogger_rec_t hdr;
+    uint32_t seq;            ///< Keeps dlogger_rec_message() valid on the copy
+    uint8_t payload[256];
+} rec_snapshot_t;
+
+/**
+ * @brief Copy a record out of the arena before it is validated/decoded
+ *
+ * The header may be torn if the record is being overwritten, so the copy
+ * is clamped to the end of the arena and to the snapshot; callers validate
+ * against `head` before trusting (or rendering) the copy.
+ */
+static void rec_snapshot(dlogger_ring_t *ring, uint32_t pos, rec_snapshot_t *snap) {
+    const dlogger_rec_t *rec = rec_at(ring, pos);
+    snap->hdr = *rec;
+    size_t copy = snap->hdr.length;
+    size_t room = ring->size - (pos & ring->mask) - sizeof(dlogger_rec_t) - DLOGGER_REC_SEQ_SIZE;
+    if (copy > room) {
+        copy = room;
+    }
+    if (copy > sizeof(snap->payload)) {
+        copy = sizeof(snap->payload);
+    }
+    snap->hdr.length = (uint16_t)copy;
+    snap->seq = dlogger_rec_seq(rec);
+    memcpy(snap->payload, dlogger_rec_message(rec), copy);
+}
+
+/**
+ * @brief Convert a validated snapshot into the public fixed-size entry layout
+ */
+static void rec_decode(const rec_snapshot_t *snap, dlogger_entry_t *entry) {
+    entry->timestamp = snap->hdr.timestamp;
+    entry->source = snap->hdr.source;
+    entry->level = snap->hdr.level & DLOGGER_REC_LEVEL_MASK;
+    dlogger_rec_render(&snap->hdr, entry->message, sizeof(entry->message));
+}
+
+// ============================================================================
+// RECORD RENDERING
+// ============================================================================
+
+size_t dlogger_payload_render(const dlogger_rec_t *hdr, const void *payload,
+                              char *out, size_t out_len) {
+    if (!out || out_len == 0) return 0;
+
+    if (hdr->level & DLOGGER_REC_FLAG_DEFERRED) {
+        return dlogger_fmt_render((const uint8_t *)payload, hdr->length, out, out_len);
+    }
+
+    const char *text = (const char *)payload;
+    size_t length = hdr->length;
+    size_t used = 0;
+    if ((hdr->level & DLOGGER_REC_FLAG_TAGGED) && length > 0) {
+        used = dlogger_tag_render_prefix((uint8_t)text[0], hdr->level & DLOGGER_REC_LEVEL_MASK,
+                                         hdr->timestamp, out, out_len);
+        text++;
+        length--;
+    }
+
+    size_t copy = (length < out_len - 1 - used) ? length : out_len - 1 - used;
+    memcpy(out + used, text, copy);
+    out[used + copy] = '\0';
+    return used + copy;
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+esp_err_t dlogger_ring_init(dlogger_ring_t *ring, uint32_t size) {
+    if (!ring || size < 1024 || (size & (size - 1)) != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Arena is plain data and may live in PSRAM; the commit map is touched
+    // with atomic RMW instructions and must stay in internal RAM
+    ring->buf = (uint8_t *)dlogger_port_alloc_psram(size);
+    if (!ring->buf) {
+        ring->buf = (uint8_t *)malloc(size);
+    }
+    size_t map_bytes = size / DLOGGER_REC_ALIGN / 8;
+    ring->commit_map = (_Atomic uint32_t *)dlogger_port_alloc_internal(map_bytes);
+    // Filtered reads scan the metadata instead of the arena, so keep it
+    // in internal RAM when there is room
+    size_t meta_bytes = size / DLOGGER_REC_ALIGN;
+    ring->meta = (uint8_t *)dlogger_port_alloc_internal(meta_bytes);
+    if (!ring->meta) {
+        ring->meta = (uint8_t *)dlogger_port_alloc_psram(meta_bytes);
+    }
+
+    if (!ring->buf || !ring->commit_map || !ring->meta) {
+        free(ring->buf);
+        free((void *)ring->commit_map);
+        free(ring->meta);
+        ring->buf = NULL;
+        ring->commit_map = NULL;
+        ring->meta = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset((void *)ring->commit_map, 0, map_bytes);
+    memset(ring->meta, 0, meta_bytes);
+    ring->size = size;
+    ring->mask = size - 1;
+    atomic_store(&ring->head, 0);
+    atomic_store(&ring->tail, 0);
+    atomic_store(&ring->free, 0);
+    atomic_store(&ring->hold, 0);
+    atomic_store(&ring->hold_active, false);
+    return ESP_OK;
+}
+
+void dlogger_ring_deinit(dlogger_ring_t *ring) {
+    if (!ring) return;
+    free(ring->buf);
+    free((void *)ring->commit_map);
+    free(ring->meta);
+    ring->buf = NULL;
+    ring->commit_map = NULL;
+    ring->meta = NULL;
+}
+
+// ============================================================================
+// PRODUCER SIDE
+// ============================================================================
+
+bool dlogger_ring_reserve(dlogger_ring_t *ring, size_t msg_len, dlogger_ring_resv_t *resv) {
+    if (msg_len > DLOGGER_REC_MAX_LENGTH) return false;
+
+    uint32_t need = rec_size((uint32_t)msg_len);
+    if (need > ring->size / 4) return false;
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t total;
+    uint32_t contiguous;
+
+    for (;;) {
+        contiguous = ring->size - (head & ring->mask);
+        total = (need <= contiguous) ? need : contiguous + need;
+
+        // Sequentially consistent with ring_hold(): a producer that missed
+        // a new hold still bounded its reservation by a `free` <= hold
+        uint32_t free_pos = atomic_load(&ring->free);
+        uint32_t limit = free_pos;
+        if (atomic_load(&ring->hold_active)) {
+            uint32_t hold = atomic_load(&ring->hold);
+            if ((int32_t)(hold - limit) < 0) {
+                limit = hold;
+            }
+        }
+        if (head + total - limit > ring->size) {
+            // Out of room: overwrite the oldest flushed record, or drop
+            if (!reclaim_oldest(ring, free_pos)) {
+                return false;
+            }
+            head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&ring->head, &head, head + total,
+                                                  memory_order_acq_rel,
+                                                  memory_order_relaxed)) {
+            break;
+        }
+        // CAS failure reloaded `head`, retry
+    }
+
+    // Reclaimed history may have left metadata here; filtered readers
+    // must only find record starts once they are committed
+    uint32_t pos = head;
+    meta_clear(ring, head, (total != need) ? contiguous : need);
+    if (total != need) {
+        // Pad to the end of the arena so the record itself is contiguous
+        meta_clear(ring, 0, need);
+        dlogger_rec_t *pad = rec_at(ring, head);
+        pad->timestamp = 0;
+        pad->length = (uint16_t)(contiguous - sizeof(dlogger_rec_t));   // No sequence number
+        pad->source = DLOGGER_REC_PAD;
+        pad->level = 0;
+        commit_bit_set(ring, head);
+        pos = head + contiguous;
+    }
+
+    resv->rec = rec_at(ring, pos);
+    resv->pos = pos;
+    resv->start = head;
+    resv->end = head + total;
+    return true;
+}
+
+uint32_t dlogger_ring_commit(dlogger_ring_t *ring, const dlogger_ring_resv_t *resv) {
+    uint32_t used = resv->pos + rec_span(resv->rec);
+    if (used != resv->end) {
+        // Shrunk after reserve: the rest becomes padding (published first,
+        // so the consumer never stops on it)
+        dlogger_rec_t *pad = rec_at(ring, used);
+        pad->timestamp = 0;
+        pad->length = (uint16_t)(resv->end - used - sizeof(dlogger_rec_t));
+        pad->source = DLOGGER_REC_PAD;
+        pad->level = 0;
+        commit_bit_set(ring, used);
+    }
+    if (resv->rec->source != DLOGGER_REC_PAD) {
+        ring->meta[(resv->pos & ring->mask) / DLOGGER_REC_ALIGN] =
+            dlogger_rec_meta(resv->rec->source, resv->rec->level);
+    }
+    commit_bit_set(ring, resv->pos);
+    return resv->end - atomic_load_explicit(&ring->tail, memory_order_relaxed);
+}
+
+// ============================================================================
+// CONSUMER SIDE
+// ============================================================================
+
+/**
+ * @brief Move `tail` past the record at `pos` (consumer or evicting producer)
+ *
+ * The record's commit bit stays set until the caller clears it, and
+ * producers never reclaim a record whose bit is set, so the caller can
+ * keep reading it in place.
+ *
+ * @return false if `tail` was no longer `pos`
+ */
+static inline bool tail_advance(dlogger_ring_t *ring, uint32_t pos) {
+    // Only used if the CAS succeeds, i.e. while the header was still intact
+    uint32_t len = rec_span(rec_at(ring, pos));
+    return atomic_compare_exchange_strong_explicit(&ring->tail, &pos, pos + len,
+                                                   memory_order_acq_rel,
+                                                   memory_order_relaxed);
+}
+
+const dlogger_rec_t *dlogger_ring_peek(dlogger_ring_t *ring) {
+    for (;;) {
+        uint32_t pos = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (pos == atomic_load_explicit(&ring->head, memory_order_acquire) ||
+            !commit_bit_test(ring, pos)) {
+            return NULL;    // Empty, or producer still filling this record
+        }
+
+        const dlogger_rec_t *rec = rec_at(ring, pos);
+        if (rec->source != DLOGGER_REC_PAD) {
+            ring->peek_pos = pos;
+            return rec;
+        }
+        if (tail_advance(ring, pos)) {
+            commit_bit_clear(ring, pos);
+        }
+    }
+}
+
+bool dlogger_ring_take(dlogger_ring_t *ring) {
+    return tail_advance(ring, ring->peek_pos);
+}
+
+void dlogger_ring_consume(dlogger_ring_t *ring) {
+    commit_bit_clear(ring, ring->peek_pos);
+}
+
+int dlogger_ring_evict(dlogger_ring_t *ring, uint32_t level_mask) {
+    uint32_t pos = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (pos == atomic_load_explicit(&ring->head, memory_order_acquire) ||
+        !commit_bit_test(ring, pos)) {
+        return 0;   // Empty, or the oldest record is not committed yet
+    }
+    if (atomic_load_explicit(&ring->free, memory_order_acquire) != pos) {
+        // Flushed history is not reclaimable yet (held by a reader or still
+        // being written by the consumer): evicting would not make room
+        return 0;
+    }
+
+    // Committed and not yet passed by `tail`: the header cannot change
+    dlogger_rec_t hdr = *rec_at(ring, pos);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&ring->tail, memory_order_relaxed) != pos) {
+        return -1;  // Taken meanwhile
+    }
+
+    bool entry = (hdr.source != DLOGGER_REC_PAD);
+    if (entry && !(level_mask & (1u << (hdr.level & DLOGGER_REC_LEVEL_MASK)))) {
+        return 0;
+    }
+    uint32_t expected = pos;
+    if (!atomic_compare_exchange_strong_explicit(&ring->tail, &expected, pos + rec_span(&hdr),
+                                                 memory_order_acq_rel, memory_order_relaxed)) {
+        return -1;
+    }
+    commit_bit_clear(ring, pos);
+    return entry ? 1 : -1;
+}
+
+// ============================================================================
+// READER SIDE (LOCK-FREE SNAPSHOT)
+// ============================================================================
+
+/**
+ * @brief Top bit set in every non-zero byte of `x`, all other bits clear
+ */
+static inline uint32_t swar_nonzero(uint32_t x) {
+    return (((x & 0x7F7F7F7Fu) + 0x7F7F7F7Fu) | x) & 0x80808080u;
+}
+
+/**
+ * @brief Whether a metadata byte passes the filter's source and level bits
+ */
+static inline bool meta_matches(uint8_t meta, const dlogger_ring_filter_t *filter) {
+    return (meta & (uint8_t)filter->sources) && (meta & (uint8_t)filter->levels);
+}
+
+/**
+ * @brief Run the filter's predicate on a validated copy of the record at `pos`
+ *
+ * @return 1 if it matches, 0 if not, -1 if producers lapped the copy
+ */
+static int rec_predicate(dlogger_ring_t *ring, uint32_t pos, const dlogger_ring_filter_t *filter) {
+    if (!filter->match) return 1;
+
+    rec_snapshot_t snap;
+    rec_snapshot(ring, pos, &snap);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&ring->head, memory_order_relaxed) - pos > ring->size) {
+        return -1;
+    }
+    return filter->match(&snap.hdr, filter->match_ctx) ? 1 : 0;
+}
+
+/**
+ * @brief Find the matching records in the flushed range [pos, end)
+ *
+ * Flushed records do not change until reclaimed, so their metadata bytes
+ * are scanned a word (four granules) at a time and record headers are
+ * never read. Interior and padding granules have no metadata and never
+ * match.
+ */
+static bool scan_flushed(dlogger_ring_t *ring, uint32_t pos, uint32_t end,
+                         const dlogger_ring_filter_t *filter,
+                         uint32_t *positions, size_t max, size_t *found) {
+    while (pos != end) {
+        uint32_t granule = (pos & ring->mask) / DLOGGER_REC_ALIGN;
+        uint32_t hits;
+        uint32_t step;
+        if ((granule & 3) == 0 && end - pos >= 4 * DLOGGER_REC_ALIGN) {
+            uint32_t word;
+            memcpy(&word, ring->meta + granule, sizeof(word));
+            hits = swar_nonzero(word & filter->sources) & swar_nonzero(word & filter->levels);
+            step = 4;
+        } else {
+            hits = meta_matches(ring->meta[granule], filter) ? 0x80u : 0;
+            step = 1;
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&ring->head, memory_order_relaxed) - pos > ring->size) {
+            return false;   // Reclaimed and reused while scanning
+        }
+
+        while (hits) {
+            // Little-endian: byte i of the word is granule + i
+            uint32_t p = pos + (uint32_t)(__builtin_ctz(hits) / 8) * DLOGGER_REC_ALIGN;
+            hits &= hits - 1;
+            int match = rec_predicate(ring, p, filter);
+            if (match < 0) return false;
+            if (match) {
+                positions[*found % max] = p;
+                (*found)++;
+            }
+        }
+        pos += step * DLOGGER_REC_ALIGN;
+    }
+    return true;
+}
+
+/**
+ * @brief Walk record boundaries from `pos`, remembering the last `max`
+ *        record positions (records have no back links)
+ *
+ * With a filter only matching records are remembered and counted, and
+ * flushed records are found through the metadata (scan_flushed()).
+ *
+ * @param filter Records to keep (NULL = all)
+ * @param end Set to the position where the walk stopped (optional)
+ * @return false if producers lapped the walk (positions are unusable)
+ */
+static bool collect_latest(dlogger_ring_t *ring, uint32_t pos, const dlogger_ring_filter_t *filter,
+                           uint32_t *positions, size_t max, size_t *found, uint32_t *end) {
+    *found = 0;
+    if (filter) {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if ((int32_t)(tail - pos) > 0) {
+            if (!scan_flushed(ring, pos, tail, filter, positions, max, found)) return false;
+            pos = tail;
+        }
+    }
+
+    for (;;) {
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (pos == head) break;
+        if (head - pos > ring->size) {
+            return false;   // Lapped by producers (or walked off a torn header)
+        }
+        if (!rec_is_committed(ring, pos)) break;
+
+        dlogger_rec_t hdr = *rec_at(ring, pos);
+        bool keep = (hdr.source != DLOGGER_REC_PAD);
+        if (keep && filter) {
+            keep = meta_matches(ring->meta[(pos & ring->mask) / DLOGGER_REC_ALIGN], filter);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&ring->head, memory_order_relaxed) - pos > ring->size) {
+            return false;
+        }
+
+        if (keep && filter) {
+            int match = rec_predicate(ring, pos, filter);
+            if (match < 0) return false;
+            keep = (match > 0);
+        }
+        if (keep) {
+            positions[*found % max] = pos;
+            (*found)++;
+        }
+        pos += rec_span(&hdr);
+    }
+    if (end) *end = pos;
+    return true;
+}
+
+/**
+ * @brief Whether producers may have reused the record at `pos` by now
+ */
+static inline bool rec_overwritten(dlogger_ring_t *ring, uint32_t pos) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&ring->head, memory_order_relaxed) - pos > ring->size;
+}
+
+bool dlogger_ring_read_begin(dlogger_ring_t *ring, size_t max_entries,
+                             dlogger_ring_read_iter_t *it) {
+    memset(it, 0, sizeof(*it));
+    it->ring = ring;
+    it->begin = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (!ring->buf || max_entries == 0) return false;
+
+    it->positions = (uint32_t *)malloc(max_entries * sizeof(uint32_t));
+    if (!it->positions) return false;
+    it->max = max_entries;
+
+    for (int attempt = 0; attempt < 3; attempt++) {
+        uint32_t oldest = atomic_load_explicit(&ring->free, memory_order_acquire);
+        if (collect_latest(ring, oldest, NULL, it->positions, max_entries, &it->found, NULL)) {
+            it->begin = oldest;
+            return true;
+        }
+    }
+    it->found = 0;
+    return true;
+}
+
+bool dlogger_ring_read_peek(dlogger_ring_read_iter_t *it, uint32_t *timestamp, uint32_t *seq) {
+    size_t n = (it->found < it->max) ? it->found : it->max;
+    while (!it->peeked && it->next < n) {
+        uint32_t pos = it->positions[(it->found - 1 - it->next) % it->max];
+        const dlogger_rec_t *rec = rec_at(it->ring, pos);
+        it->hdr = *rec;
+        it->seq = dlogger_rec_seq(rec);
+        if (rec_overwritten(it->ring, pos)) {
+            it->next = it->max;     // Older records are gone too
+            break;
+        }
+        it->peeked = true;
+    }
+    if (!it->peeked) return false;
+    *timestamp = it->hdr.timestamp;
+    *seq = it->seq;
+    return true;
+}
+
+bool dlogger_ring_read_take(dlogger_ring_read_iter_t *it, dlogger_entry_t *dest) {
+    uint32_t timestamp, seq;
+    if (!dlogger_ring_read_peek(it, &timestamp, &seq)) return false;
+    uint32_t pos = it->positions[(it->found - 1 - it->next) % it->max];
+    it->peeked = false;
+    it->next++;
+
+    rec_snapshot_t snap;
+    rec_snapshot(it->ring, pos, &snap);
+    if (rec_overwritten(it->ring, pos)) {
+        it->next = it->max;
+        return false;
+    }
+    // Only a validated copy is rendered (deferred records hold pointers)
+    rec_decode(&snap, dest);
+    return true;
+}
+
+void dlogger_ring_read_end(dlogger_ring_read_iter_t *it) {
+    free(it->positions);
+    it->positions = NULL;
+}
+
+// ============================================================================
+// READER SIDE (ZERO-COPY SPANS)
+// ============================================================================
+
+/**
+ * @brief Stop producers from reclaiming records from `pos` on
+ *
+ * @return false if a producer reclaimed `pos` before it saw the hold
+ */
+static bool ring_hold(dlogger_ring_t *ring, uint32_t pos) {
+    atomic_store(&ring->hold, pos);
+    atomic_store(&ring->hold_active, true);
+
+    // Sequentially consistent with dlogger_ring_reserve(): if `free` has
+    // not passed `pos` now, no producer can reserve over it any more
+    uint32_t free_pos = atomic_load(&ring->free);
+    if ((int32_t)(free_pos - pos) > 0) {
+        atomic_store(&ring->hold_active, false);
+        return false;
+    }
+    return true;
+}
+
+static void ring_release(dlogger_ring_t *ring) {
+    atomic_store(&ring->hold_active, false);
+}
+
+/**
+ * @brief Collect the newest `max_entries` records from `from` on and hold them
+ *
+ * @param from Oldest position of interest, or NULL for the oldest record
+ * @param filter Records to keep (NULL = all)
+ * @param skipped Set if records after `from` were reclaimed or left out
+ *                for `max_entries` (optional)
+ */
+static bool span_begin_at(dlogger_ring_t *ring, const uint32_t *from,
+                          const dlogger_ring_filter_t *filter, size_t max_entries,
+                          dlogger_ring_span_iter_t *it, bool *skipped) {
+    bool skip = false;
+    memset(it, 0, sizeof(*it));
+    if (!ring->buf || max_entries == 0) return false;
+
+    it->positions = (uint32_t *)malloc(max_entries * sizeof(uint32_t));
+    if (!it->positions) return false;
+    it->ring = ring;
+    it->max = max_entries;
+    it->end = from ? *from : 0;
+
+    // Hold only the newest `max_entries` records, so producers can keep
+    // reclaiming older history while the caller uses the spans
+    bool empty = false;
+    for (int attempt = 0; attempt < 3 && !it->held && !empty; attempt++) {
+        uint32_t oldest = atomic_load_explicit(&ring->free, memory_order_acquire);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        skip = false;
+        if (from && (int32_t)(head - *from) >= 0) {
+            if ((int32_t)(*from - oldest) >= 0) {
+                oldest = *from;
+            } else {
+                skip = true;    // Reclaimed before it was read
+            }
+        }
+        uint32_t end;
+        if (!collect_latest(ring, oldest, filter, it->positions, max_entries, &it->found, &end)) {
+            continue;
+        }
+        it->begin = oldest;
+        skip |= (it->found > max_entries);
+        if (it->found == 0) {
+            it->end = end;
+            empty = true;
+            break;
+        }
+
+        uint32_t start = it->positions[(it->found > max_entries) ? it->found % max_entries : 0];
+        if (!ring_hold(ring, start)) continue;
+        it->held = true;
+
+        // Re-walk under the hold (cannot be lapped now) to pick up newer records
+        collect_latest(ring, start, filter, it->positions, max_entries, &it->found, &it->end);
+        skip |= (it->found > max_entries);
+    }
+
+    if (!it->held) {
+        // Empty, or lapped on every attempt (then `end` is still `from`)
+        it->found = 0;
+        if (!empty) {
+            it->begin = atomic_load_explicit(&ring->head, memory_order_acquire);
+        }
+    }
+    if (skipped) *skipped = skip;
+    return true;
+}
+
+bool dlogger_ring_span_begin(dlogger_ring_t *ring, const dlogger_ring_filter_t *filter,
+                             size_t max_entries, dlogger_ring_span_iter_t *it) {
+    return span_begin_at(ring, NULL, filter, max_entries, it, NULL);
+}
+
+bool dlogger_ring_span_begin_since(dlogger_ring_t *ring, uint32_t from,
+                                   const dlogger_ring_filter_t *filter, size_t max_entries,
+                                   dlogger_ring_span_iter_t *it, bool *lost) {
+    bool ok = span_begin_at(ring, &from, filter, max_entries, it, lost);
+    it->oldest_first = true;
+    return ok;
+}
+
+const dlogger_rec_t *dlogger_ring_span_peek(const dlogger_ring_span_iter_t *it) {
+    size_t n = (it->found < it->max) ? it->found : it->max;
+    if (it->next >= n) return NULL;
+    size_t i = it->oldest_first ? it->found - n + it->next : it->found - 1 - it->next;
+    return rec_at(it->ring, it->positions[i % it->max]);
+}
+
+void dlogger_ring_span_end(dlogger_ring_span_iter_t *it) {
+    if (it->held) {
+        ring_release(it->ring);
+        it->held = false;
+    }
+    free(it->positions);
+    it->positions = NULL;
+}
@@ -0,0 +1,394 @@
+#pragma once
+
+/**
+ * @file dlogger_ring.h
+ * @brief Lock-free variable-length record ring (private to dlogger)
+ *
+ * Multi-producer / single-consumer byte arena. Records are packed back to
+ * back (8-byte aligned) instead of occupying fixed 196-byte slots:
+ *
+ *   free            tail                       head
+ *    |  flushed      |  committed / reserved     |  unused  |
+ *    |  (history)    |  (waiting for the flush)  |          |
+ *
+ * - Producers reserve with a CAS on `head` and publish by setting the
+ *   record's bit in `commit_map`; they reclaim the oldest flushed record
+ *   (CAS on `free`) when they need room, so history is kept until the
+ *   space is actually needed.
+ * - The single consumer takes committed records from `tail` one at a time
+ *   (peek/take/consume), so it can merge several rings. Taking moves
+ *   `tail` first and clears the commit bit once the record is processed;
+ *   producers never reclaim a record whose bit is set.
+ * - Under an overflow policy, producers may evict the oldest unflushed
+ *   record the same way (CAS on `tail`), so the consumer's take can fail.
+ * - Readers walk from `free` without locking and validate every copy
+ *   against `head` (a record is intact while head <= pos + size).
+ * - A side array holds one metadata byte per granule (source and level
+ *   bits at each record start, zero elsewhere), so filtered readers scan
+ *   flushed history four granules per word without touching the arena.
+ * - Zero-copy span readers instead set `hold`: producers never reserve
+ *   past it, so records after the hold stay intact until it is released.
+ *
+ * A reservation that would straddle the end of the arena is preceded by a
+ * padding record, so every record is contiguous in memory.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "dlogger.h"
+
+#define DLOGGER_REC_ALIGN   8       ///< Record alignment / commit map granule
+#define DLOGGER_REC_PAD     0xFF    ///< `source` value of padding records
+#define DLOGGER_REC_MAX_LENGTH 0x7FFF  ///< Largest message a record can hold
+
+#define DLOGGER_REC_FLAG_DEFERRED 0x80  ///< `level` flag: payload is a dlogger_fmt capture
+#define DLOGGER_REC_FLAG_TAGGED   0x40  ///< `level` flag: payload is a dlogger_tag id + ESP message body
+#define DLOGGER_REC_FLAG_RENDER   (DLOGGER_REC_FLAG_DEFERRED | DLOGGER_REC_FLAG_TAGGED)  ///< Not plain text
+#define DLOGGER_REC_LEVEL_MASK    0x0F  ///< `level` bits holding the dlogger_level_t
+
+/**
+ * @brief Record header (8 bytes)
+ *
+ * Entry records continue with a 32-bit sequence number and then `length`
+ * message bytes (no NUL); padding records carry no sequence number, so
+ * they fit any 8-byte gap. With DLOGGER_REC_FLAG_DEFERRED set in `level`,
+ * the message bytes are a deferred format capture (see dlogger_fmt.h)
+ * instead of text; with DLOGGER_REC_FLAG_TAGGED they are an interned tag
+ * id followed by the text after the "X (time) TAG: " prefix (see
+ * dlogger_tag.h).
+ */
+typedef struct {
+    uint32_t timestamp;      ///< Milliseconds since boot
+    uint16_t length;         ///< Message length in bytes
+    uint8_t source;          ///< dlogger_source_t, or DLOGGER_REC_PAD
+    uint8_t level;           ///< dlogger_level_t | DLOGGER_REC_FLAG_*
+} dlogger_rec_t;
+
+#define DLOGGER_REC_SEQ_SIZE sizeof(uint32_t)  ///< Sequence number after an entry header
+
+/**
+ * @brief Metadata byte of an entry: one-hot level (bits 0-3) and source
+ *        (bits 4-6 for ESP/LVGL/USER, bit 7 for any other source)
+ */
+static inline uint8_t dlogger_rec_meta(uint8_t source, uint8_t level) {
+    uint8_t src = (source < 3) ? (uint8_t)(0x10u << source) : 0x80u;
+    return (uint8_t)(src | (1u << (level & 3)));
+}
+
+/**
+ * @brief Filter over the metadata side array (see dlogger_ring_filter_init())
+ */
+typedef struct {
+    uint32_t sources;        ///< Accepted source bits, replicated to all 4 bytes
+    uint32_t levels;         ///< Accepted level bits, replicated to all 4 bytes
+    /// Optional extra check on a private copy of a candidate record
+    bool (*match)(const dlogger_rec_t *rec, void *ctx);
+    void *match_ctx;
+} dlogger_ring_filter_t;
+
+/**
+ * @brief Build a metadata filter from DLOGGER_SOURCE_BIT()/DLOGGER_LEVEL_BIT() masks
+ */
+static inline void dlogger_ring_filter_init(dlogger_ring_filter_t *filter,
+                                            uint32_t source_mask, uint32_t level_mask) {
+    uint32_t src = ((source_mask & 0x7u) << 4) | ((source_mask & ~0x7u) ? 0x80u : 0);
+    filter->sources = src * 0x01010101u;
+    filter->levels = (level_mask & 0xFu) * 0x01010101u;
+    filter->match = NULL;
+    filter->match_ctx = NULL;
+}
+
+/**
+ * @brief Ring instance
+ */
+typedef struct {
+    uint8_t *buf;                    ///< Arena (`size` bytes)
+    uint8_t *meta;                   ///< dlogger_rec_meta() per granule at record starts
+    _Atomic uint32_t *commit_map;    ///< One bit per DLOGGER_REC_ALIGN granule
+    uint32_t size;                   ///< Arena size in bytes (power of two)
+    uint32_t mask;                   ///< size - 1
+    _Atomic uint32_t head;           ///< Next byte to reserve (producers)
+    _Atomic uint32_t tail;           ///< Next byte to consume (consumer)
+    _Atomic uint32_t free;           ///< Oldest byte still holding a record
+    _Atomic uint32_t hold;           ///< Oldest record a span reader is using
+    _Atomic bool hold_active;        ///< Whether `hold` limits producers
+    uint32_t peek_pos;               ///< Consumer only: record returned by dlogger_ring_peek()
+} dlogger_ring_t;
+
+/**
+ * @brief An in-flight reservation (returned by reserve, passed to commit)
+ */
+typedef struct {
+    dlogger_rec_t *rec;      ///< Header to fill; message bytes follow it
+    uint32_t pos;            ///< Ring position of `rec`
+    uint32_t start;          ///< Position where the reservation began (incl. padding)
+    uint32_t end;            ///< Position one past the record
+} dlogger_ring_resv_t;
+
+/**
+ * @brief Allocate a ring of `size` bytes (power of two), preferring PSRAM
+ */
+esp_err_t dlogger_ring_init(dlogger_ring_t *ring, uint32_t size);
+
+/**
+ * @brief Free the ring's memory
+ */
+void dlogger_ring_deinit(dlogger_ring_t *ring);
+
+/**
+ * @brief Sequence number of an entry record (not valid for padding)
+ */
+static inline uint32_t dlogger_rec_seq(const dlogger_rec_t *rec) {
+    return *(const uint32_t *)(rec + 1);
+}
+
+/**
+ * @brief Whether entry (ts_a, seq_a) comes after entry (ts_b, seq_b)
+ *
+ * Rings are merged by timestamp; entries of the same millisecond in
+ * different rings keep their commit order.
+ */
+static inline bool dlogger_entry_after(uint32_t ts_a, uint32_t seq_a, uint32_t ts_b, uint32_t seq_b) {
+    int32_t dt = (int32_t)(ts_a - ts_b);
+    return dt > 0 || (dt == 0 && (int32_t)(seq_a - seq_b) > 0);
+}
+
+/**
+ * @brief Set the sequence number of a reserved entry record before commit
+ */
+static inline void dlogger_rec_set_seq(dlogger_rec_t *rec, uint32_t seq) {
+    *(uint32_t *)(rec + 1) = seq;
+}
+
+/**
+ * @brief Message bytes of an entry record
+ */
+static inline char *dlogger_rec_message(const dlogger_rec_t *rec) {
+    return (char *)(rec + 1) + DLOGGER_REC_SEQ_SIZE;
+}
+
+/**
+ * @brief Render a message payload as NUL-terminated text
+ *
+ * Copies text, formats deferred captures and rebuilds the prefix of
+ * tagged ESP lines. `hdr` describes the payload (length, flags, and the
+ * timestamp and level a prefix shows); `payload` need not follow it.
+ *
+ * @return Characters written (excluding the NUL)
+ */
+size_t dlogger_payload_render(const dlogger_rec_t *hdr, const void *payload,
+                              char *out, size_t out_len);
+
+/**
+ * @brief Render a record's message as NUL-terminated text
+ *
+ * `rec` must not change while this runs (peeked by the consumer, or a
+ * private copy).
+ *
+ * @return Characters written (excluding the NUL)
+ */
+static inline size_t dlogger_rec_render(const dlogger_rec_t *rec, char *out, size_t out_len) {
+    return dlogger_payload_render(rec, dlogger_rec_message(rec), out, out_len);
+}
+
+/**
+ * @brief Reserve room for a record with `msg_len` message bytes
+ *
+ * Lock-free; reclaims flushed history if needed. Never blocks.
+ *
+ * @return false if unflushed records fill the ring (entry must be dropped)
+ */
+bool dlogger_ring_reserve(dlogger_ring_t *ring, size_t msg_len, dlogger_ring_resv_t *resv);
+
+/**
+ * @brief Publish a filled reservation to the consumer and readers
+ *
+ * `resv->rec->length` may have been lowered below the reserved length;
+ * the unused tail of the reservation is turned into padding.
+ *
+ * @return Unflushed bytes in the ring after this commit
+ */
+uint32_t dlogger_ring_commit(dlogger_ring_t *ring, const dlogger_ring_resv_t *resv);
+
+/**
+ * @brief Next committed record for the consumer (padding is skipped)
+ *
+ * Until dlogger_ring_take() succeeds the record may be evicted, so only
+ * use it to decide which ring to take from.
+ *
+ * @return NULL if the ring is empty or the next record is not committed
+ */
+const dlogger_rec_t *dlogger_ring_peek(dlogger_ring_t *ring);
+
+/**
+ * @brief Ring position of the record returned by dlogger_ring_peek()
+ */
+static inline uint32_t dlogger_ring_peek_pos(dlogger_ring_t *ring) {
+    return ring->peek_pos;
+}
+
+/**
+ * @brief Claim the record returned by dlogger_ring_peek()
+ *
+ * On success the record stays intact until dlogger_ring_consume().
+ *
+ * @return false if a producer evicted it meanwhile (peek again)
+ */
+bool dlogger_ring_take(dlogger_ring_t *ring);
+
+/**
+ * @brief Release the record claimed by dlogger_ring_take() once processed
+ */
+void dlogger_ring_consume(dlogger_ring_t *ring);
+
+/**
+ * @brief Evict the oldest unflushed record if its level is in `level_mask`
+ *
+ * Producer side of the drop-oldest and level-priority overflow policies:
+ * the record is skipped by the consumer and its space can be reclaimed.
+ *
+ * @param level_mask Bit per dlogger_level_t that may be evicted
+ * @return 1 if an entry was evicted, 0 if evicting cannot make room
+ *         (oldest record uncommitted or of a protected level, empty ring,
+ *         or flushed history not reclaimable yet), -1 if
+ *         a race was lost or padding was skipped (try again)
+ */
+int dlogger_ring_evict(dlogger_ring_t *ring, uint32_t level_mask);
+
+/**
+ * @brief Position of the oldest record not taken by the consumer (or evicted)
+ */
+static inline uint32_t dlogger_ring_tail(dlogger_ring_t *ring) {
+    return atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+/**
+ * @brief Bytes reserved but not yet consumed
+ */
+static inline uint32_t dlogger_ring_pending(dlogger_ring_t *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+/**
+ * @brief Copying iterator over the newest records (see dlogger_ring_read_begin())
+ */
+typedef struct {
+    dlogger_ring_t *ring;
+    uint32_t *positions;     ///< Ring of the newest `max` record positions
+    size_t max;
+    size_t found;            ///< Records seen by the walk (may exceed `max`)
+    size_t next;             ///< Records already returned or skipped
+    uint32_t begin;          ///< Position the walk started from (older records were reclaimed)
+    dlogger_rec_t hdr;       ///< Header of the current record, once peeked
+    uint32_t seq;
+    bool peeked;             ///< Whether `hdr` / `seq` hold the current record
+} dlogger_ring_read_iter_t;
+
+/**
+ * @brief Start visiting the newest records (flushed or not), newest first
+ *
+ * Lock-free, unlike dlogger_ring_span_begin(): producers are never held
+ * up, and records they overwrite during the visit are skipped. Only the
+ * record positions are kept (4 bytes per entry); each record is copied
+ * when it is taken.
+ *
+ * @return false if the position table cannot be allocated (`it->begin`
+ *         is still set, to the head)
+ */
+bool dlogger_ring_read_begin(dlogger_ring_t *ring, size_t max_entries,
+                             dlogger_ring_read_iter_t *it);
+
+/**
+ * @brief Timestamp and sequence number of the current record
+ *
+ * @return false when the iterator is exhausted
+ */
+bool dlogger_ring_read_peek(dlogger_ring_read_iter_t *it, uint32_t *timestamp, uint32_t *seq);
+
+/**
+ * @brief Decode the current record into `dest` and advance
+ *
+ * @return false if the record was overwritten since it was peeked
+ *         (nothing is written; the iterator moves on)
+ */
+bool dlogger_ring_read_take(dlogger_ring_read_iter_t *it, dlogger_entry_t *dest);
+
+/**
+ * @brief Free the iterator
+ */
+void dlogger_ring_read_end(dlogger_ring_read_iter_t *it);
+
+/**
+ * @brief Zero-copy iterator over the newest records (see dlogger_ring_span_begin())
+ */
+typedef struct {
+    dlogger_ring_t *ring;
+    uint32_t *positions;     ///< Ring of the newest `max` record positions
+    size_t max;
+    size_t found;            ///< Records seen by the walk (may exceed `max`)
+    size_t next;             ///< Records already returned
+    uint32_t begin;          ///< Position the walk started from (older records were reclaimed)
+    uint32_t end;            ///< Position after the last record walked
+    bool oldest_first;       ///< Return order (dlogger_ring_span_begin_since())
+    bool held;               ///< Whether the ring's hold is set
+} dlogger_ring_span_iter_t;
+
+/**
+ * @brief Start visiting the newest records in place, newest first
+ *
+ * Producers cannot reclaim the visited records until
+ * dlogger_ring_span_end(), so they may drop entries if the ring fills
+ * meanwhile; only one iterator per ring may be open at a time.
+ *
+ * @param filter Only records passing it are visited and counted (NULL = all)
+ * @return false if the position table cannot be allocated
+ */
+bool dlogger_ring_span_begin(dlogger_ring_t *ring, const dlogger_ring_filter_t *filter,
+                             size_t max_entries, dlogger_ring_span_iter_t *it);
+
+/**
+ * @brief Start visiting the records from position `from` on, oldest first
+ *
+ * Like dlogger_ring_span_begin(), but the walk starts at `from` (or at the
+ * oldest record still in the ring if `from` was reclaimed or is not a
+ * position of this ring) and the kept newest `max_entries` records are
+ * returned in ring order. `it->end` is where the next call should start.
+ *
+ * @param filter Only records passing it are visited and counted (NULL = all)
+ * @param lost Set to true if records between `from` and the first one
+ *             returned were reclaimed or skipped for `max_entries`
+ * @return false if the position table cannot be allocated
+ */
+bool dlogger_ring_span_begin_since(dlogger_ring_t *ring, uint32_t from,
+                                   const dlogger_ring_filter_t *filter, size_t max_entries,
+                                   dlogger_ring_span_iter_t *it, bool *lost);
+
+/**
+ * @brief Current record of the iterator (NULL when exhausted)
+ */
+const dlogger_rec_t *dlogger_ring_span_peek(const dlogger_ring_span_iter_t *it);
+
+/**
+ * @brief Advance the iterator
+ */
+static inline void dlogger_ring_span_next(dlogger_ring_span_iter_t *it) {
+    it->next++;
+}
+
+/**
+ * @brief Position to pass as `from` to resume after the records returned so far
+ */
+static inline uint32_t dlogger_ring_span_resume(const dlogger_ring_span_iter_t *it) {
+    size_t n = (it->found < it->max) ? it->found : it->max;
+    if (!it->oldest_first || it->next >= n) return it->end;
+    return it->positions[(it->found - n + it->next) % it->max];
+}
+
+/**
+ * @brief Release the hold and free the iterator
+ */
+void dlogger_ring_span_end(dlogger_ring_span_iter_t *it);
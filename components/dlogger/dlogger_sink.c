@@ -0,0 +1,436 @@
+#include "dlogger_sink.h"
+#include "dlogger_port.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define SINK_STREAM_LINE_MAX  (sizeof(((dlogger_entry_t *)0)->message) + 32)  ///< Rendered line incl. prefix and newline
+
+/**
+ * @brief Registered sink (owned by its task while running)
+ */
+struct dlogger_sink {
+    dlogger_sink_config_t config;
+    void *owned_ctx;                  ///< Freed with the sink (ready-made sinks)
+    TaskHandle_t task;
+    _Atomic bool running;             ///< Cleared by dlogger_sink_remove()
+    _Atomic bool exited;              ///< Set by the task as it ends
+    dlogger_cache_cursor_t cursor;
+    dlogger_entry_t *batch;           ///< config.batch_max entries
+    size_t count;                     ///< Entries waiting in `batch`
+    _Atomic uint32_t delivered;
+    _Atomic uint32_t lost;
+    _Atomic uint32_t refused;
+    _Atomic uint32_t batches;
+};
+
+/**
+ * @brief Stream sink state (see dlogger_sink_add_stream())
+ */
+typedef struct {
+    int fd;
+    size_t length;           ///< Rendered bytes in `text`
+    size_t sent;             ///< Bytes of `text` already written
+    char text[];             ///< batch_max lines
+} sink_stream_t;
+
+/**
+ * @brief Memory sink state (see dlogger_sink_add_memory())
+ *
+ * Written by the sink task only; readers copy the newest slots and then
+ * drop the ones the task may have rewritten meanwhile.
+ */
+typedef struct {
+    size_t slots;            ///< Capacity + 1: the slot being written is never read
+    _Atomic uint32_t written;   ///< Entries stored so far (free-running)
+    dlogger_entry_t entries[];
+} sink_memory_t;
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+static dlogger_cache_t *sink_cache;
+static SemaphoreHandle_t sink_mutex;     ///< Guards the slots, never held across a write
+#if DLOGGER_SINK_SLOTS
+static dlogger_sink_handle_t sink_slots[DLOGGER_SINK_SLOTS];
+#endif
+
+// ============================================================================
+// SINK TASK
+// ============================================================================
+
+/**
+ * @brief Top up the batch from the cache, skipping filtered entries
+ */
+static void sink_fill(dlogger_sink_handle_t sink) {
+    dlogger_cache_rec_t rec;
+    while (sink->count < sink->config.batch_max) {
+        dlogger_entry_t *entry = &sink->batch[sink->count];
+        uint32_t lost = 0;
+        bool read = dlogger_cache_read_next(sink_cache, &sink->cursor, &rec, entry->message,
+                                            sizeof(entry->message), &lost) != NULL;
+        if (lost) {
+            atomic_fetch_add_explicit(&sink->lost, lost, memory_order_relaxed);
+        }
+        if (!read) break;
+        if (!(sink->config.source_mask & DLOGGER_SOURCE_BIT(rec.source)) ||
+            !(sink->config.level_mask & DLOGGER_LEVEL_BIT(rec.level))) {
+            continue;
+        }
+        entry->timestamp = rec.timestamp;
+        entry->source = rec.source;
+        entry->level = rec.level;
+        sink->count++;
+    }
+}
+
+/**
+ * @brief Hand the batch to the sink and apply its policy if refused
+ *
+ * @return false if the write was refused
+ */
+static bool sink_deliver(dlogger_sink_handle_t sink) {
+    if (sink->config.write(sink->batch, sink->count, sink->config.user_ctx) == ESP_OK) {
+        atomic_fetch_add_explicit(&sink->delivered, sink->count, memory_order_relaxed);
+        atomic_fetch_add_explicit(&sink->batches, 1, memory_order_relaxed);
+        sink->count = 0;
+        return true;
+    }
+
+    atomic_fetch_add_explicit(&sink->refused, 1, memory_order_relaxed);
+    if (sink->config.policy == DLOGGER_SINK_DROP) {
+        atomic_fetch_add_explicit(&sink->lost, sink->count, memory_order_relaxed);
+        sink->count = 0;
+    }
+    return false;
+}
+
+/**
+ * @brief Sink task: batches cache entries and delivers them at its own pace
+ *
+ * Sleeps while there is nothing to read and is woken by the flush task
+ * after each drain. A batch goes out when it is full or its oldest entry
+ * has waited batch_ms; after a refused write the task pauses retry_ms.
+ */
+static void sink_task_func(void *arg) {
+    dlogger_sink_handle_t sink = (dlogger_sink_handle_t)arg;
+    TickType_t batch_start = 0;
+
+    while (atomic_load(&sink->running)) {
+        bool started = sink->count > 0;
+        sink_fill(sink);
+        if (sink->count == 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        if (!started) {
+            batch_start = xTaskGetTickCount();
+        }
+
+        TickType_t waited = xTaskGetTickCount() - batch_start;
+        TickType_t batch_ticks = pdMS_TO_TICKS(sink->config.batch_ms);
+        if (sink->count < sink->config.batch_max && waited < batch_ticks) {
+            ulTaskNotifyTake(pdTRUE, batch_ticks - waited);
+            continue;
+        }
+
+        if (!sink_deliver(sink)) {
+            vTaskDelay(pdMS_TO_TICKS(sink->config.retry_ms) + 1);
+        }
+    }
+
+    // Last pass: deliver what reached the cache before the stop, once
+    do {
+        sink_fill(sink);
+    } while (sink->count > 0 && sink_deliver(sink));
+
+    atomic_store(&sink->exited, true);
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// REGISTRY
+// ============================================================================
+
+/**
+ * @brief Register a sink and start its task
+ *
+ * @param owned_ctx Freed with the sink (may be NULL)
+ */
+static esp_err_t sink_create(const dlogger_sink_config_t *config, void *owned_ctx,
+                             dlogger_sink_handle_t *out) {
+#if DLOGGER_SINK_SLOTS
+    if (!config || !config->write || config->batch_max == 0 || !out) return ESP_ERR_INVALID_ARG;
+    if (!sink_mutex) return ESP_ERR_INVALID_STATE;
+    if (!sink_cache->count) return ESP_ERR_NOT_SUPPORTED;   // Sinks read the cache
+
+    dlogger_sink_handle_t sink = (dlogger_sink_handle_t)calloc(1, sizeof(*sink));
+    if (!sink) return ESP_ERR_NO_MEM;
+    sink->batch = (dlogger_entry_t *)dlogger_port_alloc_psram(config->batch_max *
+                                                              sizeof(dlogger_entry_t));
+    if (!sink->batch) {
+        sink->batch = (dlogger_entry_t *)malloc(config->batch_max * sizeof(dlogger_entry_t));
+    }
+    if (!sink->batch) {
+        free(sink);
+        return ESP_ERR_NO_MEM;
+    }
+    sink->config = *config;
+    sink->owned_ctx = owned_ctx;
+    atomic_store(&sink->running, true);
+    dlogger_cache_cursor_init(sink_cache, &sink->cursor);   // Entries from now on
+
+    xSemaphoreTake(sink_mutex, portMAX_DELAY);
+    int slot = -1;
+    for (int i = 0; i < DLOGGER_SINK_SLOTS; i++) {
+        if (!sink_slots[i]) {
+            slot = i;
+            break;
+        }
+    }
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (slot >= 0 &&
+        xTaskCreatePinnedToCore(sink_task_func, config->name ? config->name : "dlogger_sink",
+                                config->stack_size, sink, config->priority, &sink->task,
+                                DLOGGER_PORT_FLUSH_CORE) == pdPASS) {
+        sink_slots[slot] = sink;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(sink_mutex);
+
+    if (ret != ESP_OK) {
+        free(sink->batch);
+        free(sink);
+        return ret;
+    }
+    *out = sink;
+    return ESP_OK;
+#else
+    (void)config; (void)owned_ctx; (void)out;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t dlogger_sink_init(dlogger_cache_t *cache) {
+    sink_cache = cache;
+    if (!sink_mutex) {
+        sink_mutex = xSemaphoreCreateMutex();
+    }
+    return sink_mutex ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void dlogger_sink_notify(void) {
+#if DLOGGER_SINK_SLOTS
+    if (!sink_mutex) return;
+    xSemaphoreTake(sink_mutex, portMAX_DELAY);
+    for (int i = 0; i < DLOGGER_SINK_SLOTS; i++) {
+        if (sink_slots[i]) {
+            xTaskNotifyGive(sink_slots[i]->task);
+        }
+    }
+    xSemaphoreGive(sink_mutex);
+#endif
+}
+
+void dlogger_sink_deinit(void) {
+#if DLOGGER_SINK_SLOTS
+    if (!sink_mutex) return;
+    for (int i = 0; i < DLOGGER_SINK_SLOTS; i++) {
+        if (sink_slots[i]) {
+            dlogger_sink_remove(sink_slots[i]);
+        }
+    }
+#endif
+    if (sink_mutex) {
+        vSemaphoreDelete(sink_mutex);
+        sink_mutex = NULL;
+    }
+    sink_cache = NULL;
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+esp_err_t dlogger_sink_add(const dlogger_sink_config_t *config, dlogger_sink_handle_t *out) {
+    return sink_create(config, NULL, out);
+}
+
+esp_err_t dlogger_sink_remove(dlogger_sink_handle_t sink) {
+#if DLOGGER_SINK_SLOTS
+    if (!sink) return ESP_ERR_INVALID_ARG;
+    if (!sink_mutex) return ESP_ERR_INVALID_STATE;
+
+    // Out of the registry first: the flush task stops waking it
+    bool found = false;
+    xSemaphoreTake(sink_mutex, portMAX_DELAY);
+    for (int i = 0; i < DLOGGER_SINK_SLOTS; i++) {
+        if (sink_slots[i] == sink) {
+            sink_slots[i] = NULL;
+            found = true;
+        }
+    }
+    xSemaphoreGive(sink_mutex);
+    if (!found) return ESP_ERR_NOT_FOUND;
+
+    atomic_store(&sink->running, false);
+    xTaskNotifyGive(sink->task);
+    while (!atomic_load(&sink->exited)) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    free(sink->owned_ctx);
+    free(sink->batch);
+    free(sink);
+    return ESP_OK;
+#else
+    (void)sink;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t dlogger_sink_get_stats(dlogger_sink_handle_t sink, dlogger_sink_stats_t *stats) {
+    if (!sink || !stats) return ESP_ERR_INVALID_ARG;
+    stats->delivered = atomic_load_explicit(&sink->delivered, memory_order_relaxed);
+    stats->lost = atomic_load_explicit(&sink->lost, memory_order_relaxed);
+    stats->refused = atomic_load_explicit(&sink->refused, memory_order_relaxed);
+    stats->batches = atomic_load_explicit(&sink->batches, memory_order_relaxed);
+    return ESP_OK;
+}
+
+// ============================================================================
+// STREAM SINK
+// ============================================================================
+
+/**
+ * @brief Write as much of the pending text as the descriptor takes
+ *
+ * @return ESP_OK if everything went out, ESP_ERR_TIMEOUT if the descriptor
+ *         is full, ESP_FAIL on an error (the pending text is discarded)
+ */
+static esp_err_t stream_send(sink_stream_t *stream) {
+    while (stream->sent < stream->length) {
+        ssize_t n = write(stream->fd, stream->text + stream->sent, stream->length - stream->sent);
+        if (n > 0) {
+            stream->sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return ESP_ERR_TIMEOUT;
+        } else {
+            stream->sent = stream->length;
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Stream sink write: one text line per entry
+ *
+ * A batch is refused only while the previous one is still unsent, so no
+ * line is ever written twice; a batch the descriptor takes in part is
+ * finished before the next one.
+ */
+static esp_err_t stream_write(const dlogger_entry_t *entries, size_t count, void *user_ctx) {
+    sink_stream_t *stream = (sink_stream_t *)user_ctx;
+    esp_err_t ret = stream_send(stream);
+    if (ret != ESP_OK) return ret;
+
+    stream->length = 0;
+    stream->sent = 0;
+    for (size_t i = 0; i < count; i++) {
+        int n = dlogger_entry_to_text(&entries[i], stream->text + stream->length,
+                                      SINK_STREAM_LINE_MAX - 1);
+        if (n < 0) continue;
+        if (n > (int)SINK_STREAM_LINE_MAX - 2) n = SINK_STREAM_LINE_MAX - 2;
+        stream->length += (size_t)n;
+        stream->text[stream->length++] = '\n';
+    }
+    ret = stream_send(stream);
+    return (ret == ESP_ERR_TIMEOUT) ? ESP_OK : ret;
+}
+
+esp_err_t dlogger_sink_add_stream(int fd, const char *name, dlogger_sink_handle_t *out) {
+    if (fd < 0 || !out) return ESP_ERR_INVALID_ARG;
+
+    dlogger_sink_config_t config = DLOGGER_SINK_CONFIG_DEFAULT(stream_write, NULL);
+    config.name = name ? name : "dlogger_stream";
+    config.policy = DLOGGER_SINK_DROP;   // Live view: newest lines matter most
+
+    sink_stream_t *stream = (sink_stream_t *)calloc(1, sizeof(sink_stream_t) +
+                                                    config.batch_max * SINK_STREAM_LINE_MAX);
+    if (!stream) return ESP_ERR_NO_MEM;
+    stream->fd = fd;
+    config.user_ctx = stream;
+
+    esp_err_t ret = sink_create(&config, stream, out);
+    if (ret != ESP_OK) {
+        free(stream);
+    }
+    return ret;
+}
+
+// ============================================================================
+// MEMORY SINK
+// ============================================================================
+
+/**
+ * @brief Memory sink write: keep the entries, overwriting the oldest
+ */
+static esp_err_t memory_write(const dlogger_entry_t *entries, size_t count, void *user_ctx) {
+    sink_memory_t *memory = (sink_memory_t *)user_ctx;
+    uint32_t written = atomic_load_explicit(&memory->written, memory_order_relaxed);
+    for (size_t i = 0; i < count; i++, written++) {
+        memory->entries[written % memory->slots] = entries[i];
+        atomic_store_explicit(&memory->written, written + 1, memory_order_release);
+    }
+    return ESP_OK;
+}
+
+esp_err_t dlogger_sink_add_memory(size_t capacity, const char *name, dlogger_sink_handle_t *out) {
+    if (capacity == 0 || !out) return ESP_ERR_INVALID_ARG;
+
+    dlogger_sink_config_t config = DLOGGER_SINK_CONFIG_DEFAULT(memory_write, NULL);
+    config.name = name ? name : "dlogger_memory";
+    config.batch_ms = 10;                // Cheap writes: keep the view current
+
+    sink_memory_t *memory = (sink_memory_t *)calloc(1, sizeof(sink_memory_t) +
+                                                    (capacity + 1) * sizeof(dlogger_entry_t));
+    if (!memory) return ESP_ERR_NO_MEM;
+    memory->slots = capacity + 1;
+    config.user_ctx = memory;
+
+    esp_err_t ret = sink_create(&config, memory, out);
+    if (ret != ESP_OK) {
+        free(memory);
+    }
+    return ret;
+}
+
+size_t dlogger_sink_memory_read(dlogger_sink_handle_t sink, dlogger_entry_t *dest,
+                                size_t max_entries) {
+    if (!sink || !dest || sink->config.write != memory_write) return 0;
+    sink_memory_t *memory = (sink_memory_t *)sink->config.user_ctx;
+
+    uint32_t end = atomic_load_explicit(&memory->written, memory_order_acquire);
+    size_t count = (end < memory->slots - 1) ? end : memory->slots - 1;
+    if (count > max_entries) count = max_entries;
+    for (size_t i = 0; i < count; i++) {
+        dest[i] = memory->entries[(end - 1 - i) % memory->slots];
+    }
+
+    // Entry `end - 1 - i` survived the copy unless the task has since
+    // stored so many that it reached (or is writing) its slot
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t overrun = atomic_load_explicit(&memory->written, memory_order_relaxed) - end;
+    size_t intact = (overrun < memory->slots - 1) ? memory->slots - 1 - overrun : 0;
+    return (count < intact) ? count : intact;
+}
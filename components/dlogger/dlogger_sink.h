@@ -0,0 +1,41 @@
+#pragma once
+
+/**
+ * @file dlogger_sink.h
+ * @brief Registry of extra log sinks fed from the entry cache (private to dlogger)
+ *
+ * The flush task stays the only consumer of the rings: it writes the
+ * segment files and appends every entry, rendered, to the RAM cache. Each
+ * registered sink (dlogger_sink_add()) follows the cache through its own
+ * cursor from its own task, batches entries at its own pace and applies
+ * its own policy when its write is refused.
+ *
+ * - Nothing on the producer or flush path waits for a sink: the flush task
+ *   only wakes the sink tasks after a drain.
+ * - A stalled sink falls behind in the cache; once the cache recycles the
+ *   entries it has not read, it skips them and counts them as lost. Other
+ *   sinks and the file never notice.
+ */
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "dlogger.h"
+#include "dlogger_cache.h"
+#include "sdkconfig.h"
+
+#define DLOGGER_SINK_SLOTS  CONFIG_DLOGGER_SINK_SLOTS   ///< Registered sinks at most, 0 = off
+
+/**
+ * @brief Create the registry; sinks will read `cache`
+ */
+esp_err_t dlogger_sink_init(dlogger_cache_t *cache);
+
+/**
+ * @brief Wake every sink task: new entries reached the cache (flush task)
+ */
+void dlogger_sink_notify(void);
+
+/**
+ * @brief Let every sink deliver what reached the cache, then remove it
+ */
+void dlogger_sink_deinit(void);
@@ -0,0 +1,267 @@
+#include "dlogger_storm.h"
+#include "dlogger_port.h"
+#include <string.h>
+
+#define STORM_PROBES         4                                   // Slots tried per key
+#define STORM_TOKEN          1000                                // Fixed-point unit of one token
+#define STORM_BURST          (CONFIG_DLOGGER_STORM_BURST * STORM_TOKEN)
+#define STORM_RATE           CONFIG_DLOGGER_STORM_RATE           // Tokens per second = milli-tokens per ms
+#define STORM_WINDOW_MS      CONFIG_DLOGGER_STORM_WINDOW_MS
+
+/**
+ * @brief One tracked key
+ */
+typedef struct {
+    _Atomic uint32_t busy;       ///< Try-lock
+    _Atomic uint32_t key;        ///< dlogger_storm_key(), 0 = free (probed without the lock)
+    uint32_t last_ms;            ///< Last copy (bucket refill, replacement)
+    uint32_t tokens;             ///< Milli-tokens available
+    uint32_t window_ms;          ///< First suppressed copy of the open window
+    uint32_t suppressed;         ///< Copies suppressed in the open window
+    uint8_t source;
+    uint8_t level;
+    uint16_t length;             ///< Bytes in `text`, 0 until provided
+    char text[DLOGGER_STORM_TEXT_MAX];
+} storm_slot_t;
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+#if DLOGGER_STORM_SLOTS
+_Static_assert((DLOGGER_STORM_SLOTS & (DLOGGER_STORM_SLOTS - 1)) == 0,
+               "CONFIG_DLOGGER_STORM_SLOTS must be a power of two");
+
+static storm_slot_t storm_slots[DLOGGER_STORM_SLOTS];
+#endif
+static _Atomic uint32_t storm_suppressed;
+static _Atomic uint32_t storm_summaries;
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+#if DLOGGER_STORM_SLOTS
+
+/**
+ * @brief Try to own a slot; interrupts stay masked while it is owned
+ */
+static inline bool slot_lock(storm_slot_t *slot, uint32_t *irq_state) {
+    *irq_state = dlogger_port_irq_mask();
+    if (atomic_exchange_explicit(&slot->busy, 1, memory_order_acquire)) {
+        dlogger_port_irq_restore(*irq_state);
+        return false;
+    }
+    return true;
+}
+
+static inline void slot_unlock(storm_slot_t *slot, uint32_t irq_state) {
+    atomic_store_explicit(&slot->busy, 0, memory_order_release);
+    dlogger_port_irq_restore(irq_state);
+}
+
+/**
+ * @brief Move the slot's open window into `summary` and close it
+ */
+static void slot_take_summary(storm_slot_t *slot, dlogger_storm_summary_t *summary) {
+    summary->count = slot->suppressed;
+    summary->source = slot->source;
+    summary->level = slot->level;
+    summary->length = slot->length;
+    memcpy(summary->text, slot->text, slot->length);
+    slot->suppressed = 0;
+    atomic_fetch_add_explicit(&storm_summaries, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Start tracking `key` in a free or replaced slot
+ */
+static void slot_claim(storm_slot_t *slot, uint32_t key, uint8_t source, uint8_t level,
+                       uint32_t now) {
+    atomic_store_explicit(&slot->key, key, memory_order_relaxed);
+    slot->last_ms = now;
+    slot->tokens = STORM_BURST;
+    slot->suppressed = 0;
+    slot->source = source;
+    slot->level = level;
+    slot->length = 0;
+}
+
+#endif
+
+// ============================================================================
+// PRODUCER SIDE
+// ============================================================================
+
+uint32_t dlogger_storm_hash(uint32_t key, const void *data, size_t len) {
+    // FNV-1a
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        key = (key ^ p[i]) * 16777619u;
+    }
+    return key ? key : 1;
+}
+
+dlogger_storm_verdict_t dlogger_storm_check(uint32_t key, uint8_t source, uint8_t level,
+                                            uint32_t now, dlogger_storm_summary_t *summary) {
+    summary->count = 0;
+#if DLOGGER_STORM_SLOTS
+    // Find the key among its probe slots, else take a free slot or the
+    // least recently used one
+    storm_slot_t *slot = NULL;
+    storm_slot_t *victim = NULL;
+    uint32_t victim_key = 0;
+    uint32_t irq_state = 0;
+    for (uint32_t i = 0; i < STORM_PROBES; i++) {
+        storm_slot_t *s = &storm_slots[(key + i) & (DLOGGER_STORM_SLOTS - 1)];
+        uint32_t k = atomic_load_explicit(&s->key, memory_order_relaxed);
+        if (k == key) {
+            slot = s;
+            break;
+        }
+        if (!victim || (victim_key != 0 &&
+                        (k == 0 || (int32_t)(s->last_ms - victim->last_ms) < 0))) {
+            victim = s;
+            victim_key = k;
+        }
+    }
+
+    if (!slot) {
+        if (!slot_lock(victim, &irq_state)) return DLOGGER_STORM_PASS;
+        if (victim->suppressed) {
+            slot_take_summary(victim, summary);
+        }
+        slot_claim(victim, key, source, level, now);
+        victim->tokens -= STORM_TOKEN;
+        slot_unlock(victim, irq_state);
+        return DLOGGER_STORM_PASS;
+    }
+
+    if (!slot_lock(slot, &irq_state)) return DLOGGER_STORM_PASS;
+    if (atomic_load_explicit(&slot->key, memory_order_relaxed) != key) {
+        // Replaced between the probe and the lock
+        slot_unlock(slot, irq_state);
+        return DLOGGER_STORM_PASS;
+    }
+
+    // Refill the bucket for the time since the last copy
+    uint32_t elapsed = now - slot->last_ms;
+    uint32_t refill = (elapsed < STORM_BURST) ? elapsed * STORM_RATE : STORM_BURST;
+    slot->tokens = (slot->tokens + refill < STORM_BURST) ? slot->tokens + refill : STORM_BURST;
+    slot->last_ms = now;
+
+    if (slot->suppressed && now - slot->window_ms >= STORM_WINDOW_MS) {
+        slot_take_summary(slot, summary);
+    }
+
+    dlogger_storm_verdict_t verdict;
+    if (slot->tokens >= STORM_TOKEN) {
+        slot->tokens -= STORM_TOKEN;
+        verdict = DLOGGER_STORM_PASS;
+    } else {
+        if (slot->suppressed++ == 0) {
+            slot->window_ms = now;
+        }
+        verdict = slot->length ? DLOGGER_STORM_SUPPRESS : DLOGGER_STORM_SUPPRESS_TEXT;
+        atomic_fetch_add_explicit(&storm_suppressed, 1, memory_order_relaxed);
+    }
+    slot_unlock(slot, irq_state);
+    return verdict;
+#else
+    (void)key; (void)source; (void)level; (void)now;
+    return DLOGGER_STORM_PASS;
+#endif
+}
+
+void dlogger_storm_refund(uint32_t key) {
+#if DLOGGER_STORM_SLOTS
+    for (uint32_t i = 0; i < STORM_PROBES; i++) {
+        storm_slot_t *slot = &storm_slots[(key + i) & (DLOGGER_STORM_SLOTS - 1)];
+        if (atomic_load_explicit(&slot->key, memory_order_relaxed) != key) continue;
+
+        uint32_t irq_state;
+        if (!slot_lock(slot, &irq_state)) return;
+        if (atomic_load_explicit(&slot->key, memory_order_relaxed) == key) {
+            slot->tokens = (slot->tokens + STORM_TOKEN < STORM_BURST) ? slot->tokens + STORM_TOKEN
+                                                                      : STORM_BURST;
+        }
+        slot_unlock(slot, irq_state);
+        return;
+    }
+#else
+    (void)key;
+#endif
+}
+
+void dlogger_storm_set_text(uint32_t key, const char *text, size_t len) {
+#if DLOGGER_STORM_SLOTS
+    if (len > DLOGGER_STORM_TEXT_MAX) len = DLOGGER_STORM_TEXT_MAX;
+    for (uint32_t i = 0; i < STORM_PROBES; i++) {
+        storm_slot_t *slot = &storm_slots[(key + i) & (DLOGGER_STORM_SLOTS - 1)];
+        if (atomic_load_explicit(&slot->key, memory_order_relaxed) != key) continue;
+
+        uint32_t irq_state;
+        if (!slot_lock(slot, &irq_state)) return;   // Next suppressed copy provides it
+        if (atomic_load_explicit(&slot->key, memory_order_relaxed) == key && slot->length == 0) {
+            memcpy(slot->text, text, len);
+            slot->length = (uint16_t)len;
+        }
+        slot_unlock(slot, irq_state);
+        return;
+    }
+#else
+    (void)key; (void)text; (void)len;
+#endif
+}
+
+// ============================================================================
+// FLUSH TASK SIDE
+// ============================================================================
+
+uint32_t dlogger_storm_sweep(uint32_t now, bool all, dlogger_storm_summary_cb_t callback,
+                             void *user_ctx) {
+    uint32_t next = UINT32_MAX;
+#if DLOGGER_STORM_SLOTS
+    for (uint32_t i = 0; i < DLOGGER_STORM_SLOTS; i++) {
+        storm_slot_t *slot = &storm_slots[i];
+        if (atomic_load_explicit(&slot->key, memory_order_relaxed) == 0) continue;
+
+        uint32_t irq_state;
+        if (!slot_lock(slot, &irq_state)) {
+            next = 0;   // Retry on the next pass
+            continue;
+        }
+        dlogger_storm_summary_t summary = { .count = 0 };
+        if (slot->suppressed) {
+            uint32_t age = now - slot->window_ms;
+            if (all || age >= STORM_WINDOW_MS) {
+                slot_take_summary(slot, &summary);
+            } else if (STORM_WINDOW_MS - age < next) {
+                next = STORM_WINDOW_MS - age;
+            }
+        }
+        slot_unlock(slot, irq_state);
+
+        if (summary.count) {
+            callback(&summary, user_ctx);
+        }
+    }
+#else
+    (void)now; (void)all; (void)callback; (void)user_ctx;
+#endif
+    return next;
+}
+
+void dlogger_storm_reset(void) {
+#if DLOGGER_STORM_SLOTS
+    memset(storm_slots, 0, sizeof(storm_slots));
+#endif
+}
+
+uint32_t dlogger_storm_suppressed(void) {
+    return atomic_load_explicit(&storm_suppressed, memory_order_relaxed);
+}
+
+uint32_t dlogger_storm_summaries(void) {
+    return atomic_load_explicit(&storm_summaries, memory_order_relaxed);
+}
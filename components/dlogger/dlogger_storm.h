@@ -0,0 +1,114 @@
+#pragma once
+
+/**
+ * @file dlogger_storm.h
+ * @brief Repeated-message storm suppression (private to dlogger)
+ *
+ * A small open-addressed table keyed on a hash of (source, level, message)
+ * - for ESP logs the tag is part of the message, the timestamp is not.
+ * Every key owns a token bucket: the first CONFIG_DLOGGER_STORM_BURST
+ * copies pass, then CONFIG_DLOGGER_STORM_RATE per second. Copies without
+ * a token are counted instead of stored, and one "repeated N times"
+ * summary per CONFIG_DLOGGER_STORM_WINDOW_MS replaces them.
+ *
+ * - Keys are computed before formatting (deferred payloads are hashed as
+ *   captured), so a suppressed copy costs a hash and a table probe.
+ * - A slot is updated under a try-lock with the core's interrupts masked.
+ *   A producer that finds its slot busy simply lets its entry pass; nobody
+ *   ever waits.
+ * - The summary text is a rendered copy of the start of the message,
+ *   taken once by the first suppressed copy of the key.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+
+#define DLOGGER_STORM_SLOTS      CONFIG_DLOGGER_STORM_SLOTS  ///< Table size (power of two, 0 = off)
+#define DLOGGER_STORM_TEXT_MAX   64     ///< Message bytes kept for the summary
+
+/**
+ * @brief Outcome of dlogger_storm_check()
+ */
+typedef enum {
+    DLOGGER_STORM_PASS,          ///< Store the entry
+    DLOGGER_STORM_SUPPRESS,      ///< Drop the entry, it has been counted
+    DLOGGER_STORM_SUPPRESS_TEXT, ///< Drop it, but first give its text to dlogger_storm_set_text()
+} dlogger_storm_verdict_t;
+
+/**
+ * @brief A "repeated N times" record to emit
+ */
+typedef struct {
+    uint32_t count;              ///< Copies suppressed (0 = nothing to emit)
+    uint8_t source;              ///< dlogger_source_t
+    uint8_t level;               ///< dlogger_level_t
+    uint16_t length;             ///< Bytes in `text`
+    char text[DLOGGER_STORM_TEXT_MAX];  ///< Start of the message (no NUL)
+} dlogger_storm_summary_t;
+
+/**
+ * @brief Start the storm key of an entry of (source, level)
+ *
+ * Extend it with dlogger_storm_hash() over the message bytes.
+ */
+static inline uint32_t dlogger_storm_key(uint8_t source, uint8_t level) {
+    return 2166136261u ^ ((uint32_t)source << 8) ^ level;
+}
+
+/**
+ * @brief Hash `len` more bytes into `key` (never returns 0, the free-slot marker)
+ */
+uint32_t dlogger_storm_hash(uint32_t key, const void *data, size_t len);
+
+/**
+ * @brief Account one copy of `key` and decide whether it is stored
+ *
+ * @param summary Filled (count != 0) when the key's window ended or its
+ *                slot was taken over; the caller emits it
+ */
+dlogger_storm_verdict_t dlogger_storm_check(uint32_t key, uint8_t source, uint8_t level,
+                                            uint32_t now, dlogger_storm_summary_t *summary);
+
+/**
+ * @brief Return the token of a copy that passed but could not be stored
+ *
+ * Copies lost to a full ring do not count against the key's rate.
+ */
+void dlogger_storm_refund(uint32_t key);
+
+/**
+ * @brief Provide the summary text after DLOGGER_STORM_SUPPRESS_TEXT
+ */
+void dlogger_storm_set_text(uint32_t key, const char *text, size_t len);
+
+/**
+ * @brief Summary callback used by dlogger_storm_sweep()
+ */
+typedef void (*dlogger_storm_summary_cb_t)(const dlogger_storm_summary_t *summary, void *user_ctx);
+
+/**
+ * @brief Emit the summaries of windows that ended (flush task only)
+ *
+ * @param all Emit every pending summary, ended or not (deinit)
+ * @return Milliseconds until the next window ends, UINT32_MAX if none is open
+ */
+uint32_t dlogger_storm_sweep(uint32_t now, bool all, dlogger_storm_summary_cb_t callback,
+                             void *user_ctx);
+
+/**
+ * @brief Forget every key (counters are kept)
+ */
+void dlogger_storm_reset(void);
+
+/**
+ * @brief Copies suppressed since boot
+ */
+uint32_t dlogger_storm_suppressed(void);
+
+/**
+ * @brief Summary records emitted since boot
+ */
+uint32_t dlogger_storm_summaries(void);
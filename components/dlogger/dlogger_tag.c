@@ -0,0 +1,161 @@
+#include "dlogger_tag.h"
+#include "dlogger.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+
+#define TAG_LEVEL_DEFAULT    0xFF   // Slot level: follow the "*" level
+
+_Static_assert((DLOGGER_TAG_SLOTS & (DLOGGER_TAG_SLOTS - 1)) == 0 && DLOGGER_TAG_SLOTS < 256,
+               "CONFIG_DLOGGER_TAG_SLOTS must be a power of two below 256");
+
+typedef enum {
+    SLOT_FREE,
+    SLOT_CLAIMING,               ///< Name being written by the claiming producer
+    SLOT_READY,                  ///< Name and hash are valid and never change again
+} slot_state_t;
+
+/**
+ * @brief One interned tag
+ */
+typedef struct {
+    _Atomic uint8_t state;       ///< slot_state_t
+    _Atomic uint8_t level;       ///< Runtime level, TAG_LEVEL_DEFAULT = follow "*"
+    uint32_t hash;               ///< tag_hash() of `name`
+    char name[DLOGGER_TAG_NAME_MAX];
+} tag_slot_t;
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+static tag_slot_t tag_slots[DLOGGER_TAG_SLOTS];
+static _Atomic uint8_t default_level = LOG_LEVEL_DEBUG;
+static _Atomic uint32_t tag_filtered;
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+static uint32_t tag_hash(const char *tag, size_t *len) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    size_t i = 0;
+    for (; tag[i]; i++) {
+        hash = (hash ^ (uint8_t)tag[i]) * 16777619u;
+    }
+    *len = i;
+    return hash;
+}
+
+/**
+ * @brief Find `tag`, claiming a free slot for it if `insert`
+ *
+ * @return The tag's slot, or NULL
+ */
+static tag_slot_t *tag_lookup(const char *tag, bool insert) {
+    if (!tag) return NULL;
+
+    size_t len;
+    uint32_t hash = tag_hash(tag, &len);
+    if (len >= DLOGGER_TAG_NAME_MAX) return NULL;
+
+    for (uint32_t i = 0; i < DLOGGER_TAG_SLOTS; i++) {
+        tag_slot_t *slot = &tag_slots[(hash + i) & (DLOGGER_TAG_SLOTS - 1)];
+        uint8_t state = atomic_load_explicit(&slot->state, memory_order_acquire);
+
+        if (state == SLOT_FREE) {
+            if (!insert) return NULL;   // Slots are never freed: the tag is not further on
+            if (!atomic_compare_exchange_strong_explicit(&slot->state, &state, SLOT_CLAIMING,
+                                                         memory_order_acquire,
+                                                         memory_order_acquire)) {
+                // Lost the slot; check what the winner put there
+                if (state != SLOT_READY) return NULL;
+            } else {
+                slot->hash = hash;
+                memcpy(slot->name, tag, len + 1);
+                atomic_store_explicit(&slot->level, TAG_LEVEL_DEFAULT, memory_order_relaxed);
+                atomic_store_explicit(&slot->state, SLOT_READY, memory_order_release);
+                return slot;
+            }
+        }
+
+        if (state == SLOT_CLAIMING) {
+            return NULL;    // Could be this tag; never wait for the claimer
+        }
+        if (slot->hash == hash && strcmp(slot->name, tag) == 0) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static inline uint8_t slot_id(const tag_slot_t *slot) {
+    return slot ? (uint8_t)(slot - tag_slots + 1) : DLOGGER_TAG_NONE;
+}
+
+// ============================================================================
+// PUBLIC (PRIVATE TO DLOGGER) API
+// ============================================================================
+
+uint8_t dlogger_tag_intern(const char *tag) {
+    return slot_id(tag_lookup(tag, true));
+}
+
+const char *dlogger_tag_name(uint8_t id) {
+    if (id == DLOGGER_TAG_NONE || id > DLOGGER_TAG_SLOTS) return NULL;
+    tag_slot_t *slot = &tag_slots[id - 1];
+    if (atomic_load_explicit(&slot->state, memory_order_acquire) != SLOT_READY) return NULL;
+    return slot->name;
+}
+
+bool dlogger_tag_enabled(uint8_t id, uint8_t level) {
+    uint8_t threshold = TAG_LEVEL_DEFAULT;
+    if (id != DLOGGER_TAG_NONE && id <= DLOGGER_TAG_SLOTS) {
+        threshold = atomic_load_explicit(&tag_slots[id - 1].level, memory_order_relaxed);
+    }
+    if (threshold == TAG_LEVEL_DEFAULT) {
+        threshold = atomic_load_explicit(&default_level, memory_order_relaxed);
+    }
+    if (level <= threshold) return true;
+
+    atomic_fetch_add_explicit(&tag_filtered, 1, memory_order_relaxed);
+    return false;
+}
+
+bool dlogger_tag_set_level(const char *tag, uint8_t level) {
+    if (tag && strcmp(tag, "*") == 0) {
+        atomic_store_explicit(&default_level, level, memory_order_relaxed);
+        return true;
+    }
+    tag_slot_t *slot = tag_lookup(tag, true);
+    if (!slot) return false;
+    atomic_store_explicit(&slot->level, level, memory_order_relaxed);
+    return true;
+}
+
+uint8_t dlogger_tag_get_level(const char *tag) {
+    uint8_t level = TAG_LEVEL_DEFAULT;
+    if (tag && strcmp(tag, "*") != 0) {
+        tag_slot_t *slot = tag_lookup(tag, false);
+        if (slot) level = atomic_load_explicit(&slot->level, memory_order_relaxed);
+    }
+    return (level == TAG_LEVEL_DEFAULT) ? atomic_load_explicit(&default_level, memory_order_relaxed)
+                                        : level;
+}
+
+size_t dlogger_tag_render_prefix(uint8_t id, uint8_t level, uint32_t timestamp,
+                                 char *out, size_t out_len) {
+    static const char letters[LOG_LEVEL_COUNT] = { 'E', 'W', 'I', 'D' };
+    const char *name = dlogger_tag_name(id);
+    int n = snprintf(out, out_len, "%c (%" PRIu32 ") %s: ",
+                     (level < LOG_LEVEL_COUNT) ? letters[level] : '?', timestamp,
+                     name ? name : "?");
+    if (n < 0) return 0;
+    return ((size_t)n < out_len) ? (size_t)n : out_len - 1;
+}
+
+uint32_t dlogger_tag_filtered(void) {
+    return atomic_load_explicit(&tag_filtered, memory_order_relaxed);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+/**
+ * @file dlogger_tag.h
+ * @brief Interned ESP log tags and per-tag runtime levels (private to dlogger)
+ *
+ * The ESP log hook reads the tag argument of every line before formatting
+ * it and interns it here: an open-addressed table of at most
+ * CONFIG_DLOGGER_TAG_SLOTS names, where a tag's id is its slot index + 1.
+ * Records then hold the 1-byte id and the message body instead of the
+ * "X (time) TAG: " prefix, which is rebuilt when the record is rendered.
+ *
+ * - Slots are claimed with a CAS and never released, so an id stays valid
+ *   (and its name unchanged) until reboot. A producer that finds its slot
+ *   being claimed gets no id and stores plain text; nobody waits.
+ * - Every tag has a runtime level (default: that of "*"); the hook drops
+ *   lines above it before formatting them.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+#define DLOGGER_TAG_SLOTS     CONFIG_DLOGGER_TAG_SLOTS  ///< Table size (power of two, < 256)
+#define DLOGGER_TAG_NAME_MAX  24     ///< Longest interned tag incl. NUL (longer ones stay text)
+#define DLOGGER_TAG_NONE      0      ///< Id of a tag that could not be interned
+
+/**
+ * @brief Id of `tag`, interning it on first use
+ *
+ * @return 1..DLOGGER_TAG_SLOTS, or DLOGGER_TAG_NONE if the table is full,
+ *         the tag is too long or its slot is being claimed right now
+ */
+uint8_t dlogger_tag_intern(const char *tag);
+
+/**
+ * @brief Name of an interned tag, NULL for an unknown id
+ */
+const char *dlogger_tag_name(uint8_t id);
+
+/**
+ * @brief Whether a line of `level` from tag `id` passes its runtime level
+ *
+ * DLOGGER_TAG_NONE uses the default level. Lines that do not pass are
+ * counted in dlogger_tag_filtered().
+ */
+bool dlogger_tag_enabled(uint8_t id, uint8_t level);
+
+/**
+ * @brief Set the runtime level of `tag` ("*" = default of all tags
+ *        without their own level)
+ *
+ * @return false if the table has no room for `tag`
+ */
+bool dlogger_tag_set_level(const char *tag, uint8_t level);
+
+/**
+ * @brief Runtime level of `tag` (the default if it has none)
+ */
+uint8_t dlogger_tag_get_level(const char *tag);
+
+/**
+ * @brief Render the "X (timestamp) TAG: " prefix of a tagged record
+ *
+ * @return Characters written (excluding the NUL)
+ */
+size_t dlogger_tag_render_prefix(uint8_t id, uint8_t level, uint32_t timestamp,
+                                 char *out, size_t out_len);
+
+/**
+ * @brief Lines dropped by per-tag levels since boot
+ */
+uint32_t dlogger_tag_filtered(void);
@@ -0,0 +1,314 @@
+#include "dlogger_tail.h"
+#include "dlogger_port.h"
+#include "dlogger_ring.h"
+#include "dlogger_tag.h"
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_rom_crc.h"
+
+#define TAIL_MAGIC        0x4C544C44u   // "DLTL"
+#define TAIL_FRAME_MAGIC  0x7E12u
+
+#if DLOGGER_TAIL_SIZE
+_Static_assert((DLOGGER_TAIL_SIZE & (DLOGGER_TAIL_SIZE - 1)) == 0,
+               "CONFIG_DLOGGER_CRASH_TAIL_KB must be a power of two");
+
+/**
+ * @brief Arena header, rewritten only when a run starts
+ */
+typedef struct {
+    uint32_t magic;              ///< TAIL_MAGIC
+    uint32_t size;               ///< DLOGGER_TAIL_SIZE of the build that wrote it
+    uint32_t sequence;           ///< Store position the run started writing at
+    uint32_t offset;
+    uint32_t image_id;           ///< dlogger_port_image() of the run
+    uint64_t image_base;
+    uint32_t crc;                ///< CRC32 of the fields above
+    _Atomic uint32_t head;       ///< Free-running position of the next frame
+} tail_hdr_t;
+
+/**
+ * @brief Frame header (20 bytes), followed by the tag name and the
+ *        payload, padded to 4 bytes
+ */
+typedef struct {
+    uint16_t magic;              ///< TAIL_FRAME_MAGIC
+    uint16_t length;             ///< Payload bytes
+    uint32_t timestamp;
+    uint32_t seq;                ///< Commit sequence number, as written to the store
+    uint8_t source;
+    uint8_t level;               ///< dlogger_level_t | DLOGGER_REC_FLAG_*
+    uint8_t tag_length;          ///< Tag name bytes before the payload (tagged records)
+    uint8_t reserved;
+    uint32_t crc;                ///< CRC32 of the fields above, the tag and the payload, seeded with the position
+} tail_frame_t;
+
+_Static_assert(DLOGGER_TAIL_PAYLOAD_MAX >= DLOGGER_TAIL_TEXT_MAX,
+               "crash tail frames must hold a full message");
+
+typedef struct {
+    tail_hdr_t hdr;
+    uint8_t arena[DLOGGER_TAIL_SIZE];
+} tail_region_t;
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+static DLOGGER_PORT_RETAINED_ATTR tail_region_t tail_ram;
+static tail_region_t *tail;      ///< Mapped region, NULL while off
+static bool tail_valid;          ///< Header passed the check at init
+static dlogger_port_image_t tail_image;   ///< This run's firmware image
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+static uint32_t hdr_crc(const tail_hdr_t *hdr) {
+    return esp_rom_crc32_le(0, (const uint8_t *)hdr, offsetof(tail_hdr_t, crc));
+}
+
+static inline uint32_t frame_bytes(const tail_frame_t *frame) {
+    return (uint32_t)((sizeof(tail_frame_t) + frame->tag_length + frame->length + 3) & ~(size_t)3);
+}
+
+/**
+ * @brief CRC of a frame whose `crc` field is zero, followed by `tag` and `payload`
+ */
+static uint32_t frame_crc(uint32_t pos, const tail_frame_t *frame, const char *tag,
+                          const void *payload) {
+    uint32_t crc = esp_rom_crc32_le(pos, (const uint8_t *)frame, sizeof(*frame));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)tag, frame->tag_length);
+    return esp_rom_crc32_le(crc, (const uint8_t *)payload, frame->length);
+}
+
+/**
+ * @brief Copy into the arena at free-running position `pos`, wrapping
+ */
+static void arena_write(uint32_t pos, const void *src, size_t len) {
+    uint32_t at = pos & (DLOGGER_TAIL_SIZE - 1);
+    size_t first = DLOGGER_TAIL_SIZE - at;
+    if (first > len) first = len;
+    memcpy(&tail->arena[at], src, first);
+    memcpy(tail->arena, (const uint8_t *)src + first, len - first);
+}
+
+static void arena_read(uint32_t pos, void *dst, size_t len) {
+    uint32_t at = pos & (DLOGGER_TAIL_SIZE - 1);
+    size_t first = DLOGGER_TAIL_SIZE - at;
+    if (first > len) first = len;
+    memcpy(dst, &tail->arena[at], first);
+    memcpy((uint8_t *)dst + first, tail->arena, len - first);
+}
+
+/**
+ * @brief Find the next intact frame at or after `pos`
+ *
+ * Where a frame does not check out (overwritten start, torn by the reset)
+ * the walk resyncs on the next word.
+ *
+ * @param pos In: where to look; out: the frame found
+ * @return false when no frame is left before `head`
+ */
+static bool frame_find(uint32_t *pos, uint32_t head, tail_frame_t *frame, char *tag,
+                       uint8_t *payload) {
+    for (; head - *pos >= sizeof(tail_frame_t); *pos += 4) {
+        arena_read(*pos, frame, sizeof(*frame));
+        uint32_t crc = frame->crc;
+        frame->crc = 0;
+        if (frame->magic != TAIL_FRAME_MAGIC || frame->length > DLOGGER_TAIL_PAYLOAD_MAX ||
+            frame->tag_length >= DLOGGER_TAG_NAME_MAX || frame_bytes(frame) > head - *pos) {
+            continue;
+        }
+        arena_read(*pos + sizeof(*frame), tag, frame->tag_length);
+        arena_read(*pos + sizeof(*frame) + frame->tag_length, payload, frame->length);
+        if (frame_crc(*pos, frame, tag, payload) == crc) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Oldest position that may hold a frame of the last run
+ */
+static inline uint32_t tail_start_pos(uint32_t head) {
+    return head - ((head < DLOGGER_TAIL_SIZE) ? head : DLOGGER_TAIL_SIZE);
+}
+
+/**
+ * @brief Render a recovered frame as the text of `entry`
+ *
+ * @param payload Frame payload; a deferred capture's format address is
+ *                moved to this run's load address (host) in place
+ */
+static void frame_render(const tail_frame_t *frame, const char *tag, uint8_t *payload,
+                         dlogger_entry_t *entry) {
+    char *out = entry->message;
+    size_t out_len = sizeof(entry->message);
+    uint8_t level = frame->level & DLOGGER_REC_LEVEL_MASK;
+
+    if (frame->level & DLOGGER_REC_FLAG_DEFERRED) {
+        const char *format;
+        if (tail->hdr.image_id != tail_image.id || frame->length < sizeof(format)) {
+            snprintf(out, out_len, "[entry of another firmware image, format unavailable]");
+            return;
+        }
+        memcpy(&format, payload, sizeof(format));
+        format += tail_image.base - (uintptr_t)tail->hdr.image_base;
+        memcpy(payload, &format, sizeof(format));
+        dlogger_fmt_render(payload, frame->length, out, out_len);
+        return;
+    }
+
+    size_t used = 0;
+    if (frame->level & DLOGGER_REC_FLAG_TAGGED) {
+        // The tag table was lost with the reset: intern the name again
+        char name[DLOGGER_TAG_NAME_MAX];
+        memcpy(name, tag, frame->tag_length);
+        name[frame->tag_length] = '\0';
+        used = dlogger_tag_render_prefix(dlogger_tag_intern(name), level, frame->timestamp,
+                                         out, out_len);
+    }
+    size_t copy = (frame->length < out_len - 1 - used) ? frame->length : out_len - 1 - used;
+    memcpy(out + used, payload, copy);
+    out[used + copy] = '\0';
+}
+#endif
+
+// ============================================================================
+// PUBLIC (PRIVATE TO DLOGGER) API
+// ============================================================================
+
+esp_err_t dlogger_tail_init(void) {
+#if DLOGGER_TAIL_SIZE
+    if (tail) return ESP_OK;
+    tail = (tail_region_t *)dlogger_port_retained_map(&tail_ram, sizeof(tail_ram));
+    if (!tail) return ESP_FAIL;
+
+    tail_valid = tail->hdr.magic == TAIL_MAGIC && tail->hdr.size == DLOGGER_TAIL_SIZE &&
+                 tail->hdr.crc == hdr_crc(&tail->hdr);
+    dlogger_port_image(&tail_image);
+#endif
+    return ESP_OK;
+}
+
+bool dlogger_tail_origin(uint32_t *sequence, uint32_t *offset) {
+#if DLOGGER_TAIL_SIZE
+    if (!tail || !tail_valid) return false;
+    *sequence = tail->hdr.sequence;
+    *offset = tail->hdr.offset;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool dlogger_tail_seq_range(uint32_t *first, uint32_t *count) {
+#if DLOGGER_TAIL_SIZE
+    if (!tail || !tail_valid) return false;
+
+    uint32_t head = atomic_load(&tail->hdr.head);
+    uint32_t pos = tail_start_pos(head);
+    tail_frame_t frame;
+    char tag[DLOGGER_TAG_NAME_MAX];
+    uint8_t payload[DLOGGER_TAIL_PAYLOAD_MAX];
+    bool found = false;
+    uint32_t lo = 0, hi = 0;
+    for (; frame_find(&pos, head, &frame, tag, payload); pos += frame_bytes(&frame)) {
+        // Sequence numbers are compared modulo 2^32
+        if (!found || (int32_t)(frame.seq - lo) < 0) lo = frame.seq;
+        if (!found || (int32_t)(frame.seq - hi) > 0) hi = frame.seq;
+        found = true;
+    }
+    if (!found) return false;
+    *first = lo;
+    *count = hi - lo + 1;
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t dlogger_tail_recover(dlogger_tail_cb_t callback, void *user_ctx) {
+    size_t count = 0;
+#if DLOGGER_TAIL_SIZE
+    if (!tail || !tail_valid) return 0;
+
+    // Walk the last DLOGGER_TAIL_SIZE bytes
+    uint32_t head = atomic_load(&tail->hdr.head);
+    uint32_t pos = tail_start_pos(head);
+    tail_frame_t frame;
+    dlogger_entry_t entry;
+    char tag[DLOGGER_TAG_NAME_MAX];
+    uint8_t payload[DLOGGER_TAIL_PAYLOAD_MAX];
+    for (; frame_find(&pos, head, &frame, tag, payload); pos += frame_bytes(&frame)) {
+        entry.timestamp = frame.timestamp;
+        entry.source = frame.source;
+        entry.level = frame.level & DLOGGER_REC_LEVEL_MASK;
+        frame_render(&frame, tag, payload, &entry);
+        count++;
+        if (!callback(&entry, frame.seq, user_ctx)) break;
+    }
+#endif
+    return count;
+}
+
+void dlogger_tail_start(uint32_t sequence, uint32_t offset) {
+#if DLOGGER_TAIL_SIZE
+    if (!tail) return;
+    tail->hdr.magic = TAIL_MAGIC;
+    tail->hdr.size = DLOGGER_TAIL_SIZE;
+    tail->hdr.sequence = sequence;
+    tail->hdr.offset = offset;
+    tail->hdr.image_id = tail_image.id;
+    tail->hdr.image_base = tail_image.base;
+    tail->hdr.crc = hdr_crc(&tail->hdr);
+    atomic_store(&tail->hdr.head, 0);
+    memset(tail->arena, 0, sizeof(tail->arena));
+    tail_valid = true;
+#endif
+}
+
+void dlogger_tail_append(uint32_t timestamp, uint32_t seq, uint8_t source, uint8_t level,
+                         const char *tag, const void *payload, size_t length) {
+#if DLOGGER_TAIL_SIZE
+    tail_region_t *region = tail;
+    if (!region) return;
+    if (level & DLOGGER_REC_FLAG_DEFERRED) {
+        if (length > DLOGGER_TAIL_PAYLOAD_MAX) return;   // A cut capture cannot be rendered
+    } else if (length > DLOGGER_TAIL_TEXT_MAX) {
+        length = DLOGGER_TAIL_TEXT_MAX;
+    }
+    if (!tag) tag = "";
+    size_t tag_length = strnlen(tag, DLOGGER_TAG_NAME_MAX - 1);
+
+    tail_frame_t frame = {
+        .magic = TAIL_FRAME_MAGIC,
+        .length = (uint16_t)length,
+        .timestamp = timestamp,
+        .seq = seq,
+        .source = source,
+        .level = level,
+        .tag_length = (uint8_t)tag_length,
+    };
+    uint32_t pos = atomic_fetch_add_explicit(&region->hdr.head, frame_bytes(&frame),
+                                             memory_order_relaxed);
+    frame.crc = frame_crc(pos, &frame, tag, payload);
+    arena_write(pos, &frame, sizeof(frame));
+    arena_write(pos + sizeof(frame), tag, tag_length);
+    arena_write(pos + sizeof(frame) + tag_length, payload, length);
+#else
+    (void)timestamp; (void)seq; (void)source; (void)level; (void)tag; (void)payload; (void)length;
+#endif
+}
+
+void dlogger_tail_deinit(void) {
+#if DLOGGER_TAIL_SIZE
+    if (!tail) return;
+    tail_region_t *region = tail;
+    tail = NULL;
+    atomic_store(&region->hdr.head, 0);
+    dlogger_port_retained_unmap(region, sizeof(*region));
+#endif
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+/**
+ * @file dlogger_tail.h
+ * @brief Crash-surviving copy of the newest entries (private to dlogger)
+ *
+ * Entries wait in the rings until the flush task writes them, so a panic
+ * or watchdog reset loses exactly the ones that explain it. Every committed
+ * entry is therefore also copied into a small circular arena in RAM that
+ * is not cleared at reset (a memory-mapped file on the host), and
+ * dlogger_init() writes what it finds there to the log before logging
+ * starts.
+ *
+ * - Entries are copied as stored, so deferred ones are not formatted on
+ *   the logging task: the payload keeps the format address, which is
+ *   rendered at recovery only if the same firmware image wrote it (the
+ *   header records dlogger_port_image()). Tagged ones carry the tag name
+ *   instead of the id, which means nothing after a reset.
+ * - Producers claim a frame with one fetch-add and never wait. Every frame
+ *   carries a CRC32, so frames torn by the reset or overwritten while being
+ *   copied are skipped on recovery.
+ * - After a power cycle the arena holds garbage and fails the header check.
+ * - The header also keeps the store position the last run started writing
+ *   at, and every frame the entry's sequence number, which the store
+ *   records too: recovery skips exactly the entries written there since.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "dlogger.h"
+#include "dlogger_fmt.h"
+#include "sdkconfig.h"
+
+#define DLOGGER_TAIL_SIZE      (CONFIG_DLOGGER_CRASH_TAIL_KB * 1024)  ///< Arena bytes, 0 = off
+#define DLOGGER_TAIL_TEXT_MAX  DLOGGER_MESSAGE_MAX       ///< Longer text is cut
+#define DLOGGER_TAIL_PAYLOAD_MAX  DLOGGER_FMT_MAX_PAYLOAD  ///< Largest payload kept (deferred captures)
+
+/**
+ * @brief Map the retained arena and check what the last run left there
+ *
+ * @return ESP_OK (also when the tail is disabled), or ESP_FAIL if the
+ *         arena cannot be mapped (entries are then not mirrored)
+ */
+esp_err_t dlogger_tail_init(void);
+
+/**
+ * @brief Store position the last run started writing at
+ *
+ * @return false if the arena held nothing valid (power-on, first boot)
+ */
+bool dlogger_tail_origin(uint32_t *sequence, uint32_t *offset);
+
+/**
+ * @brief Callback for dlogger_tail_recover()
+ *
+ * @param seq Sequence number the entry was committed with
+ * @return false to stop
+ */
+typedef bool (*dlogger_tail_cb_t)(const dlogger_entry_t *entry, uint32_t seq, void *user_ctx);
+
+/**
+ * @brief Sequence numbers spanned by the intact entries of the last run
+ *
+ * @param count Set to last - first + 1
+ * @return false if there are none
+ */
+bool dlogger_tail_seq_range(uint32_t *first, uint32_t *count);
+
+/**
+ * @brief Hand every intact entry of the last run to `callback`, oldest first
+ *
+ * Entries are rendered as text here. Deferred entries written by another
+ * firmware image are replaced by a note, since their format is gone.
+ *
+ * @return Number of entries passed to the callback
+ */
+size_t dlogger_tail_recover(dlogger_tail_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Empty the arena for this run, which starts writing the store at
+ *        `sequence`/`offset`
+ *
+ * Entries appended before this are discarded.
+ */
+void dlogger_tail_start(uint32_t sequence, uint32_t offset);
+
+/**
+ * @brief Copy an entry into the arena (any context, never waits)
+ *
+ * @param seq Sequence number the entry was committed with
+ * @param level dlogger_level_t with the record's DLOGGER_REC_FLAG_* bits
+ * @param tag Name of a tagged record's tag (its payload then starts after
+ *            the id), NULL otherwise
+ * @param payload Record payload as stored in the ring
+ */
+void dlogger_tail_append(uint32_t timestamp, uint32_t seq, uint8_t source, uint8_t level,
+                         const char *tag, const void *payload, size_t length);
+
+/**
+ * @brief Empty the arena (everything reached the log) and unmap it
+ */
+void dlogger_tail_deinit(void);
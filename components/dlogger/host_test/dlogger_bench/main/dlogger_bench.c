@@ -0,0 +1,1042 @@
+/**
+ * @file dlogger_bench.c
+ * @brief Host benchmark and stress run of dlogger (ESP-IDF linux target)
+ *
+ * Pushes configurable producer counts, message sizes and burst patterns
+ * through dlogger_add_entry() / dlogger_log() and reports, per scenario,
+ * the cost of a call (p50/p99/max), entries per second, drops, flush
+ * throughput and the block bytes written per line (after compression) as
+ * JSON. Every scenario starts a fresh dlogger on an empty
+ * log directory inside a temporary directory.
+ *
+ * Without DLOGGER_BENCH_* variables the default scenario matrix runs;
+ * setting any of them runs that one scenario instead:
+ *   DLOGGER_BENCH_PRODUCERS  producer tasks (default 1)
+ *   DLOGGER_BENCH_SIZE       message bytes (default 64)
+ *   DLOGGER_BENCH_CALLS      calls per producer (default 20000)
+ *   DLOGGER_BENCH_BURST      calls per burst, 0 = no pauses (default 0)
+ *   DLOGGER_BENCH_GAP_MS     pause after each burst (default 10)
+ *   DLOGGER_BENCH_API        "entry" or "log" (default entry)
+ * Messages are windows into a fixed log-like text, so compression sees
+ * repetition typical of logs rather than a single repeated character.
+ * Build a second time with sdkconfig.nocompress added to the defaults to
+ * compare stored bytes with and without CONFIG_DLOGGER_COMPRESSION (see
+ * CMakeLists.txt); the "config" object of the report tells the runs apart.
+ * After the scenarios, storage I/O completion callbacks log ERROR entries.
+ * They run on the I/O task, which the durable sync of those entries waits
+ * for, so the callbacks must not wait: any durable timeout fails the run.
+ * Then a stream sink writes to one end of a socketpair and a memory sink
+ * keeps a tail, first while the peer reads every line, then while it
+ * stalls: the run fails unless the reading phase arrives complete and
+ * the stall costs only the stream sink its lines (lost / refused), never
+ * a producer call or the memory sink.
+ * The crash case then runs the bench again as a child process that logs
+ * a batch, waits until it is flushed, logs a second batch (INFO and ERROR
+ * entries, so two rings; the first one stamped before the flush) and
+ * exits without dlogger_deinit(). The next dlogger_init() must leave
+ * every one of those entries in the log exactly once.
+ * Last, N real pthreads (DLOGGER_BENCH_RING_THREADS, default 4) drive
+ * dlogger_ring_reserve()/dlogger_ring_commit() on a bare ring against a
+ * consumer thread and a lock-free reader thread; any lost, duplicated,
+ * reordered or corrupted record fails the run.
+ * The report goes to DLOGGER_BENCH_JSON (default dlogger_bench.json in the
+ * starting directory) and to stdout.
+ *
+ * The POSIX FreeRTOS port runs one task at a time, so the task-based
+ * producers contend through preemption rather than in parallel (the ring
+ * case is the one that races cores); figures are for comparing builds on
+ * the same machine, not for predicting the ESP32-S3.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "dlogger.h"
+#include "storage_io.h"
+#include "dlogger_ring.h"
+
+#define BENCH_MAX_PRODUCERS  16
+#define BENCH_MAX_SIZE       DLOGGER_MESSAGE_MAX
+#define BENCH_TASK_STACK     8192
+#define BENCH_DRAIN_MS       10000  // Give up waiting for the flush task after this
+#define BENCH_IO_CALLBACKS   200    // Completion callbacks that log an ERROR
+#define BENCH_IO_PATH        "storage/bench_io.bin"
+#define BENCH_SINK_ENTRIES   2000   // Entries per phase of the sink case
+#define BENCH_SINK_TAIL      64     // Entries kept by the memory sink
+#define BENCH_SINK_WAIT_MS   3000   // Give up waiting for the sinks after this
+#define BENCH_CRASH_ENV      "DLOGGER_BENCH_CRASH_CHILD"  // Set in the crashing child process
+#define BENCH_CRASH_ENTRIES  16     // Entries per batch of the crash case
+#define BENCH_RING_THREADS   4      // Producer pthreads of the ring case
+#define BENCH_RING_MAX_THREADS 16
+#define BENCH_RING_RECORDS   100000 // Records per producer thread
+#define BENCH_RING_SIZE      (16 * 1024)
+
+typedef enum {
+    API_ENTRY,               ///< dlogger_add_entry() of a prebuilt message
+    API_LOG,                 ///< dlogger_log() with an integer and a string argument
+} bench_api_t;
+
+typedef struct {
+    char name[48];
+    uint32_t producers;
+    uint32_t size;           ///< Message bytes
+    uint32_t calls;          ///< Per producer
+    uint32_t burst;          ///< Calls per burst, 0 = no pauses
+    uint32_t gap_ms;         ///< Pause after each burst
+    bench_api_t api;
+} scenario_t;
+
+typedef struct {
+    const scenario_t *scenario;
+    uint32_t id;
+    uint32_t *ns;            ///< Cost of each call
+    uint32_t failed;         ///< Calls that returned an error (entry dropped)
+    SemaphoreHandle_t done;
+} producer_t;
+
+typedef struct {
+    double p50, p99, max, mean;   ///< ns per call
+    double entries_per_s;         ///< Accepted entries over the production phase
+    uint64_t calls;
+    uint64_t dropped;             ///< Refused calls plus entries evicted/dropped later
+    double drop_rate;
+    double flush_entries_per_s;   ///< Accepted entries over production + drain
+    uint64_t bytes_written;       ///< Block bytes the scenario wrote to the segments
+    double flush_bytes_per_s;     ///< bytes_written over production + drain
+    double stored_bytes_per_line; ///< bytes_written per flushed entry
+    double drain_ms;              ///< From the last call until everything was flushed
+} result_t;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t ns[BENCH_IO_CALLBACKS];   ///< Cost of the dlogger call in each callback
+    double p50, p99, max;               ///< ns per call
+    uint64_t durable_timeouts;          ///< Callbacks that waited for the sync and gave up
+} io_result_t;
+
+typedef struct {
+    uint32_t logged;                 ///< Entries logged per phase
+    uint32_t received;               ///< Lines the peer read in the reading phase
+    dlogger_sink_stats_t live;       ///< Stream sink after the reading phase
+    dlogger_sink_stats_t stalled;    ///< Stream sink after the stall (cumulative)
+    dlogger_sink_stats_t memory;     ///< Memory sink at the end
+    uint32_t failed;                 ///< Producer calls refused during the stall
+    double max_ns;                   ///< Slowest producer call during the stall
+    bool tail_current;               ///< The memory sink's newest entry is the last one logged
+    bool ok;
+} sink_result_t;
+
+typedef struct {
+    uint32_t logged;                 ///< Entries the child logged
+    uint32_t flushed;                ///< Of batch b, already in the log at the crash
+    uint32_t recovered;              ///< Entries the restart added from the crash tail
+    uint32_t stamped_before;         ///< Of batch b, stamped no later than the newest of batch a
+    uint32_t missing;                ///< Logged entries not in the log after the restart
+    uint32_t duplicated;             ///< Logged entries in the log more than once
+    bool ok;
+} crash_result_t;
+
+typedef struct {
+    uint8_t flushed[BENCH_CRASH_ENTRIES];       ///< Copies of each batch a entry
+    uint8_t unflushed[BENCH_CRASH_ENTRIES];     ///< Copies of each batch b entry
+    uint32_t flushed_ts;                        ///< Newest batch a timestamp
+    uint32_t unflushed_ts[BENCH_CRASH_ENTRIES];
+} crash_scan_t;
+
+typedef struct {
+    uint32_t threads;
+    uint64_t records;                ///< Records committed by all producers
+    uint64_t consumed;
+    uint64_t lost;                   ///< Sequence numbers never consumed
+    uint64_t duplicated;             ///< Sequence numbers consumed twice
+    uint64_t reordered;              ///< Records out of their producer's order
+    uint64_t corrupt;                ///< Payloads that do not match their record
+    uint64_t reserve_retries;        ///< Reservations refused while the ring was full
+    uint64_t reader_copies;          ///< Records the reader thread copied and checked
+    uint64_t reader_corrupt;         ///< Reader copies that passed validation but are wrong
+    double records_per_s;
+    bool ok;
+} ring_result_t;
+
+typedef struct {
+    dlogger_ring_t *ring;
+    uint32_t id;
+    _Atomic uint32_t *next_seq;
+    uint64_t retries;
+} ring_producer_t;
+
+typedef struct {
+    dlogger_ring_t *ring;
+    ring_result_t *result;
+    uint8_t *seen;                   ///< Consumption count per sequence number
+    uint32_t next_index[BENCH_RING_MAX_THREADS];
+    _Atomic bool *producing;         ///< Cleared once every producer is done
+} ring_consumer_t;
+
+typedef struct {
+    int fd;                          ///< Peer end of the socketpair
+    char line[512];                  ///< Partial line carried between reads
+    size_t length;
+    uint32_t lines;                  ///< Complete bench lines read
+} sink_peer_t;
+
+static const scenario_t default_scenarios[] = {
+    { "entry_1p_64b",        1,  64, 20000,   0,  0, API_ENTRY },
+    { "entry_4p_64b",        4,  64, 20000,   0,  0, API_ENTRY },
+    { "entry_4p_180b",       4, 180, 20000,   0,  0, API_ENTRY },
+    { "entry_4p_64b_burst",  4,  64, 20000, 500, 10, API_ENTRY },
+    { "log_1p_64b",          1,  64, 20000,   0,  0, API_LOG },
+    { "log_4p_64b_burst",    4,  64, 20000, 500, 10, API_LOG },
+};
+
+static const char corpus[] =
+    "wifi: sta connected, rssi -61 dBm, channel 6; http: GET /api/status 200 in 12 ms; "
+    "sensor: temperature 23.4 C humidity 41 percent; ui: screen settings opened by user; "
+    "storage: segment 2 rotated, 131072 bytes free; ota: no update available, next check "
+    "in 3600 s; heap: free 182344 largest block 110592; task flush stack high water 1220; "
+    "wifi: sta disconnected, reason 8, reconnecting in 500 ms; http: POST /api/log 201 ";
+static uint32_t message_len;      ///< Text bytes of each message in this scenario
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t env_u32(const char *name, uint32_t fallback, bool *set) {
+    const char *value = getenv(name);
+    if (!value || !*value) return fallback;
+    *set = true;
+    return (uint32_t)strtoul(value, NULL, 10);
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t entries_lost(const dlogger_stats_t *stats) {
+    return stats->dropped + stats->evicted + stats->priority_dropped + stats->priority_evicted;
+}
+
+/**
+ * @brief Empty the log directory so every scenario starts alike
+ */
+static void wipe_log_dir(void) {
+    // The I/O service keeps its last file open: stop it, or the next run's
+    // blocks would land in a deleted segment (dlogger_init() restarts it)
+    storage_io_deinit();
+
+    char path[64];
+    for (int i = 0; i < 16; i++) {
+        snprintf(path, sizeof(path), "storage/log%d.dlog", i);
+        remove(path);
+    }
+    remove("storage/dlogger_retained.bin");
+}
+
+// ============================================================================
+// PRODUCERS
+// ============================================================================
+
+/**
+ * @brief Message `index` of a producer: a window into the corpus
+ */
+static void message_at(uint32_t id, uint32_t index, char *out) {
+    size_t offset = (index * 53u + id * 101u) % (sizeof(corpus) - 1 - message_len);
+    memcpy(out, corpus + offset, message_len);
+    out[message_len] = '\0';
+}
+
+static void producer_task(void *arg) {
+    producer_t *p = (producer_t *)arg;
+    const scenario_t *s = p->scenario;
+    char text[BENCH_MAX_SIZE + 1];
+
+    for (uint32_t i = 0; i < s->calls; i++) {
+        message_at(p->id, i, text);
+        uint64_t start = now_ns();
+        esp_err_t ret;
+        if (s->api == API_LOG) {
+            ret = dlogger_log("bench %u %s", (unsigned)i, text);
+        } else {
+            ret = dlogger_add_entry(LOG_SOURCE_USER, LOG_LEVEL_INFO, text);
+        }
+        p->ns[i] = (uint32_t)(now_ns() - start);
+        if (ret != ESP_OK) p->failed++;
+
+        if (s->burst && (i + 1) % s->burst == 0) {
+            vTaskDelay(pdMS_TO_TICKS(s->gap_ms));
+        }
+    }
+
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Run one scenario on a fresh dlogger
+ */
+static bool run_scenario(const scenario_t *s, result_t *r) {
+    memset(r, 0, sizeof(*r));
+    message_len = (s->api == API_LOG && s->size > 12) ? s->size - 12 : s->size;
+
+    wipe_log_dir();
+    if (dlogger_init() != ESP_OK) return false;
+    vTaskDelay(pdMS_TO_TICKS(50));  // Segment preallocation and init lines are not measured
+
+    dlogger_stats_t before, after;
+    dlogger_get_stats(&before);
+
+    uint64_t total = (uint64_t)s->producers * s->calls;
+    uint32_t *ns = (uint32_t *)malloc(total * sizeof(uint32_t));
+    producer_t producers[BENCH_MAX_PRODUCERS] = { 0 };
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(s->producers, 0);
+    if (!ns || !done) {
+        free(ns);
+        if (done) vSemaphoreDelete(done);
+        dlogger_deinit();
+        return false;
+    }
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < s->producers; i++) {
+        producers[i] = (producer_t){ .scenario = s, .id = i, .ns = &ns[i * s->calls], .done = done };
+        xTaskCreate(producer_task, "bench_prod", BENCH_TASK_STACK, &producers[i],
+                    tskIDLE_PRIORITY + 2, NULL);
+    }
+    for (uint32_t i = 0; i < s->producers; i++) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    uint64_t produced = now_ns();
+
+    // Flush throughput: until the flush task has written everything
+    dlogger_force_flush();
+    do {
+        vTaskDelay(1);
+        dlogger_get_stats(&after);
+    } while (after.flush_pending && now_ns() - produced < BENCH_DRAIN_MS * 1000000ull);
+    uint64_t drained = now_ns();
+    dlogger_get_stats(&after);
+
+    uint64_t failed = 0;
+    for (uint32_t i = 0; i < s->producers; i++) {
+        failed += producers[i].failed;
+    }
+    qsort(ns, total, sizeof(uint32_t), compare_u32);
+    double sum = 0;
+    for (uint64_t i = 0; i < total; i++) {
+        sum += ns[i];
+    }
+
+    uint64_t accepted = total - failed;
+    uint64_t lost_later = entries_lost(&after) - entries_lost(&before);
+    double produce_s = (produced - start) / 1e9;
+    double flush_s = (drained - start) / 1e9;
+
+    r->calls = total;
+    r->p50 = ns[total / 2];
+    r->p99 = ns[total * 99 / 100];
+    r->max = ns[total - 1];
+    r->mean = sum / total;
+    r->entries_per_s = accepted / produce_s;
+    r->dropped = total - accepted + (lost_later > failed ? lost_later - failed : 0);
+    r->drop_rate = (double)r->dropped / total;
+    uint64_t flushed = accepted - (r->dropped - failed);
+    r->flush_entries_per_s = flushed / flush_s;
+    r->bytes_written = after.bytes_written - before.bytes_written;
+    r->flush_bytes_per_s = r->bytes_written / flush_s;
+    r->stored_bytes_per_line = flushed ? (double)r->bytes_written / flushed : 0;
+    r->drain_ms = (drained - produced) / 1e6;
+
+    vSemaphoreDelete(done);
+    free(ns);
+    dlogger_deinit();
+    return true;
+}
+
+/**
+ * @brief Completion callback that logs an error (runs on the storage I/O task)
+ */
+static void io_log_done(esp_err_t result, void *user_ctx) {
+    io_result_t *r = (io_result_t *)user_ctx;
+    uint64_t start = now_ns();
+    dlogger_add_entry(LOG_SOURCE_USER, LOG_LEVEL_ERROR, "bench io callback");
+    if (r->calls < BENCH_IO_CALLBACKS) {
+        r->ns[r->calls++] = (uint32_t)(now_ns() - start);
+    }
+}
+
+/**
+ * @brief Log ERROR entries from storage I/O completion callbacks
+ */
+static bool run_io_callback_case(io_result_t *r) {
+    memset(r, 0, sizeof(*r));
+    wipe_log_dir();
+    if (dlogger_init() != ESP_OK) return false;
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    dlogger_stats_t before, after;
+    dlogger_get_stats(&before);
+
+    static const char block[64] = { 0 };
+    bool ok = true;
+    for (uint32_t i = 0; i < BENCH_IO_CALLBACKS && ok; i++) {
+        ok = storage_io_append(BENCH_IO_PATH, block, sizeof(block), io_log_done, r) == ESP_OK;
+        if (i % 8 == 7) vTaskDelay(1);   // Let the I/O task run callbacks between batches
+    }
+    ok = ok && storage_io_drain(false) == ESP_OK;
+    dlogger_get_stats(&after);
+
+    if (r->calls) {
+        qsort(r->ns, r->calls, sizeof(uint32_t), compare_u32);
+        r->p50 = r->ns[r->calls / 2];
+        r->p99 = r->ns[r->calls * 99 / 100];
+        r->max = r->ns[r->calls - 1];
+    }
+    r->durable_timeouts = after.durable_timeouts - before.durable_timeouts;
+
+    remove(BENCH_IO_PATH);
+    dlogger_deinit();
+    return ok && r->calls == BENCH_IO_CALLBACKS;
+}
+
+/**
+ * @brief Read whatever the stream sink has written, counting bench lines
+ */
+static void sink_peer_read(sink_peer_t *peer) {
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(peer->fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] != '\n') {
+                if (peer->length < sizeof(peer->line) - 1) peer->line[peer->length++] = buf[i];
+                continue;
+            }
+            peer->line[peer->length] = '\0';
+            if (strstr(peer->line, "bench sink ")) peer->lines++;
+            peer->length = 0;
+        }
+    }
+}
+
+/**
+ * @brief Log one phase of the sink case, flushing as it goes
+ *
+ * @param peer Read between batches, or NULL while the peer stalls
+ */
+static void sink_log_phase(uint32_t first, sink_result_t *r, sink_peer_t *peer) {
+    for (uint32_t i = first; i < first + r->logged; i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "bench sink %u", (unsigned)i);
+        uint64_t start = now_ns();
+        if (dlogger_add_entry(LOG_SOURCE_USER, LOG_LEVEL_INFO, text) != ESP_OK) r->failed++;
+        double ns = (double)(now_ns() - start);
+        if (!peer && ns > r->max_ns) r->max_ns = ns;
+
+        if (i % 50 == 49) {
+            dlogger_force_flush();
+            vTaskDelay(pdMS_TO_TICKS(2));
+            if (peer) sink_peer_read(peer);
+        }
+    }
+}
+
+/**
+ * @brief Stream and memory sinks while the stream's peer reads, then stalls
+ */
+static bool run_sink_case(sink_result_t *r) {
+    memset(r, 0, sizeof(*r));
+    r->logged = BENCH_SINK_ENTRIES;
+    wipe_log_dir();
+    if (dlogger_init() != ESP_OK) return false;
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    // A small, non-blocking send buffer so the stall fills it quickly
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        dlogger_deinit();
+        return false;
+    }
+    int sndbuf = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+    dlogger_sink_handle_t stream = NULL, memory = NULL;
+    bool ok = dlogger_sink_add_stream(fds[0], "bench_stream", &stream) == ESP_OK &&
+              dlogger_sink_add_memory(BENCH_SINK_TAIL, "bench_tail", &memory) == ESP_OK;
+    static sink_peer_t peer;
+    memset(&peer, 0, sizeof(peer));
+    peer.fd = fds[1];
+
+    if (ok) {
+        // Reading phase: every line reaches the peer
+        sink_log_phase(0, r, &peer);
+        dlogger_force_flush();
+        uint64_t start = now_ns();
+        do {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            sink_peer_read(&peer);
+        } while (peer.lines < r->logged && now_ns() - start < BENCH_SINK_WAIT_MS * 1000000ull);
+        r->received = peer.lines;
+        dlogger_sink_get_stats(stream, &r->live);
+
+        // Stall phase: nobody reads; wait until the memory sink has it all
+        sink_log_phase(r->logged, r, NULL);
+        dlogger_force_flush();
+        start = now_ns();
+        do {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            dlogger_sink_get_stats(memory, &r->memory);
+        } while (r->memory.delivered < 2 * r->logged &&
+                 now_ns() - start < BENCH_SINK_WAIT_MS * 1000000ull);
+        vTaskDelay(pdMS_TO_TICKS(200));   // Let the stream sink hit the full socket
+        dlogger_sink_get_stats(stream, &r->stalled);
+        dlogger_sink_get_stats(memory, &r->memory);
+
+        dlogger_entry_t newest;
+        char expected[32];
+        snprintf(expected, sizeof(expected), "bench sink %u", (unsigned)(2 * r->logged - 1));
+        r->tail_current = dlogger_sink_memory_read(memory, &newest, 1) == 1 &&
+                          strstr(newest.message, expected) != NULL;
+    }
+
+    if (stream) dlogger_sink_remove(stream);
+    if (memory) dlogger_sink_remove(memory);
+    close(fds[0]);
+    close(fds[1]);
+    dlogger_deinit();
+
+    r->ok = ok && r->received == r->logged && r->live.lost == 0 &&
+            r->stalled.refused > r->live.refused && r->stalled.lost > 0 &&
+            r->failed == 0 && r->memory.lost == 0 && r->tail_current;
+    return ok;
+}
+
+// ============================================================================
+// CRASH RECOVERY (CHILD PROCESS)
+// ============================================================================
+
+extern char **environ;
+
+/**
+ * @brief Log entry `index` of a crash case batch: "<prefix> <index>",
+ *        ERROR (priority ring) for even, INFO (core ring) for odd indexes
+ */
+static void crash_log(const char *prefix, uint32_t index) {
+    char text[32];
+    snprintf(text, sizeof(text), "%s %u", prefix, (unsigned)index);
+    dlogger_add_entry(LOG_SOURCE_USER, (index & 1) ? LOG_LEVEL_INFO : LOG_LEVEL_ERROR, text);
+}
+
+static bool crash_scan_entry(const dlogger_entry_t *entry, void *user_ctx) {
+    crash_scan_t *scan = (crash_scan_t *)user_ctx;
+    unsigned index;
+    if (sscanf(entry->message, "bench crash a %u", &index) == 1 && index < BENCH_CRASH_ENTRIES) {
+        scan->flushed[index]++;
+        if (entry->timestamp > scan->flushed_ts) scan->flushed_ts = entry->timestamp;
+    } else if (sscanf(entry->message, "bench crash b %u", &index) == 1 &&
+               index < BENCH_CRASH_ENTRIES) {
+        scan->unflushed[index]++;
+        scan->unflushed_ts[index] = entry->timestamp;
+    }
+    return true;
+}
+
+/**
+ * @brief Count the crash case entries in the segment files
+ */
+static void crash_scan(crash_scan_t *scan) {
+    memset(scan, 0, sizeof(*scan));
+    for (int i = 0; i < CONFIG_DLOGGER_SEGMENT_COUNT; i++) {
+        char path[64];
+        snprintf(path, sizeof(path), "storage/log%d.dlog", i);
+        dlogger_read_log_file(path, crash_scan_entry, scan);
+    }
+}
+
+/**
+ * @brief Body of the crashing child
+ *
+ * Logs batch a and waits until it is in the segment files, then logs
+ * batch b and exits without dlogger_deinit(). Entry b 0 is reserved in
+ * the priority ring before the last entry of batch a and committed only
+ * after the flush, so it is stamped no later than a flushed entry yet
+ * never reached the log itself.
+ */
+static void crash_child(void) {
+    static crash_scan_t scan;
+    dlogger_reservation_t held;
+    char *text = NULL;
+    if (dlogger_init() != ESP_OK) _exit(2);
+
+    for (uint32_t i = 0; i < BENCH_CRASH_ENTRIES; i++) {
+#if !CONFIG_DLOGGER_PRIORITY_LANE_NONE
+        // Without the lane the held entry would stop its ring's drain
+        if (i == BENCH_CRASH_ENTRIES - 1) {
+            text = dlogger_reserve(LOG_SOURCE_USER, LOG_LEVEL_ERROR, 32, &held);
+        }
+#endif
+        crash_log("bench crash a", i);
+    }
+
+    dlogger_force_flush();
+    uint64_t start = now_ns();
+    uint32_t found;
+    do {
+        vTaskDelay(pdMS_TO_TICKS(5));
+        crash_scan(&scan);
+        found = 0;
+        for (uint32_t i = 0; i < BENCH_CRASH_ENTRIES; i++) found += scan.flushed[i] ? 1 : 0;
+    } while (found < BENCH_CRASH_ENTRIES && now_ns() - start < BENCH_DRAIN_MS * 1000000ull);
+    if (found < BENCH_CRASH_ENTRIES) _exit(3);
+
+    if (!text) text = dlogger_reserve(LOG_SOURCE_USER, LOG_LEVEL_ERROR, 32, &held);
+    if (!text) _exit(4);
+    dlogger_commit(&held, (size_t)snprintf(text, 32, "bench crash b 0"));
+    for (uint32_t i = 1; i < BENCH_CRASH_ENTRIES; i++) {
+        crash_log("bench crash b", i);
+    }
+    _exit(0);
+}
+
+/**
+ * @brief Crash a child process mid-run and check what the restart recovers
+ *
+ * Every entry the child logged must be in the log exactly once afterwards:
+ * batch a as flushed, batch b from the crash tail, including the entry
+ * stamped before the flush in the other ring.
+ */
+static bool run_crash_case(crash_result_t *r) {
+    memset(r, 0, sizeof(*r));
+    r->logged = 2 * BENCH_CRASH_ENTRIES;
+    wipe_log_dir();
+
+    // A fresh process: the child must not inherit this one's logger
+    char *argv[] = { "dlogger_bench", NULL };
+    pid_t pid;
+    int status;
+    setenv(BENCH_CRASH_ENV, "1", 1);
+    bool ok = posix_spawn(&pid, "/proc/self/exe", NULL, NULL, argv, environ) == 0 &&
+              waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    unsetenv(BENCH_CRASH_ENV);
+    if (!ok) return false;
+
+    static crash_scan_t before, after;
+    crash_scan(&before);
+    if (dlogger_init() != ESP_OK) return false;
+    dlogger_deinit();
+    crash_scan(&after);
+
+    for (uint32_t i = 0; i < BENCH_CRASH_ENTRIES; i++) {
+        uint8_t copies[2] = { after.flushed[i], after.unflushed[i] };
+        for (int k = 0; k < 2; k++) {
+            if (copies[k] == 0) r->missing++;
+            if (copies[k] > 1) r->duplicated++;
+        }
+        r->flushed += before.unflushed[i] ? 1 : 0;
+        r->recovered += (after.flushed[i] + after.unflushed[i]) -
+                        (before.flushed[i] + before.unflushed[i]);
+        if (after.unflushed[i] && after.unflushed_ts[i] <= after.flushed_ts) r->stamped_before++;
+    }
+
+    wipe_log_dir();
+    r->ok = r->duplicated == 0 && (r->missing == 0 || CONFIG_DLOGGER_CRASH_TAIL_KB == 0);
+    return true;
+}
+
+// ============================================================================
+// RING STRESS (PTHREADS)
+// ============================================================================
+
+/**
+ * @brief Payload of record `index` of producer `id`: "p<id> <index> " and
+ *        a filler that depends on both, 16..115 bytes
+ */
+static size_t ring_payload(uint32_t id, uint32_t index, char *out) {
+    size_t length = 16 + (index * 7 + id * 13) % 100;
+    int n = snprintf(out, length + 1, "p%u %u ", (unsigned)id, (unsigned)index);
+    for (size_t i = (size_t)n; i < length; i++) {
+        out[i] = (char)('a' + (id + index + i) % 26);
+    }
+    return length;
+}
+
+/**
+ * @brief Whether `text` (`length` bytes) is an intact payload
+ *
+ * @param id, index Set to the record's producer and index
+ */
+static bool ring_payload_check(const char *text, size_t length, uint32_t *id, uint32_t *index) {
+    unsigned p, i;
+    char expected[BENCH_MAX_SIZE + 1];
+    if (length > BENCH_MAX_SIZE || sscanf(text, "p%u %u ", &p, &i) != 2 ||
+        p >= BENCH_RING_MAX_THREADS) {
+        return false;
+    }
+    *id = p;
+    *index = i;
+    return ring_payload(p, i, expected) == length && memcmp(expected, text, length) == 0;
+}
+
+static void *ring_producer_thread(void *arg) {
+    ring_producer_t *p = (ring_producer_t *)arg;
+    char payload[BENCH_MAX_SIZE + 1];
+    for (uint32_t i = 0; i < BENCH_RING_RECORDS; i++) {
+        size_t length = ring_payload(p->id, i, payload);
+        dlogger_ring_resv_t resv;
+        while (!dlogger_ring_reserve(p->ring, length, &resv)) {
+            p->retries++;
+            sched_yield();
+        }
+        resv.rec->timestamp = i;
+        resv.rec->length = (uint16_t)length;
+        resv.rec->source = LOG_SOURCE_USER;
+        resv.rec->level = LOG_LEVEL_INFO;
+        memcpy(dlogger_rec_message(resv.rec), payload, length);
+        dlogger_rec_set_seq(resv.rec, atomic_fetch_add_explicit(p->next_seq, 1,
+                                                                memory_order_relaxed));
+        dlogger_ring_commit(p->ring, &resv);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Single consumer: takes every record in ring order and checks it
+ */
+static void *ring_consumer_thread(void *arg) {
+    ring_consumer_t *c = (ring_consumer_t *)arg;
+    ring_result_t *r = c->result;
+    for (;;) {
+        const dlogger_rec_t *rec = dlogger_ring_peek(c->ring);
+        if (!rec) {
+            if (!atomic_load(c->producing) && !dlogger_ring_peek(c->ring)) break;
+            sched_yield();
+            continue;
+        }
+        if (!dlogger_ring_take(c->ring)) continue;   // Nobody evicts here
+
+        uint32_t seq = dlogger_rec_seq(rec);
+        uint32_t id, index;
+        if (!ring_payload_check(dlogger_rec_message(rec), rec->length, &id, &index) ||
+            rec->timestamp != index) {
+            r->corrupt++;
+        } else if (index != c->next_index[id]++) {
+            r->reordered++;
+            c->next_index[id] = index + 1;
+        }
+        if (seq < r->records && c->seen[seq]++) {
+            r->duplicated++;
+        }
+        r->consumed++;
+        dlogger_ring_consume(c->ring);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Lock-free reader: copies of the newest records must be intact
+ */
+static void *ring_reader_thread(void *arg) {
+    ring_consumer_t *c = (ring_consumer_t *)arg;
+    static dlogger_entry_t entry;
+    while (atomic_load(c->producing)) {
+        dlogger_ring_read_iter_t it;
+        if (dlogger_ring_read_begin(c->ring, 32, &it)) {
+            uint32_t ts, seq;
+            while (dlogger_ring_read_peek(&it, &ts, &seq)) {
+                if (!dlogger_ring_read_take(&it, &entry)) continue;
+                uint32_t id, index;
+                c->result->reader_copies++;
+                if (!ring_payload_check(entry.message, strlen(entry.message), &id, &index)) {
+                    c->result->reader_corrupt++;
+                }
+            }
+        }
+        dlogger_ring_read_end(&it);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Race real threads through reserve/commit against one consumer
+ */
+static bool run_ring_stress(uint32_t threads, ring_result_t *r) {
+    memset(r, 0, sizeof(*r));
+    r->threads = threads;
+    r->records = (uint64_t)threads * BENCH_RING_RECORDS;
+
+    dlogger_ring_t ring = { 0 };
+    uint8_t *seen = (uint8_t *)calloc(r->records, 1);
+    if (!seen || dlogger_ring_init(&ring, BENCH_RING_SIZE) != ESP_OK) {
+        free(seen);
+        return false;
+    }
+
+    _Atomic uint32_t next_seq = 0;
+    _Atomic bool producing = true;
+    ring_producer_t producers[BENCH_RING_MAX_THREADS];
+    ring_consumer_t consumer = { .ring = &ring, .result = r, .seen = seen,
+                                 .producing = &producing };
+    pthread_t producer_ids[BENCH_RING_MAX_THREADS], consumer_id, reader_id;
+
+    uint64_t start = now_ns();
+    pthread_create(&consumer_id, NULL, ring_consumer_thread, &consumer);
+    pthread_create(&reader_id, NULL, ring_reader_thread, &consumer);
+    for (uint32_t i = 0; i < threads; i++) {
+        producers[i] = (ring_producer_t){ .ring = &ring, .id = i, .next_seq = &next_seq };
+        pthread_create(&producer_ids[i], NULL, ring_producer_thread, &producers[i]);
+    }
+    for (uint32_t i = 0; i < threads; i++) {
+        pthread_join(producer_ids[i], NULL);
+        r->reserve_retries += producers[i].retries;
+    }
+    atomic_store(&producing, false);
+    pthread_join(consumer_id, NULL);
+    pthread_join(reader_id, NULL);
+    r->records_per_s = r->records / ((now_ns() - start) / 1e9);
+
+    for (uint64_t i = 0; i < r->records; i++) {
+        if (!seen[i]) r->lost++;
+    }
+    r->ok = r->consumed == r->records && !r->lost && !r->duplicated && !r->reordered &&
+            !r->corrupt && !r->reader_corrupt;
+
+    dlogger_ring_deinit(&ring);
+    free(seen);
+    return true;
+}
+
+// ============================================================================
+// REPORT
+// ============================================================================
+
+static void report_scenario(FILE *out, const scenario_t *s, const result_t *r, bool last) {
+    fprintf(out,
+            "    {\n"
+            "      \"name\": \"%s\",\n"
+            "      \"api\": \"%s\",\n"
+            "      \"producers\": %u,\n"
+            "      \"message_bytes\": %u,\n"
+            "      \"calls\": %llu,\n"
+            "      \"burst\": %u,\n"
+            "      \"gap_ms\": %u,\n"
+            "      \"ns_per_call\": { \"p50\": %.0f, \"p99\": %.0f, \"max\": %.0f, \"mean\": %.1f },\n"
+            "      \"entries_per_s\": %.0f,\n"
+            "      \"dropped\": %llu,\n"
+            "      \"drop_rate\": %.6f,\n"
+            "      \"flush_entries_per_s\": %.0f,\n"
+            "      \"bytes_written\": %llu,\n"
+            "      \"flush_bytes_per_s\": %.0f,\n"
+            "      \"stored_bytes_per_line\": %.1f,\n"
+            "      \"drain_ms\": %.1f\n"
+            "    }%s\n",
+            s->name, (s->api == API_LOG) ? "log" : "entry", (unsigned)s->producers,
+            (unsigned)s->size, (unsigned long long)r->calls, (unsigned)s->burst,
+            (unsigned)s->gap_ms, r->p50, r->p99, r->max, r->mean, r->entries_per_s,
+            (unsigned long long)r->dropped, r->drop_rate, r->flush_entries_per_s,
+            (unsigned long long)r->bytes_written, r->flush_bytes_per_s,
+            r->stored_bytes_per_line, r->drain_ms, last ? "" : ",");
+}
+
+static void report(FILE *out, const scenario_t *scenarios, const result_t *results, size_t count,
+                   const io_result_t *io, const sink_result_t *sink,
+                   const crash_result_t *crash, const ring_result_t *ring) {
+    fprintf(out,
+            "{\n"
+            "  \"benchmark\": \"dlogger\",\n"
+            "  \"config\": {\n"
+            "    \"ring_kb\": %d,\n"
+            "    \"segment_kb\": %d,\n"
+            "    \"segments\": %d,\n"
+            "    \"deferred_format\": %s,\n"
+            "    \"compression\": %s\n"
+            "  },\n"
+            "  \"scenarios\": [\n",
+            CONFIG_DLOGGER_RING_SIZE_KB, CONFIG_DLOGGER_SEGMENT_SIZE_KB,
+            CONFIG_DLOGGER_SEGMENT_COUNT,
+#if CONFIG_DLOGGER_DEFERRED_FORMAT
+            "true",
+#else
+            "false",
+#endif
+#if CONFIG_DLOGGER_COMPRESSION
+            "true"
+#else
+            "false"
+#endif
+            );
+    for (size_t i = 0; i < count; i++) {
+        report_scenario(out, &scenarios[i], &results[i], i + 1 == count);
+    }
+    fprintf(out,
+            "  ],\n"
+            "  \"io_callback_log\": {\n"
+            "    \"calls\": %u,\n"
+            "    \"ns_per_call\": { \"p50\": %.0f, \"p99\": %.0f, \"max\": %.0f },\n"
+            "    \"durable_timeouts\": %llu\n"
+            "  },\n"
+            "  \"sink_stream\": {\n"
+            "    \"entries_per_phase\": %u,\n"
+            "    \"reading\": { \"received\": %u, \"delivered\": %zu, \"lost\": %zu, \"refused\": %zu },\n"
+            "    \"stalled\": { \"delivered\": %zu, \"lost\": %zu, \"refused\": %zu,"
+            " \"producer_failed\": %u, \"producer_max_ns\": %.0f },\n"
+            "    \"memory_tail\": { \"delivered\": %zu, \"lost\": %zu, \"current\": %s },\n"
+            "    \"ok\": %s\n"
+            "  },\n"
+            "  \"crash_recovery\": {\n"
+            "    \"logged\": %u,\n"
+            "    \"flushed_at_crash\": %u,\n"
+            "    \"recovered\": %u,\n"
+            "    \"stamped_before_flush\": %u,\n"
+            "    \"missing\": %u,\n"
+            "    \"duplicated\": %u,\n"
+            "    \"ok\": %s\n"
+            "  },\n"
+            "  \"ring_threads\": {\n"
+            "    \"threads\": %u,\n"
+            "    \"records\": %llu,\n"
+            "    \"records_per_s\": %.0f,\n"
+            "    \"lost\": %llu,\n"
+            "    \"duplicated\": %llu,\n"
+            "    \"reordered\": %llu,\n"
+            "    \"corrupt\": %llu,\n"
+            "    \"reserve_retries\": %llu,\n"
+            "    \"reader\": { \"copies\": %llu, \"corrupt\": %llu },\n"
+            "    \"ok\": %s\n"
+            "  }\n"
+            "}\n",
+            (unsigned)io->calls, io->p50, io->p99, io->max,
+            (unsigned long long)io->durable_timeouts,
+            (unsigned)sink->logged, (unsigned)sink->received, sink->live.delivered,
+            sink->live.lost, sink->live.refused, sink->stalled.delivered, sink->stalled.lost,
+            sink->stalled.refused, (unsigned)sink->failed, sink->max_ns,
+            sink->memory.delivered, sink->memory.lost, sink->tail_current ? "true" : "false",
+            sink->ok ? "true" : "false",
+            (unsigned)crash->logged, (unsigned)crash->flushed, (unsigned)crash->recovered,
+            (unsigned)crash->stamped_before, (unsigned)crash->missing,
+            (unsigned)crash->duplicated, crash->ok ? "true" : "false",
+            (unsigned)ring->threads, (unsigned long long)ring->records, ring->records_per_s,
+            (unsigned long long)ring->lost, (unsigned long long)ring->duplicated,
+            (unsigned long long)ring->reordered, (unsigned long long)ring->corrupt,
+            (unsigned long long)ring->reserve_retries, (unsigned long long)ring->reader_copies,
+            (unsigned long long)ring->reader_corrupt, ring->ok ? "true" : "false");
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+void app_main(void) {
+    // The crash case runs the bench again as the process that crashes
+    if (getenv(BENCH_CRASH_ENV)) crash_child();
+
+    // One scenario from the environment, or the default matrix
+    bool custom = false;
+    scenario_t single = {
+        .producers = env_u32("DLOGGER_BENCH_PRODUCERS", 1, &custom),
+        .size = env_u32("DLOGGER_BENCH_SIZE", 64, &custom),
+        .calls = env_u32("DLOGGER_BENCH_CALLS", 20000, &custom),
+        .burst = env_u32("DLOGGER_BENCH_BURST", 0, &custom),
+        .gap_ms = env_u32("DLOGGER_BENCH_GAP_MS", 10, &custom),
+        .api = API_ENTRY,
+    };
+    const char *api = getenv("DLOGGER_BENCH_API");
+    if (api && *api) {
+        custom = true;
+        single.api = (strcmp(api, "log") == 0) ? API_LOG : API_ENTRY;
+    }
+    if (single.producers < 1) single.producers = 1;
+    if (single.producers > BENCH_MAX_PRODUCERS) single.producers = BENCH_MAX_PRODUCERS;
+    if (single.size > BENCH_MAX_SIZE) single.size = BENCH_MAX_SIZE;
+    if (single.calls < 1) single.calls = 1;
+    if (!single.burst) single.gap_ms = 0;
+    snprintf(single.name, sizeof(single.name), "%s_%up_%ub%s",
+             (single.api == API_LOG) ? "log" : "entry", (unsigned)single.producers,
+             (unsigned)single.size, single.burst ? "_burst" : "");
+
+    const scenario_t *scenarios = custom ? &single : default_scenarios;
+    size_t count = custom ? 1 : sizeof(default_scenarios) / sizeof(default_scenarios[0]);
+
+    // Logs go to ./storage: run inside a fresh temporary directory
+    const char *json_name = getenv("DLOGGER_BENCH_JSON");
+    char json_path[512];
+    char cwd[256];
+    if (!getcwd(cwd, sizeof(cwd))) strcpy(cwd, ".");
+    snprintf(json_path, sizeof(json_path), "%s%s%s",
+             (json_name && json_name[0] == '/') ? "" : cwd,
+             (json_name && json_name[0] == '/') ? "" : "/",
+             (json_name && *json_name) ? json_name : "dlogger_bench.json");
+
+    char tmp[] = "/tmp/dlogger_bench.XXXXXX";
+    if (!mkdtemp(tmp) || chdir(tmp) != 0 || mkdir("storage", 0755) != 0) {
+        fprintf(stderr, "dlogger_bench: cannot set up a temporary log directory\n");
+        exit(1);
+    }
+
+    result_t *results = (result_t *)calloc(count, sizeof(result_t));
+    for (size_t i = 0; i < count; i++) {
+        if (!results || !run_scenario(&scenarios[i], &results[i])) {
+            fprintf(stderr, "dlogger_bench: scenario %s failed\n", scenarios[i].name);
+            exit(1);
+        }
+    }
+    static io_result_t io;
+    if (!run_io_callback_case(&io)) {
+        fprintf(stderr, "dlogger_bench: io callback case failed\n");
+        exit(1);
+    }
+    static sink_result_t sink;
+    if (!run_sink_case(&sink)) {
+        fprintf(stderr, "dlogger_bench: sink case failed\n");
+        exit(1);
+    }
+    static crash_result_t crash;
+    if (!run_crash_case(&crash)) {
+        fprintf(stderr, "dlogger_bench: crash case failed\n");
+        exit(1);
+    }
+    bool threads_set = false;
+    uint32_t threads = env_u32("DLOGGER_BENCH_RING_THREADS", BENCH_RING_THREADS, &threads_set);
+    if (threads < 1) threads = 1;
+    if (threads > BENCH_RING_MAX_THREADS) threads = BENCH_RING_MAX_THREADS;
+    static ring_result_t ring;
+    if (!run_ring_stress(threads, &ring)) {
+        fprintf(stderr, "dlogger_bench: ring case failed\n");
+        exit(1);
+    }
+
+    FILE *out = fopen(json_path, "w");
+    if (out) {
+        report(out, scenarios, results, count, &io, &sink, &crash, &ring);
+        fclose(out);
+    }
+    report(stdout, scenarios, results, count, &io, &sink, &crash, &ring);
+    fflush(stdout);
+
+    wipe_log_dir();
+    rmdir("storage");
+    chdir(cwd);
+    rmdir(tmp);
+    free(results);
+    exit((out && io.durable_timeouts == 0 && sink.ok && crash.ok && ring.ok) ? 0 : 1);
+}
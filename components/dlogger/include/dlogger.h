@@ -3,6 +3,7 @@
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,27 +38,151 @@ typedef enum {
     LOG_LEVEL_COUNT = 4
 } dlogger_level_t;
 
+#define DLOGGER_SOURCE_BIT(source)  (1u << (source))   ///< dlogger_query() source_mask bit
+#define DLOGGER_LEVEL_BIT(level)    (1u << (level))    ///< dlogger_query() level_mask bit
+#define DLOGGER_MASK_ALL            0xFFFFFFFFu        ///< Match every source / level
+
+#define DLOGGER_MESSAGE_MAX  187   ///< Longest message in bytes, without the terminator
+
 /**
  * @brief Raw log entry structure (196 bytes total)
  * 
- * This is the pure data structure stored in buffers and files.
- * No formatting or UI-specific fields.
+ * This is the pure data structure handed out by the read APIs.
+ * No formatting or UI-specific fields. Internally entries are stored
+ * packed (8-byte header + message bytes), not in this fixed layout.
  */
 typedef struct {
     uint32_t timestamp;      ///< Milliseconds since boot (esp_timer_get_time() / 1000)
     uint8_t source;          ///< dlogger_source_t value (0=ESP, 1=LVGL, 2=USER)
     uint8_t level;           ///< dlogger_level_t value (0=ERROR, 1=WARN, 2=INFO, 3=DEBUG)
-    char message[188];       ///< Raw log message (null-terminated)
+    char message[DLOGGER_MESSAGE_MAX + 1];   ///< Raw log message (null-terminated)
 } dlogger_entry_t;
 
+/**
+ * @brief Callback invoked for each decoded entry when reading persisted logs
+ * 
+ * @param entry Decoded entry (only valid during the call)
+ * @param user_ctx User pointer passed through from the read call
+ * @return true to continue, false to stop iterating
+ */
+typedef bool (*dlogger_entry_cb_t)(const dlogger_entry_t *entry, void *user_ctx);
+
+/**
+ * @brief Zero-copy view of a buffered entry (see dlogger_read_spans())
+ */
+typedef struct {
+    uint32_t timestamp;      ///< Milliseconds since boot
+    uint32_t seq;            ///< Entry sequence number (unique, increasing in commit order)
+    uint8_t source;          ///< dlogger_source_t value
+    uint8_t level;           ///< dlogger_level_t value
+    uint16_t length;         ///< Message length in bytes
+    const char *message;     ///< Message bytes, NOT null-terminated; valid during the callback only
+} dlogger_span_t;
+
+/**
+ * @brief Callback invoked for each span by dlogger_read_spans()
+ * 
+ * @param span Entry view (only valid during the call)
+ * @param user_ctx User pointer passed through from the read call
+ * @return true to continue, false to stop iterating
+ */
+typedef bool (*dlogger_span_cb_t)(const dlogger_span_t *span, void *user_ctx);
+
+/**
+ * @brief Read position for dlogger_read_since()
+ * 
+ * Zero-initialize (DLOGGER_CURSOR_INIT) before the first call; afterwards
+ * each call returns only entries committed since the previous one.
+ */
+typedef struct {
+    uint32_t seq;            ///< Sequence number of the last entry returned (0 = none yet)
+    bool gap;                ///< Last call skipped entries (overwritten, or beyond max_entries)
+    uint32_t priv[4];        ///< Per-ring resume positions, do not modify
+} dlogger_cursor_t;
+
+#define DLOGGER_CURSOR_INIT  { 0 }
+
+/**
+ * @brief Entry filter for dlogger_read_spans_filtered() and dlogger_read_since()
+ * 
+ * Applied inside the ring walk, so non-matching entries are neither
+ * copied nor rendered and do not count toward `max_entries`.
+ */
+typedef struct {
+    uint32_t source_mask;    ///< DLOGGER_SOURCE_BIT() of each source to include
+    uint32_t level_mask;     ///< DLOGGER_LEVEL_BIT() of each level to include
+    const char *tag;         ///< ESP log tag to match exactly, or NULL for any entry
+} dlogger_filter_t;
+
+#define DLOGGER_FILTER_ALL  { DLOGGER_MASK_ALL, DLOGGER_MASK_ALL, NULL }
+
+/**
+ * @brief Zero-copy write reservation (see dlogger_reserve())
+ */
+typedef struct {
+    char *message;           ///< Write the message here (no null terminator needed)
+    size_t capacity;         ///< Bytes available at `message`
+    struct {
+        void *rec;
+        uint32_t pos;
+        uint32_t start;
+        uint32_t end;
+        uint32_t ring;
+        uint32_t begin;
+    } priv;                  ///< Internal ring bookkeeping, do not modify
+} dlogger_reservation_t;
+
+#define DLOGGER_STATS_BUCKETS  12   ///< Histogram buckets in dlogger_stats_t
+
 /**
  * @brief Buffer statistics structure
+ *
+ * Counters accumulate from boot. Histogram bucket i counts samples below
+ * 256 << i (ns for enqueues, µs for flushes); the last bucket takes the rest.
  */
 typedef struct {
-    size_t entries_in_buffer;  ///< Number of entries currently in active buffer
-    bool flush_pending;        ///< Whether a buffer flush is pending
-    uint8_t active_buffer;     ///< Which buffer is active (0 or 1)
-    size_t total_capacity;     ///< Total buffer capacity in entries
+    size_t bytes_in_buffer;    ///< Packed record bytes in the ring not yet flushed
+    bool flush_pending;        ///< Whether the flush task has entries to write
+    size_t total_capacity;     ///< Total ring capacity in bytes
+    size_t isr_dropped;        ///< ISR entries lost because a per-core ISR ring was full
+    size_t dropped;            ///< New entries lost because their ring was full
+    size_t evicted;            ///< Unflushed entries evicted (DROP_OLDEST policy)
+    size_t priority_dropped;   ///< DEBUG/INFO entries refused to keep room for WARN/ERROR
+    size_t priority_evicted;   ///< Unflushed DEBUG/INFO entries evicted for WARN/ERROR
+    size_t blocked;            ///< Producers that waited for room (CONFIG_DLOGGER_OVERFLOW_BLOCK_MS)
+    size_t block_timeouts;     ///< Waits that ended without room
+    size_t spilled;            ///< Entries stored in the overflow ring
+    size_t storm_suppressed;   ///< Repeated copies collapsed by storm suppression
+    size_t storm_summaries;    ///< "repeated N times" records stored in their place
+    size_t console_dropped;    ///< ESP log lines left off the console (queue full), still logged
+    size_t tag_filtered;       ///< ESP log lines discarded by dlogger_set_tag_level()
+    size_t durable_syncs;      ///< Priority-lane drains synced to flash
+    size_t durable_failures;   ///< Priority-lane syncs that failed (store not open or I/O error)
+    size_t durable_timeouts;   ///< Priority-level callers that stopped waiting for the sync
+    
+    // Per dlogger_source_t / dlogger_level_t (storm-suppressed and tag-filtered lines excluded)
+    size_t entries[LOG_SOURCE_COUNT][LOG_LEVEL_COUNT];          ///< Entries stored in a ring
+    size_t entries_dropped[LOG_SOURCE_COUNT][LOG_LEVEL_COUNT];  ///< Entries refused (dropped + priority_dropped)
+    
+    // Enqueue latency: reserve, copy and commit, including overflow and priority-lane waits
+    size_t enqueue_ns_hist[DLOGGER_STATS_BUCKETS];  ///< Needs CONFIG_DLOGGER_STATS_TIMING
+    uint32_t enqueue_ns_max;
+    
+    // Flushes: drains that wrote at least one block (duration includes the priority-lane sync)
+    size_t flushes;
+    size_t flush_us_hist[DLOGGER_STATS_BUCKETS];
+    uint32_t flush_us_last;
+    uint32_t flush_us_max;
+    uint32_t flush_bytes_last; ///< Block bytes (compressed) written by the last flush
+    uint32_t flush_bytes_max;
+    uint64_t bytes_written;    ///< Block bytes written to the segments
+    size_t write_errors;       ///< Blocks lost to a store that would not open or a failed write
+    
+    // High-water marks (unflushed bytes)
+    size_t ring_capacity;      ///< Bytes per core ring
+    size_t ring_peak;          ///< Most bytes ever pending in one core ring
+    size_t spill_peak;         ///< Overflow ring (CONFIG_DLOGGER_OVERFLOW_SPILL_KB)
+    size_t priority_peak;      ///< Priority ring (CONFIG_DLOGGER_PRIORITY_LANE)
 } dlogger_stats_t;
 
 // ============================================================================
@@ -65,7 +190,10 @@ typedef struct {
 // ============================================================================
 
 /**
- * @brief Initialize the double buffer logging system
+ * @brief Initialize the ring buffer logging system
+ * 
+ * Log calls never block: producers reserve ring slots with atomic
+ * operations and a single background flush task drains them to file.
  * 
  * @return ESP_OK on success, error code on failure
  */
@@ -84,7 +212,11 @@ esp_err_t dlogger_log(const char *format, ...);
  * @brief Get raw log entries from buffer (most recent first)
  * 
  * This is the primary data access API. Returns raw log entries
- * in reverse chronological order (newest first).
+ * in reverse chronological order (newest first) from one stream: the
+ * unflushed and flushed entries still in the ring, then the RAM cache of
+ * flushed entries (CONFIG_DLOGGER_CACHE_KB) once the ring has reused
+ * their space. Lock-free: entries that are overwritten while being
+ * copied are skipped.
  * 
  * @param dest Destination array for log entries
  * @param max_entries Maximum number of entries to copy
@@ -92,20 +224,102 @@ esp_err_t dlogger_log(const char *format, ...);
  */
 size_t dlogger_get_raw_entries(dlogger_entry_t *dest, size_t max_entries);
 
+/**
+ * @brief Visit the newest buffered entries in place (most recent first)
+ * 
+ * Zero-copy counterpart of dlogger_get_raw_entries(): each span points
+ * straight into the ring (or into a private copy of a cache page for
+ * entries the ring no longer holds). While this runs, producers cannot overwrite the
+ * visited entries and may drop new ones if the ring is full, so keep the
+ * callback short and do not log from it.
+ * 
+ * @param max_entries Maximum number of entries to visit
+ * @param callback Called once per entry
+ * @param user_ctx Passed through to callback
+ * @return Number of entries visited
+ */
+size_t dlogger_read_spans(size_t max_entries, dlogger_span_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Visit the newest buffered entries that pass `filter` (most recent first)
+ * 
+ * Like dlogger_read_spans(), but returns the newest `max_entries`
+ * matching entries however many others were logged after them. Flushed
+ * entries are matched on a per-entry metadata byte without reading the
+ * ring; a tag filter only matches ESP log entries.
+ * 
+ * @param filter Entries to visit (NULL = all)
+ * @param max_entries Maximum number of entries to visit
+ * @param callback Called once per entry
+ * @param user_ctx Passed through to callback
+ * @return Number of entries visited
+ */
+size_t dlogger_read_spans_filtered(const dlogger_filter_t *filter, size_t max_entries,
+                                   dlogger_span_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Visit the buffered entries added since the last call (oldest first)
+ * 
+ * Incremental counterpart of dlogger_read_spans() for views that append
+ * rows instead of rebuilding: the cursor remembers where each core ring
+ * was left, so every entry is returned exactly once even when the cores
+ * commit out of order. If more than `max_entries` entries are new, only
+ * the newest are returned and `cursor->gap` is set (as it is when entries
+ * were overwritten before being read). Stopping early from the callback
+ * leaves the remaining entries for the next call. Same restrictions as
+ * dlogger_read_spans() apply to the callback.
+ * 
+ * With a filter, entries that do not match are passed over for good (the
+ * cursor moves past them) and never cause a gap.
+ * 
+ * @param cursor Read position, updated on return
+ * @param filter Entries to visit (NULL = all)
+ * @param max_entries Maximum number of entries to visit
+ * @param callback Called once per entry
+ * @param user_ctx Passed through to callback
+ * @return Number of entries visited
+ */
+size_t dlogger_read_since(dlogger_cursor_t *cursor, const dlogger_filter_t *filter,
+                          size_t max_entries, dlogger_span_cb_t callback, void *user_ctx);
+
 /**
  * @brief Get current buffer statistics
  * 
+ * Lock-free: every field is a plain counter read, cheap enough to poll
+ * from the UI.
+ * 
  * @param stats Pointer to stats structure to fill
  */
 void dlogger_get_stats(dlogger_stats_t *stats);
 
+/**
+ * @brief Log a summary of dlogger_get_stats() (ESP_LOGI, so it reaches the
+ *        console and the log)
+ */
+void dlogger_log_stats(void);
+
 /**
  * @brief Manually trigger a buffer flush
  * 
- * @return ESP_OK on success, ESP_ERR_INVALID_STATE if flush already pending
+ * Wakes the flush task immediately instead of waiting for the next interval.
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if nothing is pending
  */
 esp_err_t dlogger_force_flush(void);
 
+/**
+ * @brief Write and fsync every entry committed so far, then return
+ *
+ * For code about to reset or power down: log the reason, then call this.
+ * Logging itself never waits for flash (priority-level entries only wake
+ * the flush task, see CONFIG_DLOGGER_PRIORITY_WAIT_MS). Not from an
+ * interrupt, the flush task or a storage I/O completion callback.
+ *
+ * @return ESP_OK, ESP_ERR_TIMEOUT after `timeout_ms`, ESP_FAIL if the
+ *         sync failed, or ESP_ERR_INVALID_STATE if it cannot wait here
+ */
+esp_err_t dlogger_sync(uint32_t timeout_ms);
+
 /**
  * @brief Hook into ESP-IDF logging system
  * 
@@ -113,6 +327,24 @@ esp_err_t dlogger_force_flush(void);
  */
 void dlogger_hook_esp_log(void);
 
+/**
+ * @brief Set the runtime level of an ESP log tag
+ *
+ * Hooked ESP logs of `tag` less severe than `level` are discarded before
+ * they are formatted: they are neither stored nor printed, and cost a tag
+ * lookup. "*" sets the level of every tag without its own (default
+ * LOG_LEVEL_DEBUG, i.e. everything the ESP-IDF log level lets through).
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NO_MEM if the tag table
+ *         (CONFIG_DLOGGER_TAG_SLOTS) is full
+ */
+esp_err_t dlogger_set_tag_level(const char *tag, dlogger_level_t level);
+
+/**
+ * @brief Runtime level of an ESP log tag (see dlogger_set_tag_level())
+ */
+dlogger_level_t dlogger_get_tag_level(const char *tag);
+
 /**
  * @brief Add a raw log entry from any source
  * 
@@ -126,12 +358,243 @@ void dlogger_hook_esp_log(void);
 esp_err_t dlogger_add_entry(dlogger_source_t source, dlogger_level_t level, const char *message);
 
 /**
- * @brief Get current log file path
+ * @brief Add a log entry from an interrupt handler (or any context)
+ * 
+ * Wait-free and IRAM-safe: the entry is timestamped and staged in a small
+ * per-core ring in internal RAM, and the flush task merges it into the
+ * main stream by timestamp. Usable from ISRs registered with
+ * ESP_INTR_FLAG_IRAM and from high-priority timer callbacks.
+ * 
+ * @param source The log source (ESP, LVGL, USER)
+ * @param level The log level (ERROR, WARN, INFO, DEBUG)
+ * @param message The log message string (truncated to 52 bytes)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if this core's ISR ring is full
+ */
+esp_err_t dlogger_add_entry_from_isr(dlogger_source_t source, dlogger_level_t level,
+                                     const char *message);
+
+/**
+ * @brief Reserve room for a message directly in the ring (zero-copy)
+ * 
+ * The caller writes up to `len` bytes to the returned pointer and then
+ * publishes them with dlogger_commit(). The entry is admitted like one
+ * from dlogger_add_entry() with the same source and level (priority lane,
+ * overflow policy, drop counters). Every successful reservation must be
+ * committed promptly: later entries are not flushed until it is.
+ * 
+ * @param source The log source (ESP, LVGL, USER)
+ * @param level The log level (ERROR, WARN, INFO, DEBUG)
+ * @param len Message bytes to reserve (at most DLOGGER_MESSAGE_MAX)
+ * @param resv Reservation to fill
+ * @return Pointer to write the message to, or NULL if the entry is dropped
+ */
+char *dlogger_reserve(dlogger_source_t source, dlogger_level_t level, size_t len,
+                      dlogger_reservation_t *resv);
+
+/**
+ * @brief Publish a reservation made with dlogger_reserve()
+ * 
+ * The written bytes go through storm suppression; a suppressed entry is
+ * discarded like one committed with `len` 0.
+ * 
+ * @param resv Reservation to publish
+ * @param len Bytes actually written (<= capacity); 0 discards the entry
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if `resv` is not pending
+ */
+esp_err_t dlogger_commit(dlogger_reservation_t *resv, size_t len);
+
+/**
+ * @brief Get the path of the active log segment
+ * 
+ * Logs rotate through CONFIG_DLOGGER_SEGMENT_COUNT fixed-size segment
+ * files; the returned path changes whenever a new segment is started.
  * 
- * @return Path to current log file
+ * @return Path to the segment currently being written
  */
 const char* dlogger_get_current_log_filepath(void);
 
+/**
+ * @brief Read a persisted (binary) log segment
+ * 
+ * Segments hold CRC-protected blocks of length-prefixed binary records.
+ * This decodes them in file order, stopping at a torn block or at data
+ * left over from the segment's previous use.
+ * 
+ * @param path Segment path (e.g. dlogger_get_current_log_filepath())
+ * @param callback Called once per entry
+ * @param user_ctx Passed through to callback
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the file cannot be opened
+ */
+esp_err_t dlogger_read_log_file(const char *path, dlogger_entry_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Query persisted logs by time range, source and level
+ * 
+ * A sparse in-RAM index (time range and source/level summary per 4 KB of
+ * each segment) selects the blocks that can match, so only those are read
+ * from flash. Entries are delivered oldest first. Covers entries persisted
+ * since boot (timestamps restart at every boot); entries still buffered in
+ * RAM are not included until the next flush.
+ * 
+ * Example, errors of the last 10 minutes:
+ *   dlogger_query(now - 600000, now, DLOGGER_MASK_ALL,
+ *                 DLOGGER_LEVEL_BIT(LOG_LEVEL_ERROR), cb, ctx);
+ * 
+ * @param t_from Oldest timestamp in ms since boot (inclusive)
+ * @param t_to Newest timestamp in ms since boot (inclusive)
+ * @param source_mask DLOGGER_SOURCE_BIT() of each source to include
+ * @param level_mask DLOGGER_LEVEL_BIT() of each level to include
+ * @param callback Called once per matching entry
+ * @param user_ctx Passed through to callback
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE before init,
+ *         or ESP_ERR_NO_MEM
+ */
+esp_err_t dlogger_query(uint32_t t_from, uint32_t t_to, uint32_t source_mask,
+                        uint32_t level_mask, dlogger_entry_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Render an entry as one text line ("<ms> [SRC][L] message")
+ * 
+ * For exporting persisted logs; nothing on the logging path formats text.
+ * 
+ * @param entry Entry to render
+ * @param buf Destination buffer
+ * @param buf_len Size of destination buffer
+ * @return Number of characters that would have been written (snprintf semantics)
+ */
+int dlogger_entry_to_text(const dlogger_entry_t *entry, char *buf, size_t buf_len);
+
+// ============================================================================
+// SINKS - EXTRA OUTPUTS WITH THEIR OWN PACE
+// ============================================================================
+
+/**
+ * @brief Delivers a batch of entries to a sink (see dlogger_sink_add())
+ * 
+ * Called from the sink's own task, oldest entry first. May block; only
+ * this sink waits.
+ * 
+ * @return ESP_OK once the batch is taken; an error marks the batch refused
+ *         and the sink's policy decides what happens to it
+ */
+typedef esp_err_t (*dlogger_sink_write_t)(const dlogger_entry_t *entries, size_t count,
+                                          void *user_ctx);
+
+/**
+ * @brief What a sink does with a batch its write refused
+ */
+typedef enum {
+    DLOGGER_SINK_RETRY = 0,  ///< Retry the batch after retry_ms; entries recycled meanwhile are lost
+    DLOGGER_SINK_DROP,       ///< Drop the batch (counted as lost) and go on with newer entries
+} dlogger_sink_policy_t;
+
+/**
+ * @brief Sink configuration (start from DLOGGER_SINK_CONFIG_DEFAULT())
+ */
+typedef struct {
+    const char *name;              ///< Name of the sink's task
+    dlogger_sink_write_t write;
+    void *user_ctx;                ///< Passed to `write`
+    uint32_t source_mask;          ///< DLOGGER_SOURCE_BIT() of each source to deliver
+    uint32_t level_mask;           ///< DLOGGER_LEVEL_BIT() of each level to deliver
+    size_t batch_max;              ///< Entries per write at most
+    uint32_t batch_ms;             ///< Longest an entry waits for its batch to fill
+    uint32_t retry_ms;             ///< Pause after a refused write
+    dlogger_sink_policy_t policy;
+    uint32_t stack_size;           ///< Sink task stack (bytes)
+    uint32_t priority;             ///< Sink task priority
+} dlogger_sink_config_t;
+
+#define DLOGGER_SINK_CONFIG_DEFAULT(write_fn, ctx) {                          \
+    .name = "dlogger_sink", .write = (write_fn), .user_ctx = (ctx),          \
+    .source_mask = DLOGGER_MASK_ALL, .level_mask = DLOGGER_MASK_ALL,         \
+    .batch_max = 16, .batch_ms = 100, .retry_ms = 100,                       \
+    .policy = DLOGGER_SINK_RETRY, .stack_size = 3072, .priority = 1 }
+
+typedef struct dlogger_sink *dlogger_sink_handle_t;
+
+/**
+ * @brief Per-sink counters (see dlogger_sink_get_stats())
+ */
+typedef struct {
+    size_t delivered;        ///< Entries taken by `write`
+    size_t lost;             ///< Entries recycled before the sink read them, or dropped with a refused batch
+    size_t refused;          ///< Refused writes
+    size_t batches;          ///< Successful writes
+} dlogger_sink_stats_t;
+
+/**
+ * @brief Start delivering entries to an extra sink
+ * 
+ * The segment files stay the primary output. Each sink follows the RAM
+ * cache of flushed entries (CONFIG_DLOGGER_CACHE_KB) through its own
+ * cursor from its own task, starting with the entries flushed after this
+ * call, so it sees entries once the flush task has drained them. A slow or
+ * stalled sink never blocks producers, the flush task or other sinks: it
+ * falls behind and loses only the entries the cache recycles before it
+ * reads them (counted in its stats).
+ * 
+ * @param config Sink configuration (copied)
+ * @param out Receives the sink handle
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE before init,
+ *         ESP_ERR_NOT_SUPPORTED without the cache or with
+ *         CONFIG_DLOGGER_SINK_SLOTS = 0, or ESP_ERR_NO_MEM (also when all
+ *         slots are taken)
+ */
+esp_err_t dlogger_sink_add(const dlogger_sink_config_t *config, dlogger_sink_handle_t *out);
+
+/**
+ * @brief Deliver what is pending once more, stop the sink and free it
+ * 
+ * Sinks still registered at dlogger_deinit() are removed there.
+ * 
+ * @return ESP_OK, ESP_ERR_INVALID_ARG or ESP_ERR_NOT_FOUND
+ */
+esp_err_t dlogger_sink_remove(dlogger_sink_handle_t sink);
+
+/**
+ * @brief Read a sink's counters
+ */
+esp_err_t dlogger_sink_get_stats(dlogger_sink_handle_t sink, dlogger_sink_stats_t *stats);
+
+/**
+ * @brief Stream sink: every entry as a text line to a file descriptor
+ * 
+ * For sockets, pipes and similar streams. Give a non-blocking descriptor:
+ * while it is full, batches are dropped (DLOGGER_SINK_DROP) instead of
+ * stalling the sink. A batch the descriptor takes in part is finished
+ * before the next one, so lines are never cut or repeated.
+ * The descriptor is not closed by dlogger_sink_remove().
+ * 
+ * @param fd Descriptor to write to
+ * @param name Task name, or NULL
+ */
+esp_err_t dlogger_sink_add_stream(int fd, const char *name, dlogger_sink_handle_t *out);
+
+/**
+ * @brief Memory sink: the newest `capacity` entries kept in RAM
+ * 
+ * An in-memory tail for a shell command or a status page, fed like any
+ * other sink (so it lags the rings by a flush). Read it with
+ * dlogger_sink_memory_read().
+ * 
+ * @param capacity Entries kept (about 200 bytes each)
+ * @param name Task name, or NULL
+ */
+esp_err_t dlogger_sink_add_memory(size_t capacity, const char *name, dlogger_sink_handle_t *out);
+
+/**
+ * @brief Copy the newest entries of a memory sink (most recent first)
+ * 
+ * Lock-free: the sink task never waits for readers, and entries it
+ * overwrites during the copy are left out.
+ * 
+ * @param sink A sink made by dlogger_sink_add_memory()
+ * @return Number of entries written to `dest` (0 for other sinks)
+ */
+size_t dlogger_sink_memory_read(dlogger_sink_handle_t sink, dlogger_entry_t *dest,
+                                size_t max_entries);
+
 /**
  * @brief Deinitialize logging system and free resources
  * 
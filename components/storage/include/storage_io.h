@@ -0,0 +1,125 @@
+#pragma once
+
+/**
+ * @file storage_io.h
+ * @brief Asynchronous write-behind I/O service for the storage partition
+ *
+ * Writers hand their bytes to one I/O task instead of doing blocking stdio
+ * on /storage from their own tasks, so SPIFFS erase and garbage-collection
+ * pauses land on that task alone. Requests are carried out in the order
+ * they were submitted:
+ *
+ * - Appends and offset writes copy the data and return at once. A write
+ *   that continues the last queued write to the same file (and has no
+ *   callback, or the same one) is merged into it, so a run of small
+ *   appends becomes a single write().
+ * - A barrier completes once every request submitted before it is done
+ *   (and the open file fsynced, if asked): writers use it to wait for
+ *   durability or for their data to be readable.
+ * - Completion callbacks run on the I/O task; keep them short and never
+ *   wait for the service from one.
+ *
+ * Submitting blocks while CONFIG_STORAGE_IO_QUEUE_KB of data is queued, so
+ * a slow partition slows its writers down instead of exhausting RAM.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define STORAGE_IO_PATH_MAX       64    ///< Longest file path, including the terminator
+#define STORAGE_IO_STATS_BUCKETS  12    ///< Latency histogram buckets
+
+/**
+ * @brief Completion callback (runs on the I/O task)
+ *
+ * @param result ESP_OK, or ESP_FAIL if the request (for a barrier: any
+ *               request since the previous barrier) could not be written
+ */
+typedef void (*storage_io_done_cb_t)(esp_err_t result, void *user_ctx);
+
+/**
+ * @brief I/O service counters (see storage_io_get_stats())
+ *
+ * Histogram bucket i counts requests that took less than 256 µs << i; the
+ * last bucket takes the rest.
+ */
+typedef struct {
+    uint32_t requests;          ///< Writes and barriers submitted
+    uint32_t coalesced;         ///< Writes merged into the one queued before them
+    uint32_t writes;            ///< write() calls made by the I/O task
+    uint32_t syncs;             ///< fsync() calls made by the I/O task
+    uint32_t errors;            ///< Failed opens, writes and fsyncs
+    uint32_t stalls;            ///< Submits that waited for queue space
+    uint64_t bytes;             ///< Bytes written
+    uint32_t queued_bytes;      ///< Data waiting right now
+    uint32_t queued_peak;       ///< Most data ever waiting
+    uint32_t latency_us_hist[STORAGE_IO_STATS_BUCKETS];   ///< Submit to completion
+    uint32_t latency_us_max;
+    uint32_t service_us_hist[STORAGE_IO_STATS_BUCKETS];   ///< Time the I/O task spent on it
+    uint32_t service_us_max;
+} storage_io_stats_t;
+
+/**
+ * @brief Start the I/O task (does nothing if it is already running)
+ *
+ * storage_init() calls it once the partition is mounted; components that
+ * write without storage_init() (host builds) may call it themselves.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t storage_io_init(void);
+
+/**
+ * @brief Carry out every queued request, then stop the I/O task
+ */
+void storage_io_deinit(void);
+
+/**
+ * @brief Queue `len` bytes to be appended to `path` (created if missing)
+ *
+ * @param done Called once the bytes are written, may be NULL
+ * @return ESP_OK once queued, ESP_ERR_INVALID_STATE if the service is not
+ *         running, ESP_ERR_INVALID_SIZE if `len` exceeds the queue, or
+ *         ESP_ERR_NO_MEM
+ */
+esp_err_t storage_io_append(const char *path, const void *data, size_t len,
+                            storage_io_done_cb_t done, void *user_ctx);
+
+/**
+ * @brief Queue `len` bytes to be written to `path` at `offset`
+ *
+ * Same as storage_io_append() for an in-place write (preallocated files).
+ */
+esp_err_t storage_io_write_at(const char *path, uint32_t offset, const void *data, size_t len,
+                              storage_io_done_cb_t done, void *user_ctx);
+
+/**
+ * @brief Queue a barrier: `done` runs after every request submitted before it
+ *
+ * @param sync Also fsync the file the I/O task has open (files it closed
+ *             were synced when they were closed)
+ * @param done Called with ESP_FAIL if anything failed since the previous barrier
+ */
+esp_err_t storage_io_barrier(bool sync, storage_io_done_cb_t done, void *user_ctx);
+
+/**
+ * @brief Queue a barrier and wait for it (not from the I/O task)
+ *
+ * @return The barrier's result, or an error from queuing it
+ */
+esp_err_t storage_io_drain(bool sync);
+
+/**
+ * @brief Whether the caller is the I/O task (completion callbacks run there)
+ *
+ * Code that may wait for queued requests, directly or through another
+ * task that drains the service, checks this and does not wait.
+ */
+bool storage_io_in_service_task(void);
+
+/**
+ * @brief Copy the service counters (lock-free, cheap enough to poll)
+ */
+void storage_io_get_stats(storage_io_stats_t *stats);
@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+ * @file storage_settings.h
+ * @brief Typed key-value settings with a RAM cache and debounced commits
+ *
+ * All settings live in RAM: reads never touch flash, and a write only
+ * updates the cache and wakes a low-priority settings task. Once values stop
+ * changing for CONFIG_STORAGE_SETTINGS_DEBOUNCE_MS (or at the latest
+ * CONFIG_STORAGE_SETTINGS_MAX_DELAY_MS after the first change), the whole
+ * table is committed in one write through the storage I/O service, so
+ * dragging a slider costs one flash write, not one per step.
+ *
+ * The table is kept in two slots of settings.bin on the storage
+ * partition. A commit rewrites the older slot, with a CRC and a sequence
+ * number, and fsyncs it; boot reads the file in one go and keeps the
+ * newest intact slot, so a commit torn by a reset falls back to the
+ * previous one instead of losing every setting.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define STORAGE_SETTINGS_KEY_MAX  16    ///< Key length including the terminator (as NVS)
+#define STORAGE_SETTINGS_STR_MAX  32    ///< String value length including the terminator
+#define STORAGE_SETTINGS_MAX_KEYS 39    ///< Settings that fit in one 2 KB slot
+
+/**
+ * @brief Load every setting with a single read of settings.bin
+ *
+ * storage_init() calls it after mounting the partition (host builds call
+ * it themselves). Missing or damaged files start an empty table.
+ *
+ * @return ESP_OK (also when nothing was stored yet), or ESP_ERR_NO_MEM
+ */
+esp_err_t storage_settings_init(void);
+
+/**
+ * @brief Read an unsigned setting from the cache
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_ARG if the key holds
+ *         another type, or ESP_ERR_INVALID_STATE before storage_settings_init()
+ */
+esp_err_t storage_settings_get_u32(const char *key, uint32_t *value);
+
+/**
+ * @brief Read a signed setting from the cache (see storage_settings_get_u32())
+ */
+esp_err_t storage_settings_get_i32(const char *key, int32_t *value);
+
+/**
+ * @brief Copy a string setting from the cache (see storage_settings_get_u32())
+ *
+ * @return ESP_ERR_INVALID_SIZE if `buf` is shorter than the value
+ */
+esp_err_t storage_settings_get_str(const char *key, char *buf, size_t len);
+
+/**
+ * @brief Store an unsigned setting; committed to flash after the debounce
+ *
+ * Setting the value a key already holds does not schedule a commit.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a key that is too long,
+ *         ESP_ERR_NO_MEM if the table is full, or ESP_ERR_INVALID_STATE
+ */
+esp_err_t storage_settings_set_u32(const char *key, uint32_t value);
+
+/**
+ * @brief Store a signed setting (see storage_settings_set_u32())
+ */
+esp_err_t storage_settings_set_i32(const char *key, int32_t value);
+
+/**
+ * @brief Store a string setting (see storage_settings_set_u32())
+ *
+ * @return ESP_ERR_INVALID_SIZE if the value is STORAGE_SETTINGS_STR_MAX or longer
+ */
+esp_err_t storage_settings_set_str(const char *key, const char *value);
+
+/**
+ * @brief Remove a setting (committed like a write)
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, or ESP_ERR_INVALID_STATE
+ */
+esp_err_t storage_settings_erase(const char *key);
+
+/**
+ * @brief Commit pending changes now and wait until they are on flash
+ *
+ * For a shutdown or reset; normal writes are committed by the settings task.
+ * Not from the storage I/O task or a completion callback.
+ *
+ * @return ESP_OK, or ESP_FAIL if the commit could not be written
+ */
+esp_err_t storage_settings_commit(void);
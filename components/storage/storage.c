@@ -1,4 +1,6 @@
 #include "storage.h"
+#include "storage_io.h"
+#include "storage_settings.h"
 #include "esp_spiffs.h"
 #include "esp_log.h"
 
@@ -9,7 +11,7 @@ esp_err_t storage_init(void) {
     esp_vfs_spiffs_conf_t conf = {
         .base_path = base_path,
         .partition_label = "storage",
-        .max_files = 5,
+        .max_files = 8,   // Writers' own files plus the I/O task's and readers'
         .format_if_mount_failed = true
     };
 
@@ -22,6 +24,17 @@ esp_err_t storage_init(void) {
     size_t total = 0, used = 0;
     esp_spiffs_info(conf.partition_label, &total, &used);
     ESP_LOGI(TAG, "Partition size: total: %d, used: %d", total, used);
+
+    // Shared write-behind service (see storage_io.h)
+    ret = storage_io_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // A settings failure leaves the defaults in place, not the partition unusable
+    if (storage_settings_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Settings unavailable, using defaults");
+    }
     return ESP_OK;
 }
 
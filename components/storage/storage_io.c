@@ -0,0 +1,563 @@
+#include "storage_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#define IO_TASK_CORE      0                 // Host port only has core 0
+#else
+#include "esp_timer.h"
+#define IO_TASK_CORE      PRO_CPU_NUM       // Off the LVGL core, next to dlogger's flush task
+#endif
+
+#define IO_QUEUE_BYTES    (CONFIG_STORAGE_IO_QUEUE_KB * 1024)
+#define IO_IDLE_CLOSE_MS  CONFIG_STORAGE_IO_IDLE_CLOSE_MS
+#define IO_TASK_PRIORITY  CONFIG_STORAGE_IO_TASK_PRIORITY
+#define IO_TASK_STACK     4096
+#define IO_BUCKET_BASE_US 256               // Upper bound of histogram bucket 0
+
+static const char *TAG = "storage_io";
+
+typedef enum {
+    IO_APPEND,
+    IO_WRITE_AT,
+    IO_BARRIER,
+} io_kind_t;
+
+/**
+ * @brief Queued request (data is owned by the request)
+ */
+typedef struct io_req {
+    struct io_req *next;
+    io_kind_t kind;
+    bool sync;                      ///< Barrier: fsync the open file
+    uint32_t offset;                ///< IO_WRITE_AT: file offset of data[0]
+    uint8_t *data;
+    size_t len;
+    size_t capacity;                ///< Allocated bytes of `data` (grows when merging)
+    storage_io_done_cb_t done;
+    void *user_ctx;
+    uint32_t calls;                 ///< Times `done` is owed (one per merged write with it)
+    int64_t submitted_us;           ///< Submit time of the oldest merged write
+    char path[STORAGE_IO_PATH_MAX];
+} io_req_t;
+
+/**
+ * @brief Waiter of storage_io_drain()
+ */
+typedef struct {
+    SemaphoreHandle_t done;
+    esp_err_t result;
+} io_waiter_t;
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+// Queue, guarded by io_mutex
+static SemaphoreHandle_t io_mutex;
+static SemaphoreHandle_t io_space;          ///< Given when queued data shrinks
+static io_req_t *io_head;
+static io_req_t *io_tail;
+static size_t io_queued;                    ///< Data bytes in the queue
+static uint32_t io_space_waiters;
+static bool io_open;                        ///< Accepting requests
+
+static TaskHandle_t io_task;
+static _Atomic bool io_running;             ///< Cleared by storage_io_deinit()
+static _Atomic bool io_exited;              ///< Set by the I/O task as it ends
+
+// Owned by the I/O task
+static int io_fd = -1;
+static char io_fd_path[STORAGE_IO_PATH_MAX];
+static bool io_dirty;                       ///< Written since the last fsync
+static bool io_failed;                      ///< A write failed since the last barrier
+
+// Counters: relaxed atomics, copied by storage_io_get_stats()
+static _Atomic uint32_t stat_requests;
+static _Atomic uint32_t stat_coalesced;
+static _Atomic uint32_t stat_writes;
+static _Atomic uint32_t stat_syncs;
+static _Atomic uint32_t stat_errors;
+static _Atomic uint32_t stat_stalls;
+static _Atomic uint64_t stat_bytes;
+static _Atomic uint32_t stat_queued;
+static _Atomic uint32_t stat_queued_peak;
+static _Atomic uint32_t stat_latency_hist[STORAGE_IO_STATS_BUCKETS];
+static _Atomic uint32_t stat_latency_max;
+static _Atomic uint32_t stat_service_hist[STORAGE_IO_STATS_BUCKETS];
+static _Atomic uint32_t stat_service_max;
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+static inline int64_t io_now_us(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+/**
+ * @brief Histogram bucket of `us`: bucket i holds values below 256 << i
+ */
+static inline uint32_t io_bucket_of(uint32_t us) {
+    uint32_t scaled = us / IO_BUCKET_BASE_US;
+    uint32_t bucket = scaled ? 32 - (uint32_t)__builtin_clz(scaled) : 0;
+    return (bucket < STORAGE_IO_STATS_BUCKETS) ? bucket : STORAGE_IO_STATS_BUCKETS - 1;
+}
+
+static inline void io_store_max(_Atomic uint32_t *max, uint32_t value) {
+    uint32_t seen = atomic_load_explicit(max, memory_order_relaxed);
+    while (value > seen &&
+           !atomic_compare_exchange_weak_explicit(max, &seen, value, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+static void io_record_latency(_Atomic uint32_t *hist, _Atomic uint32_t *max, int64_t us) {
+    uint32_t value = (us < 0) ? 0 : (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+    atomic_fetch_add_explicit(&hist[io_bucket_of(value)], 1, memory_order_relaxed);
+    io_store_max(max, value);
+}
+
+// ============================================================================
+// I/O TASK
+// ============================================================================
+
+/**
+ * @brief Close the open file, syncing it first if it was written
+ *
+ * Syncing on close is what lets a barrier only sync the file still open.
+ */
+static esp_err_t io_file_close(void) {
+    if (io_fd < 0) return ESP_OK;
+
+    esp_err_t ret = ESP_OK;
+    if (io_dirty) {
+        atomic_fetch_add_explicit(&stat_syncs, 1, memory_order_relaxed);
+        if (fsync(io_fd) != 0) ret = ESP_FAIL;
+    }
+    if (close(io_fd) != 0) ret = ESP_FAIL;
+    io_fd = -1;
+    io_dirty = false;
+    return ret;
+}
+
+/**
+ * @brief Descriptor of `path`, reusing the open one (one file open at a time)
+ */
+static int io_file_get(const char *path) {
+    if (io_fd >= 0 && strcmp(io_fd_path, path) == 0) return io_fd;
+
+    if (io_file_close() != ESP_OK) {
+        io_failed = true;
+    }
+    io_fd = open(path, O_WRONLY | O_CREAT, 0644);
+    if (io_fd < 0) {
+        ESP_LOGE(TAG, "Failed to open %s (errno %d)", path, errno);
+        return -1;
+    }
+    strcpy(io_fd_path, path);
+    return io_fd;
+}
+
+static esp_err_t io_do_write(const io_req_t *req) {
+    int fd = io_file_get(req->path);
+    if (fd < 0) {
+        atomic_fetch_add_explicit(&stat_errors, 1, memory_order_relaxed);
+        return ESP_FAIL;
+    }
+
+    off_t pos = (req->kind == IO_APPEND) ? lseek(fd, 0, SEEK_END)
+                                         : lseek(fd, (off_t)req->offset, SEEK_SET);
+    size_t written = 0;
+    while (pos >= 0 && written < req->len) {
+        ssize_t n = write(fd, req->data + written, req->len - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += (size_t)n;
+    }
+    atomic_fetch_add_explicit(&stat_writes, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stat_bytes, written, memory_order_relaxed);
+    io_dirty |= written > 0;
+
+    if (written != req->len) {
+        atomic_fetch_add_explicit(&stat_errors, 1, memory_order_relaxed);
+        ESP_LOGE(TAG, "Write to %s failed (errno %d)", req->path, errno);
+        io_file_close();    // Reopened by the next request
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t io_do_barrier(const io_req_t *req) {
+    esp_err_t ret = io_failed ? ESP_FAIL : ESP_OK;
+    io_failed = false;
+    if (req->sync && io_fd >= 0 && io_dirty) {
+        atomic_fetch_add_explicit(&stat_syncs, 1, memory_order_relaxed);
+        if (fsync(io_fd) == 0) {
+            io_dirty = false;
+        } else {
+            atomic_fetch_add_explicit(&stat_errors, 1, memory_order_relaxed);
+            ret = ESP_FAIL;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Carry out one request, release its queue space and complete it
+ */
+static void io_serve(io_req_t *req) {
+    int64_t begin = io_now_us();
+    esp_err_t ret;
+    if (req->kind == IO_BARRIER) {
+        ret = io_do_barrier(req);
+    } else {
+        ret = io_do_write(req);
+        io_failed |= (ret != ESP_OK);
+    }
+    int64_t end = io_now_us();
+
+    io_record_latency(stat_service_hist, &stat_service_max, end - begin);
+    io_record_latency(stat_latency_hist, &stat_latency_max, end - req->submitted_us);
+
+    xSemaphoreTake(io_mutex, portMAX_DELAY);
+    io_queued -= req->len;
+    atomic_store_explicit(&stat_queued, (uint32_t)io_queued, memory_order_relaxed);
+    if (io_space_waiters) {
+        xSemaphoreGive(io_space);
+    }
+    xSemaphoreGive(io_mutex);
+
+    for (uint32_t i = 0; i < req->calls; i++) {
+        req->done(ret, req->user_ctx);
+    }
+    free(req->data);
+    free(req);
+}
+
+/**
+ * @brief I/O task: carries out the queue in order
+ *
+ * Sleeps while the queue is empty and closes (and so saves) an idle file
+ * after IO_IDLE_CLOSE_MS. Once stopped it finishes the queue and exits.
+ */
+static void io_task_func(void *arg) {
+    for (;;) {
+        xSemaphoreTake(io_mutex, portMAX_DELAY);
+        io_req_t *req = io_head;
+        if (req) {
+            io_head = req->next;
+            if (!io_head) io_tail = NULL;
+        } else if (!atomic_load(&io_running)) {
+            io_open = false;
+        }
+        bool open = io_open;
+        xSemaphoreGive(io_mutex);
+
+        if (req) {
+            io_serve(req);
+        } else if (!open) {
+            break;
+        } else if (ulTaskNotifyTake(pdTRUE, (io_fd >= 0) ? pdMS_TO_TICKS(IO_IDLE_CLOSE_MS)
+                                                         : portMAX_DELAY) == 0) {
+            if (io_file_close() != ESP_OK) {
+                io_failed = true;
+            }
+        }
+    }
+
+    io_file_close();
+    xSemaphoreGive(io_space);   // Submitters still waiting see the service closed
+    atomic_store(&io_exited, true);
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// QUEUE
+// ============================================================================
+
+/**
+ * @brief Wait until `len` more bytes fit in the queue (io_mutex held)
+ *
+ * @return false if the service closed meanwhile
+ */
+static bool io_reserve(size_t len) {
+    bool stalled = false;
+    while (io_open && io_queued + len > IO_QUEUE_BYTES) {
+        if (!stalled) {
+            atomic_fetch_add_explicit(&stat_stalls, 1, memory_order_relaxed);
+            stalled = true;
+        }
+        io_space_waiters++;
+        xSemaphoreGive(io_mutex);
+        xSemaphoreTake(io_space, portMAX_DELAY);
+        xSemaphoreTake(io_mutex, portMAX_DELAY);
+        io_space_waiters--;
+        if (io_space_waiters && (!io_open || io_queued < IO_QUEUE_BYTES)) {
+            xSemaphoreGive(io_space);   // Pass the wakeup on
+        }
+    }
+    return io_open;
+}
+
+/**
+ * @brief Append `req` to the queue and wake the I/O task (io_mutex held)
+ */
+static void io_enqueue(io_req_t *req) {
+    if (io_tail) {
+        io_tail->next = req;
+    } else {
+        io_head = req;
+    }
+    io_tail = req;
+    io_queued += req->len;
+    atomic_store_explicit(&stat_queued, (uint32_t)io_queued, memory_order_relaxed);
+    io_store_max(&stat_queued_peak, (uint32_t)io_queued);
+    xTaskNotifyGive(io_task);
+}
+
+/**
+ * @brief Merge a write into the last queued request if it continues it
+ *        (io_mutex held)
+ *
+ * Only the tail can take it, so nothing moves across a barrier or another
+ * file's write. Writes with different callbacks stay apart; with the same
+ * one, each still gets its own call.
+ */
+static bool io_merge(io_kind_t kind, const char *path, uint32_t offset, const void *data,
+                     size_t len, storage_io_done_cb_t done, void *user_ctx) {
+    io_req_t *tail = io_tail;
+    if (!tail || tail->kind != kind ||
+        (tail->done && done && (tail->done != done || tail->user_ctx != user_ctx)) ||
+        (kind == IO_WRITE_AT && tail->offset + tail->len != offset) ||
+        strcmp(tail->path, path) != 0) {
+        return false;
+    }
+
+    if (tail->len + len > tail->capacity) {
+        size_t capacity = tail->capacity * 2;
+        if (capacity < tail->len + len) capacity = tail->len + len;
+        if (capacity > IO_QUEUE_BYTES) capacity = IO_QUEUE_BYTES;
+        uint8_t *grown = (uint8_t*)realloc(tail->data, capacity);
+        if (!grown) return false;
+        tail->data = grown;
+        tail->capacity = capacity;
+    }
+
+    memcpy(tail->data + tail->len, data, len);
+    tail->len += len;
+    if (done) {
+        tail->done = done;
+        tail->user_ctx = user_ctx;
+        tail->calls++;
+    }
+    io_queued += len;
+    atomic_store_explicit(&stat_queued, (uint32_t)io_queued, memory_order_relaxed);
+    io_store_max(&stat_queued_peak, (uint32_t)io_queued);
+    atomic_fetch_add_explicit(&stat_coalesced, 1, memory_order_relaxed);
+    return true;
+}
+
+static esp_err_t io_submit_write(io_kind_t kind, const char *path, uint32_t offset,
+                                 const void *data, size_t len,
+                                 storage_io_done_cb_t done, void *user_ctx) {
+    if (!path || !data || len == 0 || strlen(path) >= STORAGE_IO_PATH_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > IO_QUEUE_BYTES) return ESP_ERR_INVALID_SIZE;
+    if (!io_mutex) return ESP_ERR_INVALID_STATE;
+
+    atomic_fetch_add_explicit(&stat_requests, 1, memory_order_relaxed);
+    int64_t now = io_now_us();
+
+    xSemaphoreTake(io_mutex, portMAX_DELAY);
+    if (!io_reserve(len)) {
+        xSemaphoreGive(io_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (io_merge(kind, path, offset, data, len, done, user_ctx)) {
+        xSemaphoreGive(io_mutex);
+        return ESP_OK;
+    }
+    xSemaphoreGive(io_mutex);
+
+    // A new request: allocate and copy without holding the queue
+    io_req_t *req = (io_req_t*)calloc(1, sizeof(io_req_t));
+    uint8_t *copy = (uint8_t*)malloc(len);
+    if (!req || !copy) {
+        free(req);
+        free(copy);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, data, len);
+    req->kind = kind;
+    req->offset = offset;
+    req->data = copy;
+    req->len = len;
+    req->capacity = len;
+    req->done = done;
+    req->user_ctx = user_ctx;
+    req->calls = done ? 1 : 0;
+    req->submitted_us = now;
+    strcpy(req->path, path);
+
+    xSemaphoreTake(io_mutex, portMAX_DELAY);
+    if (!io_reserve(len)) {
+        xSemaphoreGive(io_mutex);
+        free(copy);
+        free(req);
+        return ESP_ERR_INVALID_STATE;
+    }
+    io_enqueue(req);
+    xSemaphoreGive(io_mutex);
+    return ESP_OK;
+}
+
+static void io_drain_done(esp_err_t result, void *user_ctx) {
+    io_waiter_t *waiter = (io_waiter_t*)user_ctx;
+    waiter->result = result;
+    xSemaphoreGive(waiter->done);
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+esp_err_t storage_io_init(void) {
+    if (io_task) return ESP_OK;
+
+    io_mutex = xSemaphoreCreateMutex();
+    io_space = xSemaphoreCreateBinary();
+    if (!io_mutex || !io_space) {
+        storage_io_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+
+    io_open = true;
+    atomic_store(&io_running, true);
+    atomic_store(&io_exited, false);
+    if (xTaskCreatePinnedToCore(io_task_func, "storage_io", IO_TASK_STACK, NULL,
+                                IO_TASK_PRIORITY, &io_task, IO_TASK_CORE) != pdPASS) {
+        io_task = NULL;
+        storage_io_deinit();
+        ESP_LOGE(TAG, "Failed to create I/O task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void storage_io_deinit(void) {
+    if (io_task) {
+        atomic_store(&io_running, false);
+        xTaskNotifyGive(io_task);
+        while (!atomic_load(&io_exited)) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        io_task = NULL;
+    }
+
+    if (io_mutex) {
+        vSemaphoreDelete(io_mutex);
+        io_mutex = NULL;
+    }
+    if (io_space) {
+        vSemaphoreDelete(io_space);
+        io_space = NULL;
+    }
+    io_open = false;
+}
+
+esp_err_t storage_io_append(const char *path, const void *data, size_t len,
+                            storage_io_done_cb_t done, void *user_ctx) {
+    return io_submit_write(IO_APPEND, path, 0, data, len, done, user_ctx);
+}
+
+esp_err_t storage_io_write_at(const char *path, uint32_t offset, const void *data, size_t len,
+                              storage_io_done_cb_t done, void *user_ctx) {
+    return io_submit_write(IO_WRITE_AT, path, offset, data, len, done, user_ctx);
+}
+
+esp_err_t storage_io_barrier(bool sync, storage_io_done_cb_t done, void *user_ctx) {
+    if (!io_mutex) return ESP_ERR_INVALID_STATE;
+
+    io_req_t *req = (io_req_t*)calloc(1, sizeof(io_req_t));
+    if (!req) return ESP_ERR_NO_MEM;
+    req->kind = IO_BARRIER;
+    req->sync = sync;
+    req->done = done;
+    req->user_ctx = user_ctx;
+    req->calls = done ? 1 : 0;
+    req->submitted_us = io_now_us();
+    atomic_fetch_add_explicit(&stat_requests, 1, memory_order_relaxed);
+
+    xSemaphoreTake(io_mutex, portMAX_DELAY);
+    bool open = io_open;
+    if (open) {
+        io_enqueue(req);
+    }
+    xSemaphoreGive(io_mutex);
+
+    if (!open) {
+        free(req);
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t storage_io_drain(bool sync) {
+    if (storage_io_in_service_task()) return ESP_ERR_INVALID_STATE;
+
+    io_waiter_t waiter = { .done = xSemaphoreCreateBinary(), .result = ESP_FAIL };
+    if (!waiter.done) return ESP_ERR_NO_MEM;
+
+    esp_err_t ret = storage_io_barrier(sync, io_drain_done, &waiter);
+    if (ret == ESP_OK) {
+        xSemaphoreTake(waiter.done, portMAX_DELAY);
+        ret = waiter.result;
+    }
+    vSemaphoreDelete(waiter.done);
+    return ret;
+}
+
+bool storage_io_in_service_task(void) {
+    return io_task && xTaskGetCurrentTaskHandle() == io_task;
+}
+
+void storage_io_get_stats(storage_io_stats_t *stats) {
+    if (!stats) return;
+
+    stats->requests = atomic_load_explicit(&stat_requests, memory_order_relaxed);
+    stats->coalesced = atomic_load_explicit(&stat_coalesced, memory_order_relaxed);
+    stats->writes = atomic_load_explicit(&stat_writes, memory_order_relaxed);
+    stats->syncs = atomic_load_explicit(&stat_syncs, memory_order_relaxed);
+    stats->errors = atomic_load_explicit(&stat_errors, memory_order_relaxed);
+    stats->stalls = atomic_load_explicit(&stat_stalls, memory_order_relaxed);
+    stats->bytes = atomic_load_explicit(&stat_bytes, memory_order_relaxed);
+    stats->queued_bytes = atomic_load_explicit(&stat_queued, memory_order_relaxed);
+    stats->queued_peak = atomic_load_explicit(&stat_queued_peak, memory_order_relaxed);
+    for (int i = 0; i < STORAGE_IO_STATS_BUCKETS; i++) {
+        stats->latency_us_hist[i] = atomic_load_explicit(&stat_latency_hist[i],
+                                                         memory_order_relaxed);
+        stats->service_us_hist[i] = atomic_load_explicit(&stat_service_hist[i],
+                                                         memory_order_relaxed);
+    }
+    stats->latency_us_max = atomic_load_explicit(&stat_latency_max, memory_order_relaxed);
+    stats->service_us_max = atomic_load_explicit(&stat_service_max, memory_order_relaxed);
+}
@@ -0,0 +1,441 @@
+#include "storage_settings.h"
+#include "storage_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#define SETTINGS_PATH      "storage/settings.bin"     // Relative to the working directory
+#else
+#define SETTINGS_PATH      "/storage/settings.bin"
+#endif
+
+#define SETTINGS_MAGIC     0x474E5453u   // "STNG" in file byte order
+#define SETTINGS_VERSION   1
+#define SETTINGS_SLOT_SIZE 2048          // Bytes per slot; the file holds two
+#define DEBOUNCE_MS        CONFIG_STORAGE_SETTINGS_DEBOUNCE_MS
+#define MAX_DELAY_MS       CONFIG_STORAGE_SETTINGS_MAX_DELAY_MS
+#define SETTINGS_TASK_STACK    3072
+#define SETTINGS_TASK_PRIORITY 1         // Low, like the storage I/O task
+
+static const char *TAG = "settings";
+
+typedef enum {
+    SETTING_FREE = 0,
+    SETTING_U32,
+    SETTING_I32,
+    SETTING_STR,
+} setting_type_t;
+
+/**
+ * @brief One setting, as cached and as stored
+ */
+typedef struct {
+    char key[STORAGE_SETTINGS_KEY_MAX];
+    uint8_t type;                            ///< setting_type_t
+    uint8_t reserved[3];
+    union {
+        uint32_t u32;
+        int32_t i32;
+        char str[STORAGE_SETTINGS_STR_MAX];
+    } value;
+} setting_t;
+
+/**
+ * @brief Slot header, followed by `count` packed settings
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t sequence;       ///< Commit number, the newer slot wins (modulo 2^32)
+    uint32_t crc32;          ///< Over the fields above and the settings
+} settings_hdr_t;
+
+_Static_assert(sizeof(settings_hdr_t) + STORAGE_SETTINGS_MAX_KEYS * sizeof(setting_t)
+               <= SETTINGS_SLOT_SIZE, "settings slot too small");
+
+// ============================================================================
+// STATIC VARIABLES
+// ============================================================================
+
+// Guarded by settings_mutex
+static SemaphoreHandle_t settings_mutex;
+static TaskHandle_t settings_task;           ///< Debounces, runs settings_commit_start()
+static setting_t settings_table[STORAGE_SETTINGS_MAX_KEYS];
+static bool settings_dirty;                  ///< Cache differs from the newest commit
+static TickType_t settings_dirty_since;      ///< First change since the last commit started
+static TickType_t settings_changed_at;       ///< Latest change
+static bool settings_committing;             ///< A commit is queued (owns settings_buf)
+static bool settings_stored;                 ///< settings_slot holds a valid commit
+static uint32_t settings_slot;               ///< Slot of the newest valid commit
+static uint32_t settings_sequence;           ///< Its sequence number
+static uint8_t settings_buf[SETTINGS_SLOT_SIZE];   ///< Slot image of the queued commit
+
+// ============================================================================
+// SLOT FORMAT
+// ============================================================================
+
+static uint32_t slot_crc(const settings_hdr_t *hdr, const setting_t *entries) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)hdr, offsetof(settings_hdr_t, crc32));
+    return esp_rom_crc32_le(crc, (const uint8_t*)entries, hdr->count * sizeof(setting_t));
+}
+
+/**
+ * @brief Whether `slot` (SETTINGS_SLOT_SIZE bytes) holds an intact commit
+ */
+static bool slot_valid(const uint8_t *slot, settings_hdr_t *hdr) {
+    memcpy(hdr, slot, sizeof(*hdr));
+    return hdr->magic == SETTINGS_MAGIC && hdr->version == SETTINGS_VERSION &&
+           hdr->count <= STORAGE_SETTINGS_MAX_KEYS &&
+           hdr->crc32 == slot_crc(hdr, (const setting_t*)(slot + sizeof(*hdr)));
+}
+
+/**
+ * @brief Render the cache as a slot image in settings_buf (mutex held)
+ */
+static void slot_build(uint32_t sequence) {
+    memset(settings_buf, 0xFF, sizeof(settings_buf));
+    setting_t *entries = (setting_t*)(settings_buf + sizeof(settings_hdr_t));
+    uint16_t count = 0;
+    for (int i = 0; i < STORAGE_SETTINGS_MAX_KEYS; i++) {
+        if (settings_table[i].type != SETTING_FREE) {
+            entries[count++] = settings_table[i];
+        }
+    }
+
+    settings_hdr_t hdr = {
+        .magic = SETTINGS_MAGIC,
+        .version = SETTINGS_VERSION,
+        .count = count,
+        .sequence = sequence,
+    };
+    hdr.crc32 = slot_crc(&hdr, entries);
+    memcpy(settings_buf, &hdr, sizeof(hdr));
+}
+
+// ============================================================================
+// COMMITS
+// ============================================================================
+
+/**
+ * @brief Note a change (mutex held)
+ *
+ * Restarts the debounce; the first change since the last commit started
+ * also starts the MAX_DELAY_MS clock.
+ */
+static void settings_mark_dirty(void) {
+    TickType_t now = xTaskGetTickCount();
+    if (!settings_dirty) {
+        settings_dirty = true;
+        settings_dirty_since = now;
+    }
+    settings_changed_at = now;
+}
+
+/**
+ * @brief Barrier callback of a commit (storage I/O task)
+ *
+ * A failed commit leaves the other slot as it was; the changes stay
+ * dirty and are retried after the debounce.
+ */
+static void settings_commit_done(esp_err_t result, void *user_ctx) {
+    uint32_t slot = (uint32_t)(uintptr_t)user_ctx;
+
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    settings_committing = false;
+    if (result == ESP_OK) {
+        settings_stored = true;
+        settings_slot = slot;
+        settings_sequence++;
+    } else {
+        settings_dirty = false;
+        settings_mark_dirty();
+    }
+    bool again = settings_dirty;
+    xSemaphoreGive(settings_mutex);
+
+    if (result != ESP_OK) {
+        ESP_LOGW(TAG, "Commit to %s failed, retrying", SETTINGS_PATH);
+    }
+    if (again) {
+        // Changed while this commit was queued (or a retry)
+        xTaskNotifyGive(settings_task);
+    }
+}
+
+/**
+ * @brief Queue a commit of the cache to the older slot
+ *
+ * The slot image is written and fsynced through the storage I/O service.
+ * Submitting may wait for queue space, so this runs on the settings task
+ * or a caller of storage_settings_commit().
+ * Does nothing if the cache is clean or a commit is still queued (its
+ * callback wakes the settings task).
+ */
+static void settings_commit_start(void) {
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    if (!settings_dirty || settings_committing) {
+        xSemaphoreGive(settings_mutex);
+        return;
+    }
+    uint32_t slot = settings_stored ? 1 - settings_slot : 0;
+    slot_build(settings_sequence + 1);
+    settings_dirty = false;
+    settings_committing = true;
+    xSemaphoreGive(settings_mutex);
+
+    // Never submit with the mutex held: the I/O task takes it in the callback
+    esp_err_t ret = storage_io_write_at(SETTINGS_PATH, slot * SETTINGS_SLOT_SIZE, settings_buf,
+                                        SETTINGS_SLOT_SIZE, NULL, NULL);
+    if (ret == ESP_OK) {
+        ret = storage_io_barrier(true, settings_commit_done, (void*)(uintptr_t)slot);
+    }
+    if (ret != ESP_OK) {
+        xSemaphoreTake(settings_mutex, portMAX_DELAY);
+        settings_committing = false;
+        settings_mark_dirty();      // Retried after the debounce
+        xSemaphoreGive(settings_mutex);
+        ESP_LOGW(TAG, "Commit not queued (%s)", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief Settings task: starts a commit once the changes settle
+ *
+ * Sleeps while the cache is clean. Each change wakes it to push the
+ * commit back to DEBOUNCE_MS after the latest change, but never past
+ * MAX_DELAY_MS after the first.
+ */
+static void settings_task_func(void *arg) {
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        xSemaphoreTake(settings_mutex, portMAX_DELAY);
+        if (settings_dirty && !settings_committing) {
+            TickType_t now = xTaskGetTickCount();
+            TickType_t quiet = now - settings_changed_at;
+            TickType_t waited = now - settings_dirty_since;
+            TickType_t debounce = (quiet < pdMS_TO_TICKS(DEBOUNCE_MS))
+                                  ? pdMS_TO_TICKS(DEBOUNCE_MS) - quiet : 0;
+            TickType_t limit = (waited < pdMS_TO_TICKS(MAX_DELAY_MS))
+                               ? pdMS_TO_TICKS(MAX_DELAY_MS) - waited : 0;
+            wait = (debounce < limit) ? debounce : limit;
+        }
+        xSemaphoreGive(settings_mutex);
+
+        if (wait == 0) {
+            settings_commit_start();
+        } else {
+            ulTaskNotifyTake(pdTRUE, wait);
+        }
+    }
+}
+
+// ============================================================================
+// CACHE
+// ============================================================================
+
+/**
+ * @brief Cached setting `key`, NULL if absent (mutex held)
+ */
+static setting_t *settings_find(const char *key) {
+    for (int i = 0; i < STORAGE_SETTINGS_MAX_KEYS; i++) {
+        if (settings_table[i].type != SETTING_FREE &&
+            strncmp(settings_table[i].key, key, STORAGE_SETTINGS_KEY_MAX) == 0) {
+            return &settings_table[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Copy setting `key` of `type` out of the cache
+ */
+static esp_err_t settings_get(const char *key, setting_type_t type, setting_t *out) {
+    if (!key || !out) return ESP_ERR_INVALID_ARG;
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    setting_t *setting = settings_find(key);
+    esp_err_t ret = !setting ? ESP_ERR_NOT_FOUND
+                  : (setting->type != type) ? ESP_ERR_INVALID_ARG : ESP_OK;
+    if (ret == ESP_OK) {
+        *out = *setting;
+    }
+    xSemaphoreGive(settings_mutex);
+    return ret;
+}
+
+/**
+ * @brief Store `value` under `key`, scheduling a commit if anything changed
+ */
+static esp_err_t settings_set(const char *key, const setting_t *value) {
+    if (!key || strnlen(key, STORAGE_SETTINGS_KEY_MAX) >= STORAGE_SETTINGS_KEY_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    setting_t *setting = settings_find(key);
+    for (int i = 0; !setting && i < STORAGE_SETTINGS_MAX_KEYS; i++) {
+        if (settings_table[i].type == SETTING_FREE) {
+            setting = &settings_table[i];
+        }
+    }
+
+    esp_err_t ret = setting ? ESP_OK : ESP_ERR_NO_MEM;
+    if (setting && (setting->type != value->type ||
+                    memcmp(&setting->value, &value->value, sizeof(value->value)) != 0)) {
+        memset(setting, 0, sizeof(*setting));
+        strcpy(setting->key, key);
+        setting->type = value->type;
+        setting->value = value->value;
+        settings_mark_dirty();
+        xTaskNotifyGive(settings_task);
+    }
+    xSemaphoreGive(settings_mutex);
+    return ret;
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+esp_err_t storage_settings_init(void) {
+    if (settings_mutex) return ESP_OK;
+
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    uint8_t *file = (uint8_t*)malloc(2 * SETTINGS_SLOT_SIZE);
+    if (!mutex || !file) {
+        if (mutex) vSemaphoreDelete(mutex);
+        free(file);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Both slots in one read; the newest intact one wins
+    size_t length = 0;
+    FILE *f = fopen(SETTINGS_PATH, "rb");
+    if (f) {
+        length = fread(file, 1, 2 * SETTINGS_SLOT_SIZE, f);
+        fclose(f);
+    }
+
+    settings_hdr_t hdr;
+    for (uint32_t slot = 0; slot < 2; slot++) {
+        if (length < (slot + 1) * SETTINGS_SLOT_SIZE ||
+            !slot_valid(file + slot * SETTINGS_SLOT_SIZE, &hdr) ||
+            (settings_stored && (int32_t)(hdr.sequence - settings_sequence) <= 0)) {
+            continue;
+        }
+        memset(settings_table, 0, sizeof(settings_table));
+        memcpy(settings_table, file + slot * SETTINGS_SLOT_SIZE + sizeof(hdr),
+               hdr.count * sizeof(setting_t));
+        settings_stored = true;
+        settings_slot = slot;
+        settings_sequence = hdr.sequence;
+    }
+    free(file);
+
+    // The cache is clean, so the task sleeps until the first change
+    settings_mutex = mutex;
+    if (xTaskCreate(settings_task_func, "settings", SETTINGS_TASK_STACK, NULL,
+                    SETTINGS_TASK_PRIORITY, &settings_task) != pdPASS) {
+        settings_task = NULL;
+        settings_mutex = NULL;
+        vSemaphoreDelete(mutex);
+        ESP_LOGE(TAG, "Failed to create settings task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (settings_stored) {
+        ESP_LOGI(TAG, "Loaded settings (slot %u, commit %u)", (unsigned)settings_slot,
+                 (unsigned)settings_sequence);
+    } else {
+        ESP_LOGI(TAG, "No stored settings, starting empty");
+    }
+    return ESP_OK;
+}
+
+esp_err_t storage_settings_get_u32(const char *key, uint32_t *value) {
+    setting_t setting;
+    esp_err_t ret = value ? settings_get(key, SETTING_U32, &setting) : ESP_ERR_INVALID_ARG;
+    if (ret == ESP_OK) *value = setting.value.u32;
+    return ret;
+}
+
+esp_err_t storage_settings_get_i32(const char *key, int32_t *value) {
+    setting_t setting;
+    esp_err_t ret = value ? settings_get(key, SETTING_I32, &setting) : ESP_ERR_INVALID_ARG;
+    if (ret == ESP_OK) *value = setting.value.i32;
+    return ret;
+}
+
+esp_err_t storage_settings_get_str(const char *key, char *buf, size_t len) {
+    setting_t setting;
+    esp_err_t ret = (buf && len) ? settings_get(key, SETTING_STR, &setting) : ESP_ERR_INVALID_ARG;
+    if (ret != ESP_OK) return ret;
+    if (strlen(setting.value.str) >= len) return ESP_ERR_INVALID_SIZE;
+    strcpy(buf, setting.value.str);
+    return ESP_OK;
+}
+
+esp_err_t storage_settings_set_u32(const char *key, uint32_t value) {
+    setting_t setting = { .type = SETTING_U32, .value.u32 = value };
+    return settings_set(key, &setting);
+}
+
+esp_err_t storage_settings_set_i32(const char *key, int32_t value) {
+    setting_t setting = { .type = SETTING_I32, .value.i32 = value };
+    return settings_set(key, &setting);
+}
+
+esp_err_t storage_settings_set_str(const char *key, const char *value) {
+    if (!value) return ESP_ERR_INVALID_ARG;
+    if (strnlen(value, STORAGE_SETTINGS_STR_MAX) >= STORAGE_SETTINGS_STR_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    setting_t setting = { .type = SETTING_STR };
+    strcpy(setting.value.str, value);
+    return settings_set(key, &setting);
+}
+
+esp_err_t storage_settings_erase(const char *key) {
+    if (!key) return ESP_ERR_INVALID_ARG;
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+    setting_t *setting = settings_find(key);
+    if (setting) {
+        memset(setting, 0, sizeof(*setting));
+        settings_mark_dirty();
+        xTaskNotifyGive(settings_task);
+    }
+    xSemaphoreGive(settings_mutex);
+    return setting ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t storage_settings_commit(void) {
+    if (!settings_mutex) return ESP_ERR_INVALID_STATE;
+
+    // A commit already queued may predate the latest changes: then a
+    // second one follows once it is done
+    bool pending = true;
+    for (int pass = 0; pass < 2 && pending; pass++) {
+        settings_commit_start();
+        esp_err_t ret = storage_io_drain(false);   // Queued after the commit's barrier
+        if (ret == ESP_ERR_INVALID_STATE || ret == ESP_ERR_NO_MEM) return ESP_FAIL;
+
+        xSemaphoreTake(settings_mutex, portMAX_DELAY);
+        pending = settings_dirty || settings_committing;
+        xSemaphoreGive(settings_mutex);
+    }
+    return pending ? ESP_FAIL : ESP_OK;
+}
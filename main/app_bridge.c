@@ -2,29 +2,33 @@
 #include "dlogger.h"
 #include <string.h>
 #include <stdio.h>
-#include <stdlib.h>
 
 // ============================================================================
 // STATIC HELPERS - MINIMAL STACK USAGE
 // ============================================================================
 
 /**
- * @brief Check if raw log passes filter (minimal stack)
+ * @brief Translate the UI filter string into a dlogger filter (once per read)
+ * 
+ * dlogger applies it inside the ring walk, so entries of other sources are
+ * never formatted and do not use up `max_logs`.
  */
-static bool log_passes_filter(const dlogger_entry_t *raw, const char *filter) {
+static dlogger_filter_t filter_from_string(const char *filter) {
+    dlogger_filter_t f = DLOGGER_FILTER_ALL;
     if (!filter || strcmp(filter, "ALL") == 0) {
-        return true;
+        return f;
     }
     
-    // Convert source to string without function call overhead
-    const char* source_str = "?";
-    switch(raw->source) {
-        case LOG_SOURCE_ESP:  source_str = "ESP"; break;
-        case LOG_SOURCE_LVGL: source_str = "LVGL"; break;
-        case LOG_SOURCE_USER: source_str = "USER"; break;
+    if (strcmp(filter, "ESP") == 0) {
+        f.source_mask = DLOGGER_SOURCE_BIT(LOG_SOURCE_ESP);
+    } else if (strcmp(filter, "LVGL") == 0) {
+        f.source_mask = DLOGGER_SOURCE_BIT(LOG_SOURCE_LVGL);
+    } else if (strcmp(filter, "USER") == 0) {
+        f.source_mask = DLOGGER_SOURCE_BIT(LOG_SOURCE_USER);
+    } else {
+        f.source_mask = 0;      // Unknown source: nothing matches
     }
-    
-    return (strcmp(filter, source_str) == 0);
+    return f;
 }
 
 /**
@@ -69,6 +73,43 @@ static void clean_message_inplace(char *msg) {
     }
 }
 
+/**
+ * @brief Destination state for format_span_cb
+ */
+typedef struct {
+    formatted_log_entry_t *logs;
+    size_t max_logs;
+    size_t count;
+} format_ctx_t;
+
+/**
+ * @brief Format one span straight from the dlogger ring (no raw copy)
+ */
+static bool format_span_cb(const dlogger_span_t *span, void *user_ctx) {
+    format_ctx_t *ctx = (format_ctx_t *)user_ctx;
+    formatted_log_entry_t *fmt = &ctx->logs[ctx->count];
+    fmt->seq = span->seq;
+    
+    // Format timestamp
+    format_timestamp(span->timestamp, fmt->timestamp);
+    
+    // Format source and level
+    format_source(span->source, fmt->source);
+    format_level(span->level, fmt->level);
+    
+    // Copy and clean message (spans are not null-terminated)
+    size_t len = span->length;
+    if (len > sizeof(fmt->message) - 1) {
+        len = sizeof(fmt->message) - 1;
+    }
+    memcpy(fmt->message, span->message, len);
+    fmt->message[len] = '\0';
+    clean_message_inplace(fmt->message);
+    
+    ctx->count++;
+    return ctx->count < ctx->max_logs;
+}
+
 // ============================================================================
 // PUBLIC API - MINIMAL STACK VERSION
 // ============================================================================
@@ -78,45 +119,44 @@ size_t app_bridge_get_formatted_logs(formatted_log_entry_t *logs,
 {
     if (!logs || max_logs == 0) return 0;
     
-    // Allocate buffer for raw logs
-    dlogger_entry_t *raw_logs = (dlogger_entry_t*)malloc(
-        max_logs * sizeof(dlogger_entry_t));
-    
-    if (!raw_logs) return 0;
+    // Visit the newest matching entries in place (reverse chronological
+    // order); no intermediate array of raw entries is allocated
+    dlogger_filter_t f = filter_from_string(filter);
+    format_ctx_t ctx = {
+        .logs = logs,
+        .max_logs = max_logs,
+        .count = 0,
+    };
+    dlogger_read_spans_filtered(&f, max_logs, format_span_cb, &ctx);
     
-    // Get raw logs from dlogger (already in reverse chronological order)
-    size_t raw_count = dlogger_get_raw_entries(raw_logs, max_logs);
-    size_t formatted_count = 0;
+    return ctx.count;
+}
+
+size_t app_bridge_get_new_logs(app_bridge_log_cursor_t *cursor,
+                               formatted_log_entry_t *logs,
+                               size_t max_logs,
+                               const char *filter)
+{
+    if (!cursor || !logs || max_logs == 0) return 0;
     
-    // Process each raw log
-    for (size_t i = 0; i < raw_count && formatted_count < max_logs; i++) {
-        const dlogger_entry_t *raw = &raw_logs[i];
-        
-        // Apply filter
-        if (!log_passes_filter(raw, filter)) {
-            continue;
-        }
-        
-        // Format the log entry
-        formatted_log_entry_t *fmt = &logs[formatted_count];
-        
-        // Format timestamp
-        format_timestamp(raw->timestamp, fmt->timestamp);
-        
-        // Format source and level
-        format_source(raw->source, fmt->source);
-        format_level(raw->level, fmt->level);
-        
-        // Copy and clean message
-        strncpy(fmt->message, raw->message, sizeof(fmt->message) - 1);
-        fmt->message[sizeof(fmt->message) - 1] = '\0';
-        clean_message_inplace(fmt->message);
-        
-        formatted_count++;
-    }
+    // Only entries committed since the last refresh are formatted
+    dlogger_cursor_t dl = {
+        .seq = cursor->last_seq,
+    };
+    _Static_assert(sizeof(dl.priv) == sizeof(cursor->priv), "Cursor layouts differ");
+    memcpy(dl.priv, cursor->priv, sizeof(dl.priv));
+    dlogger_filter_t f = filter_from_string(filter);
+    format_ctx_t ctx = {
+        .logs = logs,
+        .max_logs = max_logs,
+        .count = 0,
+    };
+    dlogger_read_since(&dl, &f, max_logs, format_span_cb, &ctx);
     
-    free(raw_logs);
-    return formatted_count;
+    cursor->last_seq = dl.seq;
+    cursor->reset = dl.gap;
+    memcpy(cursor->priv, dl.priv, sizeof(cursor->priv));
+    return ctx.count;
 }
 
 void app_bridge_init(void)
@@ -2,6 +2,8 @@
 #define APP_BRIDGE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,12 +22,24 @@ extern "C" {
  * All data transformation happens in the bridge.
  */
 typedef struct {
+    uint32_t seq;        // Entry sequence number (stable row identity)
     char timestamp[16];  // Formatted: "12345678"
     char source[8];      // Formatted: "ESP", "LVGL", "USER"
     char level[2];       // Formatted: "E", "W", "I", "D"
     char message[100];   // Truncated/cleaned message
 } formatted_log_entry_t;
 
+/**
+ * @brief Position of a log view in the log stream (see app_bridge_get_new_logs())
+ * 
+ * Zero-initialize before the first call.
+ */
+typedef struct {
+    uint32_t last_seq;   // Sequence number of the newest row returned so far
+    bool reset;          // Rows were missed: clear the table before appending
+    uint32_t priv[4];    // Data layer read position, do not modify
+} app_bridge_log_cursor_t;
+
 // ============================================================================
 // BRIDGE LAYER APIs - DATA TRANSFORMATION ONLY
 // ============================================================================
@@ -53,6 +67,25 @@ size_t app_bridge_get_formatted_logs(formatted_log_entry_t *logs,
                                      size_t max_logs, 
                                      const char *filter);
 
+/**
+ * @brief Get only the logs added since the previous call (oldest first)
+ * 
+ * Lets a log view append rows instead of rebuilding its table on every
+ * refresh; nothing is allocated. When `cursor->reset` is set on return,
+ * rows were missed (overwritten, or more than `max_logs` new ones) and the
+ * view should clear its table before appending the returned rows.
+ * 
+ * @param cursor View position, updated on return
+ * @param logs Destination array for formatted logs
+ * @param max_logs Maximum number of logs to return
+ * @param filter Filter string ("ALL", "ESP", "LVGL", "USER")
+ * @return Number of logs actually returned
+ */
+size_t app_bridge_get_new_logs(app_bridge_log_cursor_t *cursor,
+                               formatted_log_entry_t *logs,
+                               size_t max_logs,
+                               const char *filter);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,6 +2,7 @@
 #include "bsp/display.h"
 #include "minigui.h"
 #include "storage.h"
+#include "storage_settings.h"
 #include "dlogger.h"
 #include "app_bridge.h"
 #include "esp_log.h"
@@ -26,11 +27,20 @@ static void lvgl_log_handler(lv_log_level_t lvgl_level, const char *buf) {
         log_level = LOG_LEVEL_DEBUG;
     }
     
-    dlogger_add_entry(LOG_SOURCE_LVGL, log_level, buf);
+    // Write the message once, straight into the log ring
+    size_t len = strnlen(buf, DLOGGER_MESSAGE_MAX);
+    dlogger_reservation_t resv;
+    char *dst = dlogger_reserve(LOG_SOURCE_LVGL, log_level, len, &resv);
+    if (dst) {
+        memcpy(dst, buf, len);
+        dlogger_commit(&resv, len);
+    }
 }
 
 static void brightness_wrapper(uint8_t val) {
     bsp_display_brightness_set(val);
+    /* Cached only; committed once the slider has settled */
+    storage_settings_set_u32("brightness", val);
 }
 
 void app_main(void)
@@ -49,6 +59,12 @@ void app_main(void)
 
     /* Initialize display hardware via BSP */
     bsp_display_start();
+
+    /* Restore the brightness saved from the settings screen */
+    uint32_t brightness;
+    if (storage_settings_get_u32("brightness", &brightness) == ESP_OK) {
+        bsp_display_brightness_set((int)brightness);
+    }
     
     /* Re-hook LVGL logs after BSP initialization (BSP might override) */
     lv_log_register_print_cb(lvgl_log_handler);